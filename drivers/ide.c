@@ -1,5 +1,9 @@
+#include "ide.h"
 #include "../io/io.h"
 #include "terminal.h"
+#include "timer.h"
+#include "../src/waitqueue.h"
+#include "../src/trace.h"
 #include <stdint.h>
 
 // Define primary IDE controller I/O ports
@@ -12,6 +16,7 @@
 #define IDE_DRIVE_HEAD_REG          0x1F6
 #define IDE_STATUS_REG              0x1F7
 #define IDE_COMMAND_REG             0x1F7
+#define IDE_CONTROL_REG             0x3F6
 
 // Status Register Bits
 #define IDE_STATUS_BSY              0x80
@@ -19,10 +24,20 @@
 #define IDE_STATUS_DRQ              0x08
 #define IDE_STATUS_ERR              0x01
 
+// How long the drive may stay busy before we give up on it
+#define IDE_TIMEOUT_NS              (500 * 1000 * 1000ull)
+#define IDE_TIMEOUT_MS              500
+
 // Commands
 #define IDE_CMD_READ_SECTORS        0x20
 #define IDE_CMD_WRITE_SECTORS       0x30
 
+// IRQ 14 state: the drive interrupts whenever a sector is ready to be read,
+// or has been taken after a write
+static wait_queue_t ide_wait = WAIT_QUEUE_INIT;
+static volatile bool ide_irq_pending = false;
+static bool ide_irq_enabled = false;
+
 // Helper func for the 400ns delay
 static void ide_400ns_delay() {
     // Reading the status port 4 times should be enough
@@ -34,19 +49,50 @@ static void ide_400ns_delay() {
 
 // Poll the IDE controller until its no longer busy
 static int ide_poll() {
-    // Add a timeout counter
-    for(int i = 0; i < 100000; i++) {
+    // Time-based timeout, so it means the same on fast and slow CPUs
+    uint64_t deadline = ktime_ns() + IDE_TIMEOUT_NS;
+    do {
         if (!(inb(IDE_STATUS_REG) & IDE_STATUS_BSY)) {
             return 0; // Success!
         }
-    }
+    } while (ktime_ns() < deadline);
     // If the loop finishes, we timed out
     return -1;
 }
 
+static bool ide_irq_seen(void* arg) {
+    (void)arg;
+    return ide_irq_pending;
+}
+
+// Waits for the drive to finish its current step. Threads sleep until
+// IRQ 14; at boot, with interrupts off, or without the IRQ we poll.
+static int ide_wait_ready() {
+    if (ide_irq_enabled && wait_can_sleep()) {
+        // On a timeout the poll below reports it
+        wait_event(&ide_wait, ide_irq_seen, NULL, IDE_TIMEOUT_MS);
+        ide_irq_pending = false;
+    }
+    // Confirms BSY is clear: immediate after the IRQ, and it also covers
+    // an IRQ consumed by an earlier polled step
+    return ide_poll();
+}
+
+void ide_init(void) {
+    outb(IDE_CONTROL_REG, 0x00); // Clear nIEN: interrupt after each sector
+    ide_irq_enabled = true;
+}
+
+void ide_irq_handler(void) {
+    inb(IDE_STATUS_REG); // Reading the status acknowledges the interrupt
+    ide_irq_pending = true;
+    wait_queue_wake(&ide_wait);
+}
+
 // Reads 'count' sectors from LBA into the buffer 'buf'
 // Assumes buf is a valid ptr to a large enough memory area
-void ide_read_sectors(uint32_t lba, uint8_t count, uint8_t* buf) {
+// Returns false if the drive failed or timed out.
+static bool ide_pio_read(uint32_t lba, uint8_t count, uint8_t* buf) {
     ide_poll(); // Wait for drive to be ready
 
     // 1. Send the drive and LBA bits 24-27
@@ -62,6 +108,7 @@ void ide_read_sectors(uint32_t lba, uint8_t count, uint8_t* buf) {
     outb(IDE_LBA_HI_REG, (uint8_t)(lba >> 16));
 
     // 4. Send the read sectors command
+    ide_irq_pending = false;
     outb(IDE_COMMAND_REG, IDE_CMD_READ_SECTORS);
 
     // 5. Read the data from the disk
@@ -69,8 +116,9 @@ void ide_read_sectors(uint32_t lba, uint8_t count, uint8_t* buf) {
     for(int i = 0; i < count; i++) {
         // --- CORRECTED POLLING LOGIC ---
         // 1. Wait for the drive to not be busy.
-        while (inb(IDE_STATUS_REG) & IDE_STATUS_BSY) {
-            // Wait
+        if (ide_wait_ready() != 0) {
+            terminal_writeerror("IDE Read Timeout!\n");
+            return false;
         }
 
         // 2. Check for errors or if data is ready.
@@ -78,12 +126,12 @@ void ide_read_sectors(uint32_t lba, uint8_t count, uint8_t* buf) {
         if (status & IDE_STATUS_ERR) {
             terminal_writeerror("IDE Read Error!\n");
             // Handle error...
-            return;
+            return false;
         }
         if (!(status & IDE_STATUS_DRQ)) {
             terminal_writeerror("IDE DRQ not set!\n");
             // This is an unexpected state, handle as an error.
-            return;
+            return false;
         }
 
         // Read 256 16-bit words (512 bytes) from the data port
@@ -95,9 +143,10 @@ void ide_read_sectors(uint32_t lba, uint8_t count, uint8_t* buf) {
         ide_400ns_delay();
 
     }
+    return true;
 }
 
-void ide_write_sectors(uint32_t lba, uint8_t count, uint8_t* buf) {
+static bool ide_pio_write(uint32_t lba, uint8_t count, uint8_t* buf) {
     ide_poll();
     outb(IDE_DRIVE_HEAD_REG, 0xE0 | (uint8_t)(lba >> 24));
         outb(IDE_SECTOR_COUNT_REG, count);
@@ -105,13 +154,33 @@ void ide_write_sectors(uint32_t lba, uint8_t count, uint8_t* buf) {
     outb(IDE_LBA_MID_REG, (uint8_t)(lba >> 8));
     outb(IDE_LBA_HI_REG, (uint8_t)(lba >> 16));
     outb(IDE_COMMAND_REG, IDE_CMD_WRITE_SECTORS); // Command 0x30
-    ide_poll();
+    ide_poll(); // The first sector is asked for without an IRQ
 
     uint16_t* ptr = (uint16_t*)buf;
     for (int i = 0; i < count; i++) {
+        ide_irq_pending = false;
         outsw(IDE_DATA_REG, ptr, 256); // Use outsw
         ptr += 256;
+
+        // The drive interrupts once it has taken the sector
+        if (ide_wait_ready() != 0) {
+            terminal_writeerror("IDE Write Timeout!\n");
+            return false;
+        }
     }
 
     // FLUSH COMMAND NEEDED FOR REAL HARDWARE, QEMU IS FINE WITHOUT
+    return true;
+}
+
+void ide_read_sectors(uint32_t lba, uint8_t count, uint8_t* buf) {
+    TRACE(TRACE_IDE_READ, lba, count, 0, 0);
+    bool ok = ide_pio_read(lba, count, buf);
+    TRACE(TRACE_IDE_READ_DONE, lba, count, ok, 0);
+}
+
+void ide_write_sectors(uint32_t lba, uint8_t count, uint8_t* buf) {
+    TRACE(TRACE_IDE_WRITE, lba, count, 0, 0);
+    bool ok = ide_pio_write(lba, count, buf);
+    TRACE(TRACE_IDE_WRITE_DONE, lba, count, ok, 0);
 }
@@ -1,6 +1,15 @@
 #ifndef IDE_H
 #define IDE_H
 
+#include <stdint.h>
+
+// Lets transfers sleep on IRQ 14 instead of polling. Call once the IRQ is
+// routed; until then (and whenever the caller can't sleep) they poll.
+void ide_init(void);
+
+// IRQ 14 handler.
+void ide_irq_handler(void);
+
 void ide_read_sectors(uint32_t lba, uint8_t count, uint8_t* buf);
 void ide_write_sectors(uint32_t lba, uint8_t count, uint8_t* buf);
 #endif
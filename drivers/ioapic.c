@@ -0,0 +1,162 @@
+#include "ioapic.h"
+#include "lapic.h"
+#include "pic.h"
+#include "../src/acpi.h"
+#include "../src/spinlock.h"
+#include "../memory/paging.h"
+
+// Indirect register access: write the index to IOREGSEL, then use IOWIN
+#define IOAPIC_REGSEL       0x00
+#define IOAPIC_WINDOW       0x10
+
+#define IOAPIC_REG_VERSION  0x01    // Bits 16-23: highest redirection entry
+#define IOAPIC_REG_REDIR(n) (0x10 + 2 * (n))
+
+// Redirection entry, low dword
+#define IOAPIC_ACTIVE_LOW   (1 << 13)
+#define IOAPIC_LEVEL        (1 << 15)
+#define IOAPIC_MASKED       (1 << 16)
+
+// MPS INTI flags in MADT interrupt source overrides
+#define INTI_POLARITY_MASK  0x3
+#define INTI_POLARITY_LOW   0x3
+#define INTI_TRIGGER_MASK   0xC
+#define INTI_TRIGGER_LEVEL  0xC
+
+#define IRQ_BASE_VECTOR     32
+
+typedef struct {
+    volatile uint32_t* base;
+    uint32_t gsi_base;
+    uint32_t gsi_count;
+} ioapic_t;
+
+// Where an ISA IRQ ends up, after interrupt source overrides
+typedef struct {
+    uint32_t gsi;
+    uint32_t redir_flags;   // Polarity and trigger bits for the entry
+    int target;             // APIC ID, or -1 while masked
+} isa_irq_t;
+
+static ioapic_t ioapics[ACPI_MAX_IOAPICS];
+static uint32_t ioapic_count = 0;
+static isa_irq_t isa_irqs[IOAPIC_ISA_IRQS];
+static spinlock_t ioapic_lock = SPINLOCK_INIT;  // IOREGSEL/IOWIN pairs must not interleave
+
+// --- Internal Helper Functions ---
+
+static uint32_t ioapic_read(ioapic_t* ioapic, uint32_t reg) {
+    ioapic->base[IOAPIC_REGSEL / 4] = reg;
+    return ioapic->base[IOAPIC_WINDOW / 4];
+}
+
+static void ioapic_write(ioapic_t* ioapic, uint32_t reg, uint32_t value) {
+    ioapic->base[IOAPIC_REGSEL / 4] = reg;
+    ioapic->base[IOAPIC_WINDOW / 4] = value;
+}
+
+static ioapic_t* ioapic_for_gsi(uint32_t gsi) {
+    for (uint32_t i = 0; i < ioapic_count; i++) {
+        if (gsi >= ioapics[i].gsi_base && gsi < ioapics[i].gsi_base + ioapics[i].gsi_count) {
+            return &ioapics[i];
+        }
+    }
+    return NULL;
+}
+
+// Writes a redirection entry. The high dword goes first so the entry is
+// never live with a stale destination.
+static void ioapic_set_entry(uint32_t gsi, uint32_t low, uint8_t apic_id) {
+    ioapic_t* ioapic = ioapic_for_gsi(gsi);
+    if (ioapic == NULL) {
+        return;
+    }
+    uint32_t pin = gsi - ioapic->gsi_base;
+    uint32_t flags = spin_lock_irqsave(&ioapic_lock);
+    ioapic_write(ioapic, IOAPIC_REG_REDIR(pin), IOAPIC_MASKED);
+    ioapic_write(ioapic, IOAPIC_REG_REDIR(pin) + 1, (uint32_t)apic_id << 24);
+    ioapic_write(ioapic, IOAPIC_REG_REDIR(pin), low);
+    spin_unlock_irqrestore(&ioapic_lock, flags);
+}
+
+// ISA IRQs are edge triggered, active high, and identity mapped to GSIs
+// unless the MADT overrides them.
+static void ioapic_map_isa_irqs(const acpi_madt_info_t* madt) {
+    for (uint32_t irq = 0; irq < IOAPIC_ISA_IRQS; irq++) {
+        isa_irqs[irq].gsi = irq;
+        isa_irqs[irq].redir_flags = 0;
+        isa_irqs[irq].target = -1;
+    }
+
+    for (uint32_t i = 0; i < madt->override_count; i++) {
+        const acpi_override_t* iso = &madt->overrides[i];
+        if (iso->source_irq >= IOAPIC_ISA_IRQS) {
+            continue;
+        }
+        isa_irq_t* irq = &isa_irqs[iso->source_irq];
+        irq->gsi = iso->gsi;
+        if ((iso->flags & INTI_POLARITY_MASK) == INTI_POLARITY_LOW) {
+            irq->redir_flags |= IOAPIC_ACTIVE_LOW;
+        }
+        if ((iso->flags & INTI_TRIGGER_MASK) == INTI_TRIGGER_LEVEL) {
+            irq->redir_flags |= IOAPIC_LEVEL;
+        }
+    }
+}
+
+// --- Public API Functions ---
+
+bool ioapic_init(void) {
+    const acpi_madt_info_t* madt = acpi_get_madt();
+    if (madt == NULL || madt->ioapic_count == 0 || !lapic_is_enabled()) {
+        return false;
+    }
+
+    for (uint32_t i = 0; i < madt->ioapic_count; i++) {
+        ioapic_t* ioapic = &ioapics[i];
+        ioapic->base = paging_map_mmio(madt->ioapics[i].address);
+        ioapic->gsi_base = madt->ioapics[i].gsi_base;
+        ioapic->gsi_count = ((ioapic_read(ioapic, IOAPIC_REG_VERSION) >> 16) & 0xFF) + 1;
+
+        for (uint32_t pin = 0; pin < ioapic->gsi_count; pin++) {
+            ioapic_write(ioapic, IOAPIC_REG_REDIR(pin), IOAPIC_MASKED);
+        }
+    }
+    ioapic_count = madt->ioapic_count;
+    ioapic_map_isa_irqs(madt);
+
+    // Silence the 8259 for good: mask it, and stop the BSP's LAPIC from
+    // accepting its ExtINT on LINT0
+    pic_disable();
+    lapic_mask_lint0();
+    return true;
+}
+
+bool ioapic_is_enabled(void) {
+    return ioapic_count > 0;
+}
+
+bool ioapic_route_irq(uint8_t irq, uint8_t apic_id) {
+    if (irq >= IOAPIC_ISA_IRQS || ioapic_for_gsi(isa_irqs[irq].gsi) == NULL) {
+        return false;
+    }
+    // Fixed delivery, physical destination
+    ioapic_set_entry(isa_irqs[irq].gsi, isa_irqs[irq].redir_flags | (IRQ_BASE_VECTOR + irq), apic_id);
+    isa_irqs[irq].target = apic_id;
+    return true;
+}
+
+void ioapic_mask_irq(uint8_t irq) {
+    if (irq >= IOAPIC_ISA_IRQS) {
+        return;
+    }
+    ioapic_set_entry(isa_irqs[irq].gsi, IOAPIC_MASKED, 0);
+    isa_irqs[irq].target = -1;
+}
+
+int ioapic_get_irq_target(uint8_t irq) {
+    if (irq >= IOAPIC_ISA_IRQS) {
+        return -1;
+    }
+    return isa_irqs[irq].target;
+}
@@ -0,0 +1,30 @@
+#ifndef IOAPIC_H
+#define IOAPIC_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+// --- I/O APIC ---
+// Routes the legacy ISA IRQs to local APICs instead of the 8259 pair. IRQ n
+// keeps vector 32 + n, so the IDT and the drivers don't change; only the EOI
+// goes to the LAPIC. Each IRQ is delivered to one CPU, chosen per IRQ.
+
+#define IOAPIC_ISA_IRQS 16
+
+// Takes over interrupt routing from the 8259 using the MADT's I/O APICs and
+// interrupt source overrides. Every IRQ starts out masked. Needs the LAPIC.
+// Returns false (and leaves the 8259 in charge) if there is no I/O APIC.
+bool ioapic_init(void);
+
+bool ioapic_is_enabled(void);
+
+// Unmasks ISA IRQ 'irq' and delivers it to the CPU with APIC ID 'apic_id'.
+// Also used to move an already enabled IRQ to another CPU.
+bool ioapic_route_irq(uint8_t irq, uint8_t apic_id);
+
+void ioapic_mask_irq(uint8_t irq);
+
+// APIC ID the IRQ is delivered to, or -1 if it is masked.
+int ioapic_get_irq_target(uint8_t irq);
+
+#endif // IOAPIC_H
@@ -1,13 +1,20 @@
 #include "keyboard.h"
 #include "terminal.h"
 #include "../io/io.h"
-#include "../shell/shell.h"
+#include "../src/cpu.h"
+#include "../src/waitqueue.h"
+#include "../src/spinlock.h"
+#include "timer.h"
 #include <stdint.h>
+#include <stdbool.h>
 
 // --- I/O Ports ---
 #define KBD_STATUS_PORT 0x64
 #define KBD_DATA_PORT   0x60
 
+// How long the controller may take to accept or produce a byte
+#define KBD_TIMEOUT_NS  (100 * 1000 * 1000ull)
+
 // --- Scancode Maps (US QWERTY) ---
 const char scancode_map_base[128] = {
     0,  27, '1', '2', '3', '4', '5', '6', '7', '8', '9', '0', '-', '=', '\b',
@@ -31,7 +38,52 @@ const char scancode_map_shifted[128] = {
 static int escape_state = 0;
 static int shift_pressed = 0;
 
+// --- Key Ring ---
+// Single-consumer ring: only IRQ handlers move 'head' and only the
+// reading thread moves 'tail', so the reader needs no lock. The keyboard
+// and serial IRQs may be routed to different CPUs, so producers take
+// key_push_lock. The counters run freely and are reduced modulo the
+// (power of two) size.
+#define KEY_RING_SIZE 128
+
+static int key_ring[KEY_RING_SIZE];
+static volatile uint32_t key_ring_head = 0;
+static volatile uint32_t key_ring_tail = 0;
+static spinlock_t key_push_lock = SPINLOCK_INIT;
+static wait_queue_t key_wait = WAIT_QUEUE_INIT; // Threads in keyboard_get_key()
+
+static void key_ring_push(int key) {
+    uint32_t flags = spin_lock_irqsave(&key_push_lock);
+    if (key_ring_head - key_ring_tail == KEY_RING_SIZE) {
+        spin_unlock_irqrestore(&key_push_lock, flags);
+        return; // Full: drop the key rather than block in an IRQ
+    }
+    key_ring[key_ring_head % KEY_RING_SIZE] = key;
+    asm volatile("" ::: "memory"); // Publish the slot before the new head
+    key_ring_head++;
+    spin_unlock_irqrestore(&key_push_lock, flags);
+
+    wait_queue_wake(&key_wait);
+}
+
+static bool key_ring_nonempty(void* arg) {
+    (void)arg;
+    return key_ring_tail != key_ring_head;
+}
+
+static bool key_ring_pop(int* key) {
+    if (key_ring_tail == key_ring_head) {
+        return false;
+    }
+    *key = key_ring[key_ring_tail % KEY_RING_SIZE];
+    asm volatile("" ::: "memory"); // Read the slot before handing it back
+    key_ring_tail++;
+    return true;
+}
+
 // --- C-Level Interrupt Handler with Corrected Logic ---
+// Only decodes the scancode and queues the key; the shell thread does the
+// actual work, so the IRQ is over in microseconds.
 void keyboard_handler(void) {
     uint8_t scancode = inb(KBD_DATA_PORT);
 
@@ -44,10 +96,10 @@ void keyboard_handler(void) {
     // 2. Handle the second byte of an escape sequence.
     if (escape_state == 1) {
         switch (scancode) {
-            case 0x48: shell_handle_key(KEY_UP); break;
-            case 0x50: shell_handle_key(KEY_DOWN); break;
-            case 0x4B: shell_handle_key(KEY_LEFT); break;
-            case 0x4D: shell_handle_key(KEY_RIGHT); break;
+            case 0x48: key_ring_push(KEY_UP); break;
+            case 0x50: key_ring_push(KEY_DOWN); break;
+            case 0x4B: key_ring_push(KEY_LEFT); break;
+            case 0x4D: key_ring_push(KEY_RIGHT); break;
         }
         escape_state = 0; // Reset state.
         return;
@@ -67,35 +119,75 @@ void keyboard_handler(void) {
         if (scancode == 0x2A || scancode == 0x36) { // L/R Shift pressed
             shift_pressed = 1;
         } else if (scancode == 0x0F) { // --- THIS IS THE NEW PART --- Tab key pressed
-            shell_handle_key(KEY_TAB);
+            key_ring_push(KEY_TAB);
         } else {
             char c = shift_pressed ? scancode_map_shifted[scancode] : scancode_map_base[scancode];
             if (c != 0) {
-                shell_handle_key(c);
+                key_ring_push(c);
             }
         }
     }
 }
 
+int keyboard_get_key(void) {
+    int key;
+    while (!key_ring_pop(&key)) {
+        wait_event(&key_wait, key_ring_nonempty, NULL, 0);
+    }
+    return key;
+}
+
+bool keyboard_try_get_key(int* key) {
+    return key_ring_pop(key);
+}
+
+void keyboard_push_key(int key) {
+    key_ring_push(key);
+}
 
 // --- Helper functions for PS/2 Controller ---
-static void kbd_wait_input() {
-    while (inb(KBD_STATUS_PORT) & 0x02);
+// The 8042 raises no interrupt when its input buffer drains, and these only
+// run from keyboard_init(), before there is a scheduler to sleep in. So they
+// poll, but give up rather than hang on a controller that never answers.
+static bool kbd_wait_status(uint8_t mask, uint8_t value) {
+    uint64_t deadline = ktime_ns() + KBD_TIMEOUT_NS;
+    do {
+        if ((inb(KBD_STATUS_PORT) & mask) == value) {
+            return true;
+        }
+        asm volatile("pause");
+    } while (ktime_ns() < deadline);
+    return false;
+}
+static bool kbd_wait_input() {
+    return kbd_wait_status(0x02, 0x00); // Input buffer empty
 }
-static void kbd_wait_output() {
-    while (!(inb(KBD_STATUS_PORT) & 0x01));
+static bool kbd_wait_output() {
+    return kbd_wait_status(0x01, 0x01); // Output buffer full
 }
 
 // --- Keyboard Initialization ---
 void keyboard_init(void) {
-    kbd_wait_input();
+    if (!kbd_wait_input()) {
+        terminal_writeerror("Keyboard: PS/2 controller not responding.\n");
+        return;
+    }
     outb(KBD_STATUS_PORT, 0x20);
-    kbd_wait_output();
+    if (!kbd_wait_output()) {
+        terminal_writeerror("Keyboard: PS/2 controller not responding.\n");
+        return;
+    }
     uint8_t ccb = inb(KBD_DATA_PORT);
     ccb |= (1 << 6) | (1 << 0);
-    kbd_wait_input();
+    if (!kbd_wait_input()) {
+        terminal_writeerror("Keyboard: PS/2 controller not responding.\n");
+        return;
+    }
     outb(KBD_STATUS_PORT, 0x60);
-    kbd_wait_input();
+    if (!kbd_wait_input()) {
+        terminal_writeerror("Keyboard: PS/2 controller not responding.\n");
+        return;
+    }
     outb(KBD_DATA_PORT, ccb);
     while(inb(KBD_STATUS_PORT) & 0x01) {
         inb(KBD_DATA_PORT);
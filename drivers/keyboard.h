@@ -1,6 +1,8 @@
 #ifndef KEYBOARD_H
 #define KEYBOARD_H
 
+#include <stdbool.h>
+
 // Special key definitions
 #define KEY_UP      0x101
 #define KEY_DOWN    0x102
@@ -10,8 +12,18 @@
 #define KEY_CTRL_Q 0x10 // Example: Ctrl+'Q'
 #define KEY_BACKSPACE 0x0E
 #define KEY_TAB '\t'
+
 void keyboard_handler(void);
 // Initializes the keyboard driver.
 void keyboard_init(void);
 
+// Returns the next key, blocking the calling thread until one is typed.
+int keyboard_get_key(void);
+
+// Takes a queued key without blocking. Returns false if there is none.
+bool keyboard_try_get_key(int* key);
+
+// Queues a key from another input device (the serial console). IRQ-safe.
+void keyboard_push_key(int key);
+
 #endif
@@ -0,0 +1,148 @@
+#include "lapic.h"
+#include "timer.h"
+#include "../memory/paging.h"
+
+// Register offsets
+#define LAPIC_ID            0x020
+#define LAPIC_TPR           0x080   // Task priority
+#define LAPIC_EOI           0x0B0
+#define LAPIC_SVR           0x0F0   // Spurious interrupt vector
+#define LAPIC_ICR_LOW       0x300   // Interrupt command
+#define LAPIC_ICR_HIGH      0x310
+#define LAPIC_LVT_TIMER     0x320
+#define LAPIC_LVT_LINT0     0x350
+#define LAPIC_TIMER_INITIAL 0x380
+#define LAPIC_TIMER_CURRENT 0x390
+#define LAPIC_TIMER_DIVIDE  0x3E0
+
+#define LAPIC_SVR_ENABLE    0x100
+#define LAPIC_LVT_MASKED    0x10000
+#define LAPIC_TIMER_PERIODIC 0x20000
+#define LAPIC_TIMER_DIV_16  0x3
+
+// ICR fields
+#define ICR_INIT            0x500
+#define ICR_STARTUP         0x600
+#define ICR_LEVEL_ASSERT    0x4000
+#define ICR_DELIVERY_PENDING 0x1000
+
+#define LAPIC_CALIBRATE_US  10000
+
+static volatile uint32_t* lapic_base = 0;
+static uint32_t lapic_ticks_per_period = 0; // Initial count for one TIMER_HZ tick
+static bool lapic_oneshot = false;
+
+// --- Internal Helper Functions ---
+
+static inline uint32_t lapic_read(uint32_t reg) {
+    return lapic_base[reg / 4];
+}
+
+static inline void lapic_write(uint32_t reg, uint32_t value) {
+    lapic_base[reg / 4] = value;
+    (void)lapic_base[LAPIC_ID / 4]; // Read back to wait for the write to land
+}
+
+static void lapic_enable(void) {
+    lapic_write(LAPIC_TPR, 0); // Accept every priority
+    lapic_write(LAPIC_SVR, LAPIC_SVR_ENABLE | LAPIC_SPURIOUS_VECTOR);
+}
+
+static void lapic_send_icr(uint8_t apic_id, uint32_t command) {
+    lapic_write(LAPIC_ICR_HIGH, (uint32_t)apic_id << 24);
+    lapic_write(LAPIC_ICR_LOW, command);
+    while (lapic_read(LAPIC_ICR_LOW) & ICR_DELIVERY_PENDING) {
+        asm volatile("pause");
+    }
+}
+
+// Counts how far the timer runs down in LAPIC_CALIBRATE_US.
+static void lapic_timer_calibrate(void) {
+    lapic_write(LAPIC_TIMER_DIVIDE, LAPIC_TIMER_DIV_16);
+    lapic_write(LAPIC_LVT_TIMER, LAPIC_LVT_MASKED);
+    lapic_write(LAPIC_TIMER_INITIAL, 0xFFFFFFFF);
+    timer_udelay(LAPIC_CALIBRATE_US);
+    uint32_t elapsed = 0xFFFFFFFF - lapic_read(LAPIC_TIMER_CURRENT);
+    lapic_write(LAPIC_TIMER_INITIAL, 0);
+
+    lapic_ticks_per_period = elapsed / (LAPIC_CALIBRATE_US / (1000000 / TIMER_HZ));
+}
+
+// --- Public API Functions ---
+
+bool lapic_init(uint32_t phys) {
+    if (phys == 0) {
+        return false;
+    }
+    lapic_base = paging_map_mmio(phys);
+    lapic_enable();
+    return true;
+}
+
+void lapic_init_ap(void) {
+    lapic_mask_lint0(); // Only the BSP takes 8259 IRQs
+    lapic_enable();
+}
+
+void lapic_mask_lint0(void) {
+    lapic_write(LAPIC_LVT_LINT0, LAPIC_LVT_MASKED);
+}
+
+bool lapic_is_enabled(void) {
+    return lapic_base != 0;
+}
+
+uint32_t lapic_get_id(void) {
+    return lapic_read(LAPIC_ID) >> 24;
+}
+
+void lapic_eoi(void) {
+    // A single posted MMIO write: nothing here needs it to have landed
+    lapic_base[LAPIC_EOI / 4] = 0;
+}
+
+void lapic_timer_start(void) {
+    if (lapic_ticks_per_period == 0) {
+        lapic_timer_calibrate();
+        if (timer_get_tsc_khz() != 0 && lapic_ticks_per_period != 0) {
+            lapic_oneshot = true;
+            timer_stop_periodic();
+        }
+    }
+
+    lapic_write(LAPIC_TIMER_DIVIDE, LAPIC_TIMER_DIV_16);
+    if (lapic_oneshot) {
+        lapic_write(LAPIC_LVT_TIMER, LAPIC_TIMER_VECTOR); // Armed on demand
+        return;
+    }
+    lapic_write(LAPIC_LVT_TIMER, LAPIC_TIMER_PERIODIC | LAPIC_TIMER_VECTOR);
+    lapic_write(LAPIC_TIMER_INITIAL, lapic_ticks_per_period);
+}
+
+bool lapic_timer_is_oneshot(void) {
+    return lapic_oneshot;
+}
+
+void lapic_timer_arm(uint32_t ticks) {
+    uint32_t max_ticks = 0xFFFFFFFF / lapic_ticks_per_period;
+    if (ticks > max_ticks) {
+        ticks = max_ticks;
+    }
+    // Writing the initial count restarts the countdown; 0 stops it
+    lapic_base[LAPIC_TIMER_INITIAL / 4] = ticks * lapic_ticks_per_period;
+}
+
+void lapic_start_ap(uint8_t apic_id, uint32_t trampoline) {
+    lapic_send_icr(apic_id, ICR_INIT | ICR_LEVEL_ASSERT);
+    timer_udelay(10000);
+
+    // Two SIPIs, as the MP spec asks; the vector is the trampoline's page
+    for (int i = 0; i < 2; i++) {
+        lapic_send_icr(apic_id, ICR_STARTUP | ((trampoline >> 12) & 0xFF));
+        timer_udelay(200);
+    }
+}
+
+void lapic_send_ipi(uint8_t apic_id, uint8_t vector) {
+    lapic_send_icr(apic_id, vector); // Fixed delivery, physical destination
+}
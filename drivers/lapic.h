@@ -0,0 +1,51 @@
+#ifndef LAPIC_H
+#define LAPIC_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+// --- Local APIC ---
+// Each CPU's own interrupt controller: per-CPU timer, EOI and IPIs.
+
+#define LAPIC_TIMER_VECTOR    0x40
+#define LAPIC_RESCHED_VECTOR  0x41  // IPI: "your run queue changed"
+#define LAPIC_SPURIOUS_VECTOR 0xFF
+
+// Maps the LAPIC registers at 'phys' and enables the boot CPU's LAPIC.
+// Leaves LINT0 alone so the 8259 keeps delivering through it.
+bool lapic_init(uint32_t phys);
+
+// Enables the calling AP's LAPIC (LINT0 masked).
+void lapic_init_ap(void);
+
+// Stops the calling CPU accepting 8259 interrupts on LINT0.
+void lapic_mask_lint0(void);
+
+bool lapic_is_enabled(void);
+
+uint32_t lapic_get_id(void);
+
+// Signals end of interrupt for LAPIC-delivered vectors, including the ISA
+// IRQs once the I/O APIC routes them.
+void lapic_eoi(void);
+
+// Starts this CPU's LAPIC timer. The first call calibrates it against the
+// TSC/PIT; later CPUs reuse the result. With a TSC to keep time the timer
+// runs one-shot (tickless): it stays quiet until lapic_timer_arm() and the
+// PIT is stopped. Without one it ticks periodically at TIMER_HZ.
+void lapic_timer_start(void);
+
+bool lapic_timer_is_oneshot(void);
+
+// One-shot mode: interrupts once after 'ticks' TIMER_HZ periods (clamped
+// to what the counter holds, so it may fire early). 0 disarms the timer.
+void lapic_timer_arm(uint32_t ticks);
+
+// Sends the INIT-SIPI-SIPI sequence that starts an AP executing real-mode
+// code at 'trampoline' (page aligned, below 1 MiB).
+void lapic_start_ap(uint8_t apic_id, uint32_t trampoline);
+
+// Sends a fixed interrupt to the CPU with the given APIC ID.
+void lapic_send_ipi(uint8_t apic_id, uint8_t vector);
+
+#endif // LAPIC_H
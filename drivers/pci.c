@@ -0,0 +1,116 @@
+#include "pci.h"
+#include "../io/io.h"
+#include "../src/spinlock.h"
+#include <stddef.h>
+
+#define PCI_CONFIG_ADDRESS  0xCF8
+#define PCI_CONFIG_DATA     0xCFC
+
+// Standard header fields
+#define PCI_STATUS          0x06
+#define PCI_STATUS_CAP_LIST 0x10
+#define PCI_CAP_POINTER     0x34
+
+// MSI capability layout
+#define MSI_CONTROL         0x02
+#define MSI_ADDRESS_LOW     0x04
+#define MSI_ADDRESS_HIGH    0x08    // Only with a 64-bit address
+#define MSI_CONTROL_ENABLE  0x0001
+#define MSI_CONTROL_MME     0x0070  // Multiple messages enabled
+#define MSI_CONTROL_64BIT   0x0080
+
+// Message address: the LAPIC window, with the destination APIC ID in 12-19
+#define MSI_ADDRESS_BASE    0xFEE00000
+
+static void (*msi_handlers[MSI_VECTOR_COUNT])(void);
+static spinlock_t pci_lock = SPINLOCK_INIT;  // The address/data port pair is shared
+
+// --- Internal Helper Functions ---
+
+static uint32_t pci_address(uint8_t bus, uint8_t dev, uint8_t func, uint8_t offset) {
+    return 0x80000000 | ((uint32_t)bus << 16) | ((uint32_t)(dev & 0x1F) << 11) |
+           ((uint32_t)(func & 0x7) << 8) | (offset & 0xFC);
+}
+
+// --- Public API Functions ---
+
+uint32_t pci_config_read32(uint8_t bus, uint8_t dev, uint8_t func, uint8_t offset) {
+    uint32_t flags = spin_lock_irqsave(&pci_lock);
+    outl(PCI_CONFIG_ADDRESS, pci_address(bus, dev, func, offset));
+    uint32_t value = inl(PCI_CONFIG_DATA);
+    spin_unlock_irqrestore(&pci_lock, flags);
+    return value;
+}
+
+void pci_config_write32(uint8_t bus, uint8_t dev, uint8_t func, uint8_t offset, uint32_t value) {
+    uint32_t flags = spin_lock_irqsave(&pci_lock);
+    outl(PCI_CONFIG_ADDRESS, pci_address(bus, dev, func, offset));
+    outl(PCI_CONFIG_DATA, value);
+    spin_unlock_irqrestore(&pci_lock, flags);
+}
+
+uint16_t pci_config_read16(uint8_t bus, uint8_t dev, uint8_t func, uint8_t offset) {
+    uint32_t dword = pci_config_read32(bus, dev, func, offset);
+    return (dword >> ((offset & 2) * 8)) & 0xFFFF;
+}
+
+// Read-modify-write of the containing dword. Only use it on registers whose
+// other half isn't write-1-to-clear (the MSI control word is fine).
+void pci_config_write16(uint8_t bus, uint8_t dev, uint8_t func, uint8_t offset, uint16_t value) {
+    uint32_t shift = (offset & 2) * 8;
+    uint32_t dword = pci_config_read32(bus, dev, func, offset);
+    dword = (dword & ~(0xFFFFu << shift)) | ((uint32_t)value << shift);
+    pci_config_write32(bus, dev, func, offset, dword);
+}
+
+uint8_t pci_find_capability(uint8_t bus, uint8_t dev, uint8_t func, uint8_t cap_id) {
+    if (!(pci_config_read16(bus, dev, func, PCI_STATUS) & PCI_STATUS_CAP_LIST)) {
+        return 0;
+    }
+
+    uint8_t offset = pci_config_read32(bus, dev, func, PCI_CAP_POINTER) & 0xFC;
+    for (int guard = 0; offset != 0 && guard < 48; guard++) {
+        uint32_t header = pci_config_read32(bus, dev, func, offset);
+        if ((header & 0xFF) == cap_id) {
+            return offset;
+        }
+        offset = (header >> 8) & 0xFC;
+    }
+    return 0;
+}
+
+int msi_alloc_vector(void (*handler)(void)) {
+    for (int i = 0; i < MSI_VECTOR_COUNT; i++) {
+        if (__sync_bool_compare_and_swap(&msi_handlers[i], NULL, handler)) {
+            return MSI_VECTOR_BASE + i;
+        }
+    }
+    return -1;
+}
+
+bool pci_enable_msi(uint8_t bus, uint8_t dev, uint8_t func, uint8_t vector, uint8_t apic_id) {
+    uint8_t cap = pci_find_capability(bus, dev, func, PCI_CAP_MSI);
+    if (cap == 0) {
+        return false;
+    }
+
+    uint16_t control = pci_config_read16(bus, dev, func, cap + MSI_CONTROL);
+    uint8_t data_offset = (control & MSI_CONTROL_64BIT) ? 0x0C : 0x08;
+
+    pci_config_write32(bus, dev, func, cap + MSI_ADDRESS_LOW, MSI_ADDRESS_BASE | ((uint32_t)apic_id << 12));
+    if (control & MSI_CONTROL_64BIT) {
+        pci_config_write32(bus, dev, func, cap + MSI_ADDRESS_HIGH, 0);
+    }
+    pci_config_write16(bus, dev, func, cap + data_offset, vector); // Fixed, edge
+
+    control &= ~MSI_CONTROL_MME; // One message
+    pci_config_write16(bus, dev, func, cap + MSI_CONTROL, control | MSI_CONTROL_ENABLE);
+    return true;
+}
+
+void msi_dispatch(uint8_t vector) {
+    void (*handler)(void) = msi_handlers[vector - MSI_VECTOR_BASE];
+    if (handler != NULL) {
+        handler();
+    }
+}
@@ -0,0 +1,38 @@
+#ifndef PCI_H
+#define PCI_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+// --- PCI Configuration Space and MSI ---
+// Configuration mechanism #1 (ports 0xCF8/0xCFC), plus Message Signalled
+// Interrupts: an MSI-capable device writes its vector straight to a chosen
+// CPU's LAPIC, with no I/O APIC pin or sharing involved.
+
+#define PCI_CAP_MSI 0x05
+
+// Vectors handed out to MSI handlers (isr80..isr87 in interrupts.asm)
+#define MSI_VECTOR_BASE  0x50
+#define MSI_VECTOR_COUNT 8
+
+uint32_t pci_config_read32(uint8_t bus, uint8_t dev, uint8_t func, uint8_t offset);
+void pci_config_write32(uint8_t bus, uint8_t dev, uint8_t func, uint8_t offset, uint32_t value);
+uint16_t pci_config_read16(uint8_t bus, uint8_t dev, uint8_t func, uint8_t offset);
+void pci_config_write16(uint8_t bus, uint8_t dev, uint8_t func, uint8_t offset, uint16_t value);
+
+// Offset of capability 'cap_id' in the function's capability list, or 0.
+uint8_t pci_find_capability(uint8_t bus, uint8_t dev, uint8_t func, uint8_t cap_id);
+
+// Reserves an MSI vector whose interrupts call 'handler'. Returns the
+// vector, or -1 if they are all taken.
+int msi_alloc_vector(void (*handler)(void));
+
+// Points the function's MSI at 'vector' on the CPU with APIC ID 'apic_id'
+// and enables it (single message, edge triggered). Returns false if the
+// function has no MSI capability.
+bool pci_enable_msi(uint8_t bus, uint8_t dev, uint8_t func, uint8_t vector, uint8_t apic_id);
+
+// Called by the interrupt dispatcher for vectors in the MSI range.
+void msi_dispatch(uint8_t vector);
+
+#endif // PCI_H
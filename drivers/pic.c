@@ -39,3 +39,17 @@ void pic_send_eoi(uint8_t irq) {
     }
     outb(PIC1_COMMAND, PIC_EOI);
 }
+
+void pic_unmask_irq(uint8_t irq) {
+    if (irq >= 8) {
+        outb(PIC2_DATA, inb(PIC2_DATA) & ~(1 << (irq - 8)));
+        irq = 2; // The slave's cascade input on the master
+    }
+    outb(PIC1_DATA, inb(PIC1_DATA) & ~(1 << irq));
+}
+
+void pic_disable(void) {
+    // Still remapped, so a spurious IRQ can't land on an exception vector
+    outb(PIC1_DATA, 0xFF);
+    outb(PIC2_DATA, 0xFF);
+}
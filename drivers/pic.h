@@ -9,4 +9,10 @@ void pic_remap(void);
 // Function to send an End-of-Interrupt (EOI) signal
 void pic_send_eoi(uint8_t irq);
 
+// Unmasks one IRQ (and the cascade, for IRQs on the slave PIC)
+void pic_unmask_irq(uint8_t irq);
+
+// Masks every IRQ on both PICs (once the I/O APIC has taken over)
+void pic_disable(void);
+
 #endif
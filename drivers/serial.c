@@ -0,0 +1,241 @@
+#include "serial.h"
+#include "keyboard.h"
+#include "../io/io.h"
+#include "../src/spinlock.h"
+
+#define COM1_BASE           0x3F8
+
+// Register offsets. With LCR_DLAB set, the first two hold the divisor.
+#define UART_DATA           0 // RBR when read, THR when written
+#define UART_IER            1
+#define UART_IIR            2 // Read
+#define UART_FCR            2 // Write
+#define UART_LCR            3
+#define UART_MCR            4
+#define UART_LSR            5
+
+#define IER_RX_DATA         0x01
+#define IER_TX_EMPTY        0x02
+
+#define IIR_NO_INT          0x01
+#define IIR_FIFO_ENABLED    0xC0 // Both bits: a 16550A whose FIFOs work
+
+#define FCR_ENABLE          0x01
+#define FCR_CLEAR_RX        0x02
+#define FCR_CLEAR_TX        0x04
+#define FCR_RX_TRIGGER_14   0xC0 // Interrupt once 14 bytes are waiting
+
+#define LCR_8N1             0x03
+#define LCR_DLAB            0x80
+
+#define MCR_DTR             0x01
+#define MCR_RTS             0x02
+#define MCR_OUT2            0x08 // Connects the IRQ line on PCs
+#define MCR_LOOPBACK        0x10
+
+#define LSR_DATA_READY      0x01
+#define LSR_THR_EMPTY       0x20 // The whole transmit FIFO is empty
+
+#define SERIAL_DIVISOR      1      // 115200 baud
+#define SERIAL_FIFO_SIZE    16
+#define SERIAL_POLL_LIMIT   100000 // Port reads; a byte takes 87 us to send
+
+// Free-running counters reduced modulo the (power of two) size, as in the
+// keyboard's ring
+#define TX_RING_SIZE        4096
+
+static bool present = false;
+static bool irq_mode = false;
+static uint32_t fifo_size = 1;
+
+// Guards the ring and the UART's transmit side, which the IRQ handler and
+// writers on any CPU share
+static spinlock_t tx_lock = SPINLOCK_INIT;
+static char tx_ring[TX_RING_SIZE];
+static uint32_t tx_head = 0;
+static uint32_t tx_tail = 0;
+
+// Receive state, only touched by the IRQ handler
+static int rx_escape_state = 0;
+static bool rx_last_cr = false;
+
+// --- Internal Helper Functions ---
+
+static inline uint8_t uart_read(uint16_t reg) {
+    return inb(COM1_BASE + reg);
+}
+
+static inline void uart_write(uint16_t reg, uint8_t value) {
+    outb(COM1_BASE + reg, value);
+}
+
+static bool uart_wait_status(uint8_t bit) {
+    for (uint32_t i = 0; i < SERIAL_POLL_LIMIT; i++) {
+        if (uart_read(UART_LSR) & bit) {
+            return true;
+        }
+        asm volatile("pause");
+    }
+    return false;
+}
+
+// Moves up to a FIFO's worth from the ring to the UART, if its transmit
+// FIFO has drained. Called with tx_lock held.
+static void tx_fill(void) {
+    if (tx_tail == tx_head || !(uart_read(UART_LSR) & LSR_THR_EMPTY)) {
+        return;
+    }
+    for (uint32_t i = 0; i < fifo_size && tx_tail != tx_head; i++) {
+        uart_write(UART_DATA, tx_ring[tx_tail % TX_RING_SIZE]);
+        tx_tail++;
+    }
+}
+
+// Sends everything in the ring by polling. Called with tx_lock held. If
+// the UART stops taking bytes the rest is dropped rather than hang.
+static void tx_drain_polled(void) {
+    while (tx_tail != tx_head) {
+        if (!uart_wait_status(LSR_THR_EMPTY)) {
+            tx_tail = tx_head;
+            return;
+        }
+        tx_fill();
+    }
+}
+
+// Turns what a terminal sends into the keys the shell expects.
+static void rx_receive(uint8_t byte) {
+    static const int arrow_keys[4] = { KEY_UP, KEY_DOWN, KEY_RIGHT, KEY_LEFT };
+
+    if (rx_escape_state == 1) {
+        rx_escape_state = 0;
+        if (byte == '[') {
+            rx_escape_state = 2;
+            return;
+        }
+        keyboard_push_key(27); // A lone ESC
+    } else if (rx_escape_state == 2) {
+        rx_escape_state = 0;
+        if (byte >= 'A' && byte <= 'D') {
+            keyboard_push_key(arrow_keys[byte - 'A']);
+        }
+        return; // Other sequences are ignored
+    }
+
+    bool after_cr = rx_last_cr;
+    rx_last_cr = (byte == '\r');
+    if (byte == 27) {
+        rx_escape_state = 1;
+    } else if (byte == '\r') {
+        keyboard_push_key('\n');
+    } else if (byte == '\n') {
+        if (!after_cr) {
+            keyboard_push_key('\n'); // Not the second half of "\r\n"
+        }
+    } else if (byte == 0x7F) {
+        keyboard_push_key('\b'); // Terminals send DEL for backspace
+    } else {
+        keyboard_push_key(byte);
+    }
+}
+
+// --- Public API Functions ---
+
+bool serial_init(void) {
+    uart_write(UART_IER, 0);
+    uart_write(UART_LCR, LCR_DLAB);
+    uart_write(UART_DATA, SERIAL_DIVISOR & 0xFF);
+    uart_write(UART_IER, SERIAL_DIVISOR >> 8);
+    uart_write(UART_LCR, LCR_8N1);
+    uart_write(UART_FCR, FCR_ENABLE | FCR_CLEAR_RX | FCR_CLEAR_TX | FCR_RX_TRIGGER_14);
+
+    // A real UART echoes a byte back in loopback mode; an empty port
+    // reads as 0xFF
+    uart_write(UART_MCR, MCR_LOOPBACK | MCR_DTR | MCR_RTS);
+    uart_write(UART_DATA, 0xAE);
+    if (!uart_wait_status(LSR_DATA_READY) || uart_read(UART_DATA) != 0xAE) {
+        return false;
+    }
+    uart_write(UART_MCR, MCR_DTR | MCR_RTS | MCR_OUT2);
+
+    if ((uart_read(UART_IIR) & IIR_FIFO_ENABLED) == IIR_FIFO_ENABLED) {
+        fifo_size = SERIAL_FIFO_SIZE;
+    }
+    present = true;
+    return true;
+}
+
+void serial_enable_irq(void) {
+    if (!present) {
+        return;
+    }
+    uint32_t flags = spin_lock_irqsave(&tx_lock);
+    irq_mode = true;
+    uart_write(UART_IER, IER_RX_DATA | IER_TX_EMPTY);
+    spin_unlock_irqrestore(&tx_lock, flags);
+}
+
+bool serial_present(void) {
+    return present;
+}
+
+void serial_irq_handler(void) {
+    if (!present) {
+        return;
+    }
+    // Reading IIR acknowledges a transmit-empty interrupt; receive ones
+    // last until the FIFO is read empty. Bounded in case the line babbles.
+    for (int round = 0; round < SERIAL_FIFO_SIZE; round++) {
+        if (uart_read(UART_IIR) & IIR_NO_INT) {
+            break;
+        }
+        uint8_t lsr;
+        while ((lsr = uart_read(UART_LSR)) & LSR_DATA_READY) {
+            rx_receive(uart_read(UART_DATA));
+        }
+        if (lsr & LSR_THR_EMPTY) {
+            uint32_t flags = spin_lock_irqsave(&tx_lock);
+            tx_fill();
+            spin_unlock_irqrestore(&tx_lock, flags);
+        }
+    }
+}
+
+void serial_putchar(char c) {
+    serial_write(&c, 1);
+}
+
+void serial_write(const char* data, size_t len) {
+    if (!present) {
+        return;
+    }
+    uint32_t flags = spin_lock_irqsave(&tx_lock);
+    for (size_t i = 0; i < len; i++) {
+        if (tx_head - tx_tail == TX_RING_SIZE) {
+            // Full: wait for the UART rather than lose output
+            if (!uart_wait_status(LSR_THR_EMPTY)) {
+                tx_tail = tx_head;
+            }
+            tx_fill();
+        }
+        tx_ring[tx_head % TX_RING_SIZE] = data[i];
+        tx_head++;
+    }
+
+    if (irq_mode) {
+        tx_fill(); // Starts the transmitter if idle; the IRQ does the rest
+    } else {
+        tx_drain_polled();
+    }
+    spin_unlock_irqrestore(&tx_lock, flags);
+}
+
+void serial_flush(void) {
+    if (!present) {
+        return;
+    }
+    uint32_t flags = spin_lock_irqsave(&tx_lock);
+    tx_drain_polled();
+    uart_wait_status(LSR_THR_EMPTY);
+    spin_unlock_irqrestore(&tx_lock, flags);
+}
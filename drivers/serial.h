@@ -0,0 +1,41 @@
+#ifndef SERIAL_H
+#define SERIAL_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <stdbool.h>
+
+// --- Serial Port (COM1) ---
+// A 16550 UART at 115200 8N1 with both FIFOs on. Output goes into a ring
+// that the transmit-empty interrupt drains a FIFO's worth at a time, so
+// writers only wait when the ring is full. Until serial_enable_irq() (and
+// if the UART has no working FIFO, one byte at a time) output is polled,
+// which keeps early boot messages.
+//
+// Received bytes are fed to the keyboard's key queue, with the ANSI arrow
+// key sequences translated, so a terminal on the other end can drive the
+// shell (see console= in kmain).
+
+#define SERIAL_COM1_IRQ 4
+
+// Programs COM1. Returns false if there is no UART there; the other calls
+// then do nothing.
+bool serial_init(void);
+
+// Switches to interrupt-driven I/O. Call once IRQ 4 is routed.
+void serial_enable_irq(void);
+
+bool serial_present(void);
+
+// IRQ 4 handler.
+void serial_irq_handler(void);
+
+// Queues bytes for sending, as-is (no newline translation).
+void serial_putchar(char c);
+void serial_write(const char* data, size_t len);
+
+// Waits until everything queued so far has been sent, by polling. Safe
+// with interrupts disabled, e.g. before halting.
+void serial_flush(void);
+
+#endif // SERIAL_H
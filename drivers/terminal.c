@@ -1,6 +1,7 @@
 #include "terminal.h"
 #include <stdarg.h>
 #include "../io/io.h" // Required for outb()
+#include "serial.h"
 
 // Define the dimensions of the VGA text-mode buffer
 static const size_t VGA_WIDTH = 80;
@@ -13,28 +14,88 @@ static uint16_t* const VGA_MEMORY = (uint16_t*) 0xB8000;
 static size_t terminal_row;
 static size_t terminal_column;
 static uint8_t terminal_color;
+static console_mode_t console_mode = CONSOLE_VGA;
 
 // Creates a VGA entry from a character and a color
 static inline uint16_t vga_entry(unsigned char uc, uint8_t color) {
     return (uint16_t) uc | (uint16_t) color << 8;
 }
 
+static inline bool console_on_vga(void) {
+    return console_mode != CONSOLE_SERIAL;
+}
+
+static inline bool console_on_serial(void) {
+    return console_mode != CONSOLE_VGA;
+}
+
+// Moves the cursor of the terminal on the serial line with ANSI escapes.
+// Moves within the current line are made relative, so they still work if
+// that terminal is taller than the screen.
+static void serial_move_cursor(size_t x, size_t y) {
+    char seq[32];
+    char number[12];
+    if (y == terminal_row) {
+        strcpy(seq, "\r");
+        if (x > 0) {
+            itoa(x, number, 10);
+            strcat(seq, "\033[");
+            strcat(seq, number);
+            strcat(seq, "C");
+        }
+    } else {
+        itoa(y + 1, number, 10);
+        strcpy(seq, "\033[");
+        strcat(seq, number);
+        strcat(seq, ";");
+        itoa(x + 1, number, 10);
+        strcat(seq, number);
+        strcat(seq, "H");
+    }
+    serial_write(seq, strlen(seq));
+}
+
+// Sends a character to the serial console, in terms a terminal understands.
+static void serial_console_putchar(char c) {
+    if (c == '\n') {
+        serial_write("\r\n", 2);
+    } else if (c == '\b') {
+        if (terminal_column > 0) {
+            serial_write("\b \b", 3); // Erase, like the screen does
+        }
+    } else {
+        serial_putchar(c);
+    }
+}
+
+// Moves the blinking hardware cursor to the driver's position.
+static void vga_update_cursor(void) {
+    if (!console_on_vga()) {
+        return;
+    }
+    uint16_t pos = terminal_row * VGA_WIDTH + terminal_column;
+
+    outb(0x3D4, 0x0E); // Send the high byte of the position
+    outb(0x3D5, (uint8_t)((pos >> 8) & 0xFF));
+    outb(0x3D4, 0x0F); // Send the low byte of the position
+    outb(0x3D5, (uint8_t)(pos & 0xFF));
+}
+
 /**
  * @brief Sets the hardware cursor's position AND updates the driver's
  * internal state to match.
  */
 void terminal_set_cursor(size_t x, size_t y) {
+    if (console_on_serial()) {
+        serial_move_cursor(x, y);
+    }
+
     // Update the driver's internal state
     terminal_column = x;
     terminal_row = y;
 
     // Update the hardware cursor
-    uint16_t pos = y * VGA_WIDTH + x;
-
-    outb(0x3D4, 0x0E); // Send the high byte of the position
-    outb(0x3D5, (uint8_t)((pos >> 8) & 0xFF));
-    outb(0x3D4, 0x0F); // Send the low byte of the position
-    outb(0x3D5, (uint8_t)(pos & 0xFF));
+    vga_update_cursor();
 }
 
 
@@ -48,7 +109,20 @@ void terminal_initialize(void) {
     terminal_set_cursor(terminal_column, terminal_row);
 }
 
+void terminal_set_console(console_mode_t mode) {
+    if (mode != CONSOLE_VGA && !serial_present()) {
+        return;
+    }
+    console_mode = mode;
+}
+
 void terminal_clear() {
+    if (console_on_serial()) {
+        serial_write("\033[2J\033[H", 7); // Clear, cursor home
+    }
+    if (!console_on_vga()) {
+        return;
+    }
     // Clear the entire screen
     for(size_t y = 0; y < VGA_HEIGHT; y++) {
         for(size_t x = 0; x < VGA_WIDTH; x++) {
@@ -60,6 +134,10 @@ void terminal_clear() {
 
 // Scrolls the terminal
 void terminal_scroll() {
+    terminal_row = VGA_HEIGHT - 1;
+    if (!console_on_vga()) {
+        return; // The terminal on the serial line scrolls by itself
+    }
     for(size_t y = 1; y < VGA_HEIGHT; y++) {
         for(size_t x = 0; x < VGA_WIDTH; x++) {
             const size_t index_to = (y - 1) * VGA_WIDTH + x;
@@ -73,19 +151,26 @@ void terminal_scroll() {
         const size_t index = last_row * VGA_WIDTH + x;
         VGA_MEMORY[index] = vga_entry(' ', terminal_color);
     }
-    terminal_row = VGA_HEIGHT - 1;
 }
 
 // Puts a single character on the screen at the current cursor pos
 void terminal_putchar(char c, uint8_t color) {
     uint8_t orig_term_color = terminal_color;
     terminal_color = color;
+    if (console_on_serial()) {
+        serial_console_putchar(c);
+    }
+    // With the serial console alone, only the position is tracked
+    bool vga = console_on_vga();
+
     // Handle backspace character
     if (c == '\b') {
         if (terminal_column > 0) {
             terminal_column--;
             const size_t index = terminal_row * VGA_WIDTH + terminal_column;
-            VGA_MEMORY[index] = vga_entry(' ', terminal_color);
+            if (vga) {
+                VGA_MEMORY[index] = vga_entry(' ', terminal_color);
+            }
         }
     }
     // Handle newline character
@@ -96,7 +181,9 @@ void terminal_putchar(char c, uint8_t color) {
     // Handle all other, normal characters
     else {
         const size_t index = terminal_row * VGA_WIDTH + terminal_column;
-        VGA_MEMORY[index] = vga_entry(c, terminal_color);
+        if (vga) {
+            VGA_MEMORY[index] = vga_entry(c, terminal_color);
+        }
         if (++terminal_column == VGA_WIDTH) {
             terminal_column = 0;
             terminal_row++;
@@ -109,7 +196,7 @@ void terminal_putchar(char c, uint8_t color) {
     }
 
     // After ANY action, update the hardware cursor's physical position
-    terminal_set_cursor(terminal_column, terminal_row);
+    vga_update_cursor();
 
     terminal_color = orig_term_color;
 }
@@ -26,9 +26,21 @@ enum fgcolor {
     FG_WHITE         =   0x0F
 };
 
+// Where console output goes, set from console= on the kernel command line.
+// With the serial port, keys typed on the other end reach the shell too.
+typedef enum {
+    CONSOLE_VGA,    // The screen only (the default)
+    CONSOLE_SERIAL, // COM1 instead of the screen
+    CONSOLE_BOTH    // Mirrored to COM1
+} console_mode_t;
+
 /* Function to initialize the terminal */
 void terminal_initialize(void);
 
+// Switches the console. Needs serial_init() to have found a UART for
+// anything but CONSOLE_VGA.
+void terminal_set_console(console_mode_t mode);
+
 void terminal_clear();
 
 void terminal_set_cursor(size_t x, size_t y);
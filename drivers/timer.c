@@ -0,0 +1,168 @@
+#include "timer.h"
+#include "terminal.h"
+#include "../io/io.h"
+#include "../lib/math.h"
+#include "../src/cpu.h"
+#include "../src/cpu_features.h"
+
+// PIT ports and input clock
+#define PIT_CHANNEL0    0x40
+#define PIT_CHANNEL2    0x42
+#define PIT_COMMAND     0x43
+#define PIT_GATE_PORT   0x61  // Bit 0: channel 2 gate, bit 5: channel 2 output
+#define PIT_FREQUENCY   1193182
+
+#define PIT_DIVISOR     ((PIT_FREQUENCY + TIMER_HZ / 2) / TIMER_HZ)
+// Real tick length, since the divisor doesn't divide the PIT clock evenly
+#define PIT_NS_PER_TICK ((uint32_t)((uint64_t)PIT_DIVISOR * NSEC_PER_SEC / PIT_FREQUENCY))
+// Nominal tick length, for ticks derived from the TSC
+#define NS_PER_TICK     (NSEC_PER_SEC / TIMER_HZ)
+
+#define CALIBRATE_MS        10
+#define CALIBRATE_ATTEMPTS  3
+
+static volatile uint64_t ticks = 0;
+
+static bool tsc_available = false;
+static uint32_t tsc_khz = 0;
+static uint64_t tsc_base = 0;
+
+// Cycles are converted to ns as (cycles * tsc_mult) >> tsc_shift
+static uint32_t tsc_mult = 0;
+static uint32_t tsc_shift = 0;
+
+// --- Internal Helper Functions ---
+
+// Busy-waits 'count' PIT input clocks (at most 0xFFFF) on channel 2.
+// Channel 2 is used because it can be polled without interrupts.
+static void pit_channel2_wait(uint32_t count) {
+    uint8_t gate = inb(PIT_GATE_PORT);
+    outb(PIT_GATE_PORT, (gate & ~0x02) | 0x01); // Gate on, speaker off
+
+    outb(PIT_COMMAND, 0xB0); // Channel 2, lo/hi byte, mode 0 (one-shot)
+    outb(PIT_CHANNEL2, count & 0xFF);
+    outb(PIT_CHANNEL2, (count >> 8) & 0xFF);
+
+    while (!(inb(PIT_GATE_PORT) & 0x20)) {
+        // Output goes high when the count reaches zero
+    }
+
+    outb(PIT_GATE_PORT, gate);
+}
+
+// Returns the TSC cycles that elapse during a CALIBRATE_MS channel 2 wait.
+static uint64_t timer_measure_tsc(void) {
+    uint64_t start = rdtsc();
+    pit_channel2_wait(PIT_FREQUENCY * CALIBRATE_MS / 1000);
+    return rdtsc() - start;
+}
+
+// (a * mult) >> shift without losing the high bits of the 96-bit product.
+static uint64_t mul_u64_u32_shr(uint64_t a, uint32_t mult, uint32_t shift) {
+    uint64_t low = (uint64_t)(uint32_t)a * mult;
+    uint64_t high = (a >> 32) * mult;
+    return (low >> shift) + (high << (32 - shift));
+}
+
+static void timer_calibrate_tsc(void) {
+    if (!cpu_has(CPU_FEATURE_TSC)) {
+        return;
+    }
+
+    // Keep the shortest run: anything longer was stretched by interference
+    uint64_t best = 0;
+    for (int i = 0; i < CALIBRATE_ATTEMPTS; i++) {
+        uint64_t cycles = timer_measure_tsc();
+        if (best == 0 || cycles < best) {
+            best = cycles;
+        }
+    }
+    tsc_khz = (uint32_t)div_u64_rem(best, CALIBRATE_MS, NULL);
+    if (tsc_khz == 0) {
+        return;
+    }
+
+    // Largest shift whose multiplier still fits in 32 bits
+    for (tsc_shift = 32; tsc_shift > 0; tsc_shift--) {
+        uint64_t mult = div_u64_rem(1000000ull << tsc_shift, tsc_khz, NULL);
+        if (mult <= 0xFFFFFFFF) {
+            tsc_mult = (uint32_t)mult;
+            break;
+        }
+    }
+
+    tsc_available = true;
+    tsc_base = rdtsc();
+}
+
+// --- Public API Functions ---
+
+void timer_init(void) {
+    timer_calibrate_tsc();
+
+    outb(PIT_COMMAND, 0x34); // Channel 0, lo/hi byte, mode 2 (rate generator)
+    outb(PIT_CHANNEL0, PIT_DIVISOR & 0xFF);
+    outb(PIT_CHANNEL0, (PIT_DIVISOR >> 8) & 0xFF);
+
+    if (!tsc_available) {
+        terminal_printf("Timer: no TSC, using %d Hz ticks.\n", FG_YELLOW, TIMER_HZ);
+    }
+}
+
+void timer_handler(void) {
+    ticks++;
+}
+
+void timer_stop_periodic(void) {
+    // Mode 0 counts down once and then stays quiet: at most one more IRQ0
+    outb(PIT_COMMAND, 0x30); // Channel 0, lo/hi byte, mode 0
+    outb(PIT_CHANNEL0, 1);
+    outb(PIT_CHANNEL0, 0);
+}
+
+uint64_t timer_get_ticks(void) {
+    if (tsc_available) {
+        return div_u64_rem(ktime_ns(), NS_PER_TICK, NULL);
+    }
+
+    // 64-bit reads aren't atomic on i386, and the tick may be advanced by
+    // another CPU: read until two loads agree
+    uint64_t value, check;
+    do {
+        value = ticks;
+        check = ticks;
+    } while (value != check);
+    return value;
+}
+
+uint64_t ktime_cycles(void) {
+    return tsc_available ? rdtsc() : 0;
+}
+
+uint64_t ktime_ns(void) {
+    if (!tsc_available) {
+        return timer_get_ticks() * PIT_NS_PER_TICK;
+    }
+    return mul_u64_u32_shr(rdtsc() - tsc_base, tsc_mult, tsc_shift);
+}
+
+void timer_udelay(uint32_t us) {
+    if (tsc_available) {
+        uint64_t end = ktime_ns() + (uint64_t)us * 1000;
+        while (ktime_ns() < end) {
+            asm volatile("pause");
+        }
+        return;
+    }
+
+    // No TSC: chain channel 2 one-shots, each at most ~50 ms long
+    while (us > 0) {
+        uint32_t chunk = us > 50000 ? 50000 : us;
+        pit_channel2_wait((uint32_t)div_u64_rem((uint64_t)chunk * PIT_FREQUENCY, 1000000, NULL));
+        us -= chunk;
+    }
+}
+
+uint32_t timer_get_tsc_khz(void) {
+    return tsc_khz;
+}
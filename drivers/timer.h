@@ -0,0 +1,41 @@
+#ifndef TIMER_H
+#define TIMER_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+// --- Timekeeping ---
+// The TSC is calibrated against PIT channel 2 at boot and used for
+// nanosecond timestamps, and the tick count is derived from it, so no
+// periodic interrupt is needed to keep time. On CPUs without a TSC the PIT
+// drives a periodic tick on IRQ0 and timestamps fall back to its resolution.
+
+#define TIMER_HZ 1000
+#define NSEC_PER_SEC 1000000000u
+
+// Programs the PIT and calibrates the TSC. Interrupts may still be off.
+void timer_init(void);
+
+// IRQ0 handler: advances the tick count (when there is no TSC).
+void timer_handler(void);
+
+// Silences the PIT's periodic IRQ0 once per-CPU one-shot timers take over.
+// Only valid with a TSC, which then keeps the tick count.
+void timer_stop_periodic(void);
+
+// Ticks since timer_init(), at TIMER_HZ.
+uint64_t timer_get_ticks(void);
+
+// Raw cycle counter (the TSC), or 0 if the CPU has none.
+uint64_t ktime_cycles(void);
+
+// Monotonic nanoseconds since timer_init().
+uint64_t ktime_ns(void);
+
+// Busy-waits at least 'us' microseconds. Works with interrupts disabled.
+void timer_udelay(uint32_t us);
+
+// Calibrated TSC frequency in kHz, or 0 if there is no TSC.
+uint32_t timer_get_tsc_khz(void);
+
+#endif // TIMER_H
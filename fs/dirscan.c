@@ -0,0 +1,177 @@
+#include "dirscan.h"
+#include "../src/fpu.h"
+#include "../src/cpu_features.h"
+#include "../lib/string.h"
+#include <stddef.h>
+
+#define DIRSCAN_GROUP   4
+
+#define ENTRY_DELETED   0xE5
+
+// Bits of the byte masks, for the first and second 16 bytes of an entry
+#define MASK_FIRST      0x0001 // name[0]: end marker or deleted
+#define MASK_NAME       0x07FF // name[0..10]
+#define MASK_ATTR       0x0800 // attr, compared with ATTR_LONG_FILE_NAME
+#define MASK_CLUSTER    0x0C30 // fst_clus_hi (bytes 4-5) and fst_clus_lo (10-11)
+
+typedef enum {
+    DIRSCAN_NAME,
+    DIRSCAN_CLUSTER,
+    DIRSCAN_FREE
+} dirscan_kind_t;
+
+// Bit n of 'eq' is set if byte n of 16 equals byte n of the key, bit n of
+// 'zero' if it is zero.
+typedef struct {
+    uint32_t eq;
+    uint32_t zero;
+} dirscan_masks_t;
+
+typedef uint32_t __attribute__((may_alias)) word_t;
+
+typedef uint32_t (*dirscan_fn_t)(const FAT32_DirectoryEntry* entries, uint32_t count, dirscan_kind_t kind, const uint8_t* key, bool* end);
+
+static uint32_t dirscan_scalar(const FAT32_DirectoryEntry* entries, uint32_t count, dirscan_kind_t kind, const uint8_t* key, bool* end);
+
+// Picked by dirscan_init()
+static dirscan_fn_t dirscan = dirscan_scalar;
+
+// --- Internal Helper Functions ---
+
+static inline dirscan_masks_t masks_sse2(const uint8_t* bytes, const uint8_t* key) {
+    dirscan_masks_t masks;
+    asm volatile("movdqu (%2), %%xmm0\n\t"
+                 "movdqu (%3), %%xmm1\n\t"
+                 "pxor %%xmm2, %%xmm2\n\t"
+                 "pcmpeqb %%xmm0, %%xmm1\n\t"
+                 "pcmpeqb %%xmm0, %%xmm2\n\t"
+                 "pmovmskb %%xmm1, %0\n\t"
+                 "pmovmskb %%xmm2, %1"
+                 : "=r"(masks.eq), "=r"(masks.zero)
+                 : "r"(bytes), "r"(key)
+                 : "memory");
+    return masks;
+}
+
+// Which bytes of 'a' and 'b' are equal, as 4 bits. Exact, unlike the
+// has-zero-byte trick: the high bit of each byte of 'differ' is set iff
+// any bit of that byte of a ^ b is, and the multiply gathers the four
+// high bits into bits 21-24.
+static inline uint32_t swar_equal_bytes(uint32_t a, uint32_t b) {
+    uint32_t x = a ^ b;
+    uint32_t differ = ((x & 0x7F7F7F7F) + 0x7F7F7F7F) | x;
+    uint32_t equal = ~differ & 0x80808080;
+    return (((equal >> 7) * 0x00204081) >> 21) & 0xF;
+}
+
+static dirscan_masks_t masks_scalar(const uint8_t* bytes, const uint8_t* key) {
+    dirscan_masks_t masks = { 0, 0 };
+    for (int i = 0; i < 4; i++) {
+        uint32_t word = ((const word_t*)bytes)[i];
+        masks.eq |= swar_equal_bytes(word, ((const word_t*)key)[i]) << (i * 4);
+        masks.zero |= swar_equal_bytes(word, 0) << (i * 4);
+    }
+    return masks;
+}
+
+static inline dirscan_masks_t entry_masks(const uint8_t* bytes, const uint8_t* key, bool sse2) {
+    return sse2 ? masks_sse2(bytes, key) : masks_scalar(bytes, key);
+}
+
+// Runs a query whose 32-byte key matches the entry layout: the first 16
+// bytes are always compared, the second only for cluster queries. Inlined
+// into each variant below so 'sse2' is a constant there.
+static inline __attribute__((always_inline)) uint32_t dirscan_run(const FAT32_DirectoryEntry* entries, uint32_t count, dirscan_kind_t kind, const uint8_t* key, bool* end, bool sse2) {
+    uint32_t result = DIRSCAN_NONE;
+    bool saw_end = false;
+
+    for (uint32_t base = 0; base < count; base += DIRSCAN_GROUP) {
+        uint32_t hits = 0;
+        uint32_t ends = 0;
+        for (uint32_t j = 0; j < DIRSCAN_GROUP && base + j < count; j++) {
+            const uint8_t* bytes = (const uint8_t*)&entries[base + j];
+            dirscan_masks_t first = entry_masks(bytes, key, sse2);
+            uint32_t hit;
+            if (kind == DIRSCAN_NAME) {
+                // Name bytes equal, attr not LFN. A valid name never starts
+                // with 0x00 or 0xE5, so this also rules out those slots.
+                hit = (first.eq & (MASK_NAME | MASK_ATTR)) == MASK_NAME;
+            } else if (kind == DIRSCAN_CLUSTER) {
+                // Key byte 0 is 0xE5 and byte 11 ATTR_LONG_FILE_NAME, so a
+                // live entry matches neither
+                dirscan_masks_t second = entry_masks(bytes + 16, key + 16, sse2);
+                hit = ((first.eq & (MASK_FIRST | MASK_ATTR)) == 0) &
+                      ((second.eq & MASK_CLUSTER) == MASK_CLUSTER);
+            } else {
+                hit = (first.eq | first.zero) & MASK_FIRST;
+            }
+            hits |= hit << j;
+            ends |= (first.zero & MASK_FIRST) << j;
+        }
+
+        if (kind != DIRSCAN_FREE) {
+            hits &= ~ends; // The end marker is never an answer, only a stop
+        }
+        uint32_t stop = hits | ends;
+        if (stop != 0) {
+            uint32_t j = __builtin_ctz(stop);
+            if (hits & (1u << j)) {
+                result = base + j;
+            } else {
+                saw_end = true;
+            }
+            break;
+        }
+    }
+
+    if (end != NULL) {
+        *end = saw_end;
+    }
+    return result;
+}
+
+static uint32_t dirscan_sse2(const FAT32_DirectoryEntry* entries, uint32_t count, dirscan_kind_t kind, const uint8_t* key, bool* end) {
+    uint32_t flags = kernel_fpu_begin();
+    uint32_t result = dirscan_run(entries, count, kind, key, end, true);
+    kernel_fpu_end(flags);
+    return result;
+}
+
+static uint32_t dirscan_scalar(const FAT32_DirectoryEntry* entries, uint32_t count, dirscan_kind_t kind, const uint8_t* key, bool* end) {
+    return dirscan_run(entries, count, kind, key, end, false);
+}
+
+// --- Public API Functions ---
+
+void dirscan_init(void) {
+    static const cpu_impl_t impls[] = {
+        { "SSE2 pcmpeqb", CPU_FEATURE_BIT(CPU_FEATURE_SSE2), dirscan_sse2 },
+        { "SWAR", 0, dirscan_scalar },
+    };
+    static cpu_dispatch_t dispatch = { "FAT32 dir scan", (void**)&dirscan, impls, 2, NULL, NULL };
+    cpu_dispatch_select(&dispatch);
+}
+
+uint32_t dirscan_find_name(const FAT32_DirectoryEntry* entries, uint32_t count, const char name[11], bool* end) {
+    uint8_t key[32] = { 0 };
+    memcpy(key, name, 11);
+    key[11] = ATTR_LONG_FILE_NAME;
+    return dirscan(entries, count, DIRSCAN_NAME, key, end);
+}
+
+uint32_t dirscan_find_cluster(const FAT32_DirectoryEntry* entries, uint32_t count, uint32_t cluster, bool* end) {
+    uint8_t key[32] = { 0 };
+    key[0] = ENTRY_DELETED;
+    key[11] = ATTR_LONG_FILE_NAME;
+    key[16 + 4] = (cluster >> 16) & 0xFF;  // fst_clus_hi
+    key[16 + 5] = (cluster >> 24) & 0xFF;
+    key[16 + 10] = cluster & 0xFF;         // fst_clus_lo
+    key[16 + 11] = (cluster >> 8) & 0xFF;
+    return dirscan(entries, count, DIRSCAN_CLUSTER, key, end);
+}
+
+uint32_t dirscan_find_free(const FAT32_DirectoryEntry* entries, uint32_t count) {
+    uint8_t key[32] = { 0 };
+    key[0] = ENTRY_DELETED;
+    return dirscan(entries, count, DIRSCAN_FREE, key, NULL);
+}
@@ -0,0 +1,36 @@
+#ifndef DIRSCAN_H
+#define DIRSCAN_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "fat32.h"
+
+// --- Directory Cluster Scanning ---
+// Searches a cluster's worth of 32-byte directory entries in one pass.
+// Each entry's halves are compared with a 16-byte key in a single SSE2
+// compare (or with 32-bit SWAR compares on CPUs without SSE2), giving a
+// byte mask that says at once whether the name matches, whether it is an
+// LFN or deleted entry, and whether it ends the directory. Entries are
+// classified in groups of four with one branch per group.
+//
+// Every scan stops at the end-of-directory marker and returns the index of
+// the first matching entry before it, or DIRSCAN_NONE. '*end' tells the
+// caller whether the marker was seen, so there is no point reading the
+// directory's next cluster.
+
+#define DIRSCAN_NONE 0xFFFFFFFF
+
+// Picks the SSE2 or SWAR scan for this CPU. Call after fpu_init(); until
+// then the SWAR one is used.
+void dirscan_init(void);
+
+// First live 8.3 entry whose name is 'name' (11 bytes, padded as on disk).
+uint32_t dirscan_find_name(const FAT32_DirectoryEntry* entries, uint32_t count, const char name[11], bool* end);
+
+// First live, non-LFN entry whose first cluster is 'cluster'.
+uint32_t dirscan_find_cluster(const FAT32_DirectoryEntry* entries, uint32_t count, uint32_t cluster, bool* end);
+
+// First slot a new entry can use: a deleted entry or the end marker.
+uint32_t dirscan_find_free(const FAT32_DirectoryEntry* entries, uint32_t count);
+
+#endif // DIRSCAN_H
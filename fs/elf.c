@@ -1,71 +1,106 @@
 #include "elf.h"
 #include "../drivers/terminal.h" // For printing errors
-#include "../memory/heap.h"      // For malloc/free
+#include "pagecache.h"             // For pagecache_read
 #include "../lib/string.h"       // For memcpy and memset
+#include "../memory/paging.h"    // For mapping the segments' pages
+#include "../src/process.h"      // For the user address window
 
-uint32_t elf_load(FAT32_DirectoryEntry* file) {
+// Backs [start, end) with zeroed user pages, skipping pages an earlier
+// segment already mapped. Advances *image_end past everything mapped.
+static bool elf_map_segment(uint32_t start, uint32_t end, uint32_t* image_end) {
+    for (uint32_t vaddr = start & PAGE_FRAME_MASK; vaddr < end; vaddr += PAGE_SIZE) {
+        if (paging_get_entry(vaddr) & PAGE_PRESENT) {
+            continue;
+        }
+        void* frame = pmm_alloc_zeroed_page();
+        if (frame == NULL || !paging_map_page(vaddr, (uint32_t)frame, PAGE_WRITABLE | PAGE_USER)) {
+            if (frame != NULL) {
+                pmm_free_page(frame);
+            }
+            return false;
+        }
+        if (vaddr + PAGE_SIZE > *image_end) {
+            *image_end = vaddr + PAGE_SIZE;
+        }
+    }
+    return true;
+}
+
+uint32_t elf_load(FAT32_DirectoryEntry* file, uint32_t* image_end) {
     if (file == NULL) {
         return 0; // Invalid file entry
     }
 
-    // 1. Read the entire file into a temporary buffer in memory.
-    // This is necessary because we need to seek to different parts of the file
-    // (program headers, code sections) and the FAT32 driver doesn't support seeking.
-    uint8_t* file_buffer = malloc(file->file_size);
-    if (!file_buffer) {
-        terminal_printf("ELF Error: Not enough memory to load file.\n", FG_RED);
+    uint32_t start_cluster = (file->fst_clus_hi << 16) | file->fst_clus_lo;
+    uint32_t file_size = file->file_size;
+
+    // 1. Read just the ELF header through the page cache.
+    // Everything below copies straight from cached pages, so we never need
+    // a temporary buffer the size of the whole file.
+    Elf32_Ehdr header;
+    if (pagecache_read(start_cluster, file_size, 0, &header, sizeof(header)) != sizeof(header)) {
+        terminal_printf("ELF Error: Not a valid ELF file.\n", FG_RED);
         return 0;
     }
-    fat32_read_file(file, file_buffer);
 
-    // 2. The ELF header is at the very beginning of the file buffer.
-    // We cast the buffer pointer to the header struct type.
-    Elf32_Ehdr* header = (Elf32_Ehdr*)file_buffer;
-
-    // 3. Validate the ELF Magic Number to ensure it's an ELF file.
-    if (header->e_ident[0] != ELFMAG0 || header->e_ident[1] != ELFMAG1 ||
-        header->e_ident[2] != ELFMAG2 || header->e_ident[3] != ELFMAG3) {
+    // 2. Validate the ELF Magic Number to ensure it's an ELF file.
+    if (header.e_ident[0] != ELFMAG0 || header.e_ident[1] != ELFMAG1 ||
+        header.e_ident[2] != ELFMAG2 || header.e_ident[3] != ELFMAG3) {
         terminal_printf("ELF Error: Not a valid ELF file.\n", FG_RED);
-        free(file_buffer);
         return 0;
     }
 
     // You could add more validation here, e.g., check for 32-bit, executable type, etc.
 
-    // 4. Get the location of the program header table from the main header.
-    Elf32_Phdr* p_headers = (Elf32_Phdr*)(file_buffer + header->e_phoff);
-
-    // 5. Loop through all the program headers.
-    for (int i = 0; i < header->e_phnum; i++) {
-        Elf32_Phdr* phdr = &p_headers[i];
+    // 3. Loop through all the program headers.
+    for (int i = 0; i < header.e_phnum; i++) {
+        Elf32_Phdr phdr;
+        uint32_t phdr_offset = header.e_phoff + i * sizeof(Elf32_Phdr);
+        if (pagecache_read(start_cluster, file_size, phdr_offset, &phdr, sizeof(phdr)) != sizeof(phdr)) {
+            terminal_printf("ELF Error: Truncated program header table.\n", FG_RED);
+            return 0;
+        }
 
         // We only care about program headers of type 'PT_LOAD', as these
         // describe segments that need to be loaded into memory.
-        if (phdr->p_type == PT_LOAD) {
-            // Copy the segment from the file buffer into its target memory location.
+        if (phdr.p_type == PT_LOAD) {
+            // Programs run in ring 3, so every segment must land in the
+            // user window, on pages of its own
+            if (phdr.p_vaddr < USER_SPACE_START || phdr.p_memsz > USER_IMAGE_END - phdr.p_vaddr ||
+                phdr.p_filesz > phdr.p_memsz) {
+                terminal_printf("ELF Error: Segment at %x is outside user space.\n", FG_RED, phdr.p_vaddr);
+                return 0;
+            }
+            if (!elf_map_segment(phdr.p_vaddr, phdr.p_vaddr + phdr.p_memsz, image_end)) {
+                terminal_printf("ELF Error: Out of memory.\n", FG_RED);
+                return 0;
+            }
+
+            // Copy the segment from the cached file pages into its target memory location.
             // p_vaddr: The virtual address where the segment should be loaded.
-            // file_buffer + p_offset: The location of the segment data within the file.
+            // p_offset: The location of the segment data within the file.
             // p_filesz: The size of the segment in the file.
-            memcpy((void*)phdr->p_vaddr, file_buffer + phdr->p_offset, phdr->p_filesz);
+            pagecache_read(start_cluster, file_size, phdr.p_offset, (void*)phdr.p_vaddr, phdr.p_filesz);
 
             // The .bss section is uninitialized data. The ELF format specifies this
             // by having p_memsz (memory size) be larger than p_filesz (file size).
             // We must zero out this extra space.
-            if (phdr->p_memsz > phdr->p_filesz) {
-                uint32_t bss_start = phdr->p_vaddr + phdr->p_filesz;
-                uint32_t bss_size = phdr->p_memsz - phdr->p_filesz;
+            if (phdr.p_memsz > phdr.p_filesz) {
+                uint32_t bss_start = phdr.p_vaddr + phdr.p_filesz;
+                uint32_t bss_size = phdr.p_memsz - phdr.p_filesz;
                 memset((void*)bss_start, 0, bss_size);
             }
         }
     }
 
     // The entry point address is stored in the main header.
-    uint32_t entry_point = header->e_entry;
-
-    // 6. Clean up the temporary file buffer.
-    free(file_buffer);
+    uint32_t entry_point = header.e_entry;
+    if (entry_point < USER_SPACE_START || entry_point >= *image_end) {
+        terminal_printf("ELF Error: Entry point %x is not in a loaded segment.\n", FG_RED, entry_point);
+        return 0;
+    }
 
-    // 7. Return the entry point address. The kernel can now jump to this.
+    // 4. Return the entry point address. The kernel can now jump to this.
     return entry_point;
 }
 
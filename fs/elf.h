@@ -62,13 +62,16 @@ typedef struct {
 /**
  * @brief Loads and validates an ELF executable from a FAT32 directory entry.
  *
- * This function reads the ELF headers from the file, validates it, and copies
- * the loadable segments into memory at their specified virtual addresses.
+ * This function reads the ELF headers from the file, validates it, maps fresh
+ * user pages for the loadable segments and copies them in at their specified
+ * virtual addresses, which must lie in the user window (see process.h).
  *
  * @param file A pointer to the FAT32 directory entry of the executable.
+ * @param image_end Advanced past every page mapped, even on failure, so the
+ *                  caller knows what to free. Start it at USER_SPACE_START.
  * @return The virtual address of the program's entry point, or 0 on failure.
  */
-uint32_t elf_load(FAT32_DirectoryEntry* file);
+uint32_t elf_load(FAT32_DirectoryEntry* file, uint32_t* image_end);
 
 #endif // ELF_H
 
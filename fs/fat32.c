@@ -3,6 +3,11 @@
 #include "../drivers/terminal.h"
 #include "../lib/string.h"
 #include "../memory/heap.h"
+#include "../memory/pmm.h"
+#include "pagecache.h"
+#include "dirscan.h"
+#include "../src/taskpool.h"
+#include "../src/trace.h"
 #include <stddef.h>
 #include <stdbool.h>
 
@@ -25,20 +30,39 @@ bool g_fat_ready = false;
 // It's crucial to define the End of Chain (EOC) marker for FAT32.
 #define FAT32_EOC_MARK 0x0FFFFFFF
 
+// The free cluster scan reads this many FAT sectors per disk command and
+// splits them into parallel_for() chunks of FAT32_SCAN_CHUNK entries.
+#define FAT32_SCAN_SECTORS 64
+#define FAT32_SCAN_CHUNK   2048
+
+// State shared by the tasks scanning one batch of FAT sectors
+typedef struct {
+    const uint32_t* entries;
+    uint32_t first_cluster;      // Cluster number of entries[0]
+    volatile uint32_t found;     // Lowest free cluster seen, or 0xFFFFFFFF
+} fat32_scan_t;
+
 // --- Forward declarations for static helper functions ---
 static uint32_t cluster_to_lba(uint32_t cluster);
 static uint32_t fat32_get_next_cluster(uint32_t current_cluster);
 static void fat32_set_fat_entry(uint32_t cluster_num, uint32_t value);
 static uint32_t fat32_find_free_cluster();
+static uint32_t fat32_find_free_run(uint32_t count);
 static dir_entry_location_t find_free_directory_entry(uint32_t start_cluster);
 static void to_fat32_filename(const char* filename, char* out_name);
+static bool fat32_chain_transfer(uint32_t start_cluster, uint32_t offset, uint8_t* buffer, uint32_t sector_count, bool write);
 uint32_t fat32_get_fat_entry(uint32_t cluster);
 uint64_t getTotalDriveSpace(const FAT32_BootSector* bpb);
+uint32_t get_total_sectors(const FAT32_BootSector* bpb);
 
 // --- Public API Functions ---
 
 void fat32_init() {
-    ide_read_sectors(0, 1, (uint8_t*)&g_boot_sector);
+    // The sector is bigger than the BPB; reading it straight into
+    // g_boot_sector would overwrite whatever follows it in memory
+    uint8_t sector[512];
+    ide_read_sectors(0, 1, sector);
+    memcpy(&g_boot_sector, sector, sizeof(g_boot_sector));
 
     if (g_boot_sector.bytes_per_sec == 0) {
         terminal_printf("Error: Invalid FAT32 volume.\n", FG_RED);
@@ -108,38 +132,46 @@ void fat32_list_dir(uint32_t start_cluster) {
 void fat32_read_file(FAT32_DirectoryEntry* entry, void* buffer) {
     if (!g_fat_ready || entry == NULL || buffer == NULL) return;
 
-    uint8_t* out_buffer = (uint8_t*)buffer;
-    uint32_t current_cluster = (entry->fst_clus_hi << 16) | entry->fst_clus_lo;
-    uint32_t file_size = entry->file_size;
-    uint32_t bytes_read = 0;
-    uint32_t cluster_size_bytes = g_fat32_fs_info.sectors_per_cluster * g_fat32_fs_info.bytes_per_sec;
+    uint32_t start_cluster = (entry->fst_clus_hi << 16) | entry->fst_clus_lo;
+    if (start_cluster < 2 || entry->file_size == 0) return;
 
-    // Allocate a temporary buffer to read full clusters from disk
-    uint8_t* temp_cluster_buffer = malloc(cluster_size_bytes);
-    if(temp_cluster_buffer == NULL) {
-        terminal_printf("Error: Not enough memory to read file\n", FG_RED);
-        return;
-    }
+    // Served from the page cache; only missing pages touch the disk
+    pagecache_read(start_cluster, entry->file_size, 0, buffer, entry->file_size);
+}
 
-    while (current_cluster < 0x0FFFFFF8 && bytes_read < file_size) {
-        // Read the full cluster from disk into a temporary buffer
-        uint32_t lba = cluster_to_lba(current_cluster);
-        ide_read_sectors(lba, g_fat32_fs_info.sectors_per_cluster, temp_cluster_buffer);
+bool fat32_read_file_page(uint32_t start_cluster, uint32_t file_size, uint32_t page_index, void* page) {
+    if (!g_fat_ready || start_cluster < 2 || page == NULL) return false;
 
-        // Determine how many bytes to actually copy from this cluster
-        uint32_t bytes_to_copy = file_size - bytes_read;
-        if (bytes_to_copy > cluster_size_bytes) {
-            bytes_to_copy = cluster_size_bytes;
-        }
+    uint32_t offset = page_index * PAGE_SIZE;
+    if (offset >= file_size) return false;
 
-        // Copy only the necessary bytes to the final buffer
-        memcpy(out_buffer + bytes_read, temp_cluster_buffer, bytes_to_copy);
+    uint32_t valid_bytes = MIN(file_size - offset, PAGE_SIZE);
+    uint32_t sectors = (valid_bytes + g_fat32_fs_info.bytes_per_sec - 1) / g_fat32_fs_info.bytes_per_sec;
 
-        bytes_read += bytes_to_copy;
-        current_cluster = fat32_get_next_cluster(current_cluster);
+    // Sectors go straight into the page, no cluster bounce buffer needed.
+    bool ok = fat32_chain_transfer(start_cluster, offset, (uint8_t*)page, sectors, false);
+    TRACE(TRACE_FAT32_READ_PAGE, start_cluster, page_index, ok, 0);
+    if (!ok) {
+        return false;
     }
-    
-    free(temp_cluster_buffer);
+
+    // Don't leak cluster slack past EOF into the page
+    memset((uint8_t*)page + valid_bytes, 0, PAGE_SIZE - valid_bytes);
+    return true;
+}
+
+bool fat32_write_file_page(uint32_t start_cluster, uint32_t file_size, uint32_t page_index, const void* page) {
+    if (!g_fat_ready || start_cluster < 2 || page == NULL) return false;
+
+    uint32_t offset = page_index * PAGE_SIZE;
+    if (offset >= file_size) return false;
+
+    uint32_t valid_bytes = MIN(file_size - offset, PAGE_SIZE);
+    uint32_t sectors = (valid_bytes + g_fat32_fs_info.bytes_per_sec - 1) / g_fat32_fs_info.bytes_per_sec;
+
+    bool ok = fat32_chain_transfer(start_cluster, offset, (uint8_t*)page, sectors, true);
+    TRACE(TRACE_FAT32_WRITE_PAGE, start_cluster, page_index, ok, 0);
+    return ok;
 }
 
 /**
@@ -185,22 +217,14 @@ FAT32_DirectoryEntry* fat32_find_entry_by_cluster(uint32_t cluster_to_find) {
         FAT32_DirectoryEntry* entry = (FAT32_DirectoryEntry*)cluster_buffer;
         uint32_t entries_per_cluster = cluster_size_bytes / sizeof(FAT32_DirectoryEntry);
 
-        for (uint32_t i = 0; i < entries_per_cluster; i++) {
-            if (entry[i].name[0] == 0x00) {
-                free(cluster_buffer);
-                free(found_entry);
-                return NULL;
-            }
-            if ((uint8_t)entry[i].name[0] == 0xE5) continue;
-            if (entry[i].attr == ATTR_LONG_FILE_NAME) continue;
-
-            uint32_t entry_cluster = (entry[i].fst_clus_hi << 16) | entry[i].fst_clus_lo;
-            if (entry_cluster == cluster_to_find) {
-                *found_entry = entry[i];
-                free(cluster_buffer);
-                return found_entry;
-            }
+        bool end;
+        uint32_t i = dirscan_find_cluster(entry, entries_per_cluster, cluster_to_find, &end);
+        if (i != DIRSCAN_NONE) {
+            *found_entry = entry[i];
+            free(cluster_buffer);
+            return found_entry;
         }
+        if (end) break;
         dir_cluster = fat32_get_next_cluster(dir_cluster);
     }
     
@@ -220,7 +244,46 @@ static uint32_t fat32_get_next_cluster(uint32_t current_cluster) {
     return fat32_get_fat_entry(current_cluster);
 }
 
+/**
+ * @brief Reads or writes whole sectors at byte 'offset' of a cluster chain.
+ * @details 'offset' must be sector aligned. Runs of sectors inside one
+ * cluster are issued as a single IDE command.
+ */
+static bool fat32_chain_transfer(uint32_t start_cluster, uint32_t offset, uint8_t* buffer, uint32_t sector_count, bool write) {
+    uint32_t cluster_size_bytes = g_fat32_fs_info.sectors_per_cluster * g_fat32_fs_info.bytes_per_sec;
+    uint32_t current_cluster = start_cluster;
+
+    // Walk the chain to the cluster containing 'offset'
+    for (uint32_t skip = offset / cluster_size_bytes; skip > 0; skip--) {
+        current_cluster = fat32_get_next_cluster(current_cluster);
+        if (current_cluster < 2 || current_cluster >= 0x0FFFFFF8) return false;
+    }
+
+    uint32_t sector_in_cluster = (offset % cluster_size_bytes) / g_fat32_fs_info.bytes_per_sec;
+
+    while (sector_count > 0) {
+        if (current_cluster < 2 || current_cluster >= 0x0FFFFFF8) return false;
+
+        uint32_t run = MIN(g_fat32_fs_info.sectors_per_cluster - sector_in_cluster, sector_count);
+        uint32_t lba = cluster_to_lba(current_cluster) + sector_in_cluster;
+        if (write) {
+            ide_write_sectors(lba, run, buffer);
+        } else {
+            ide_read_sectors(lba, run, buffer);
+        }
+
+        buffer += run * g_fat32_fs_info.bytes_per_sec;
+        sector_count -= run;
+        sector_in_cluster = 0;
+        if (sector_count > 0) {
+            current_cluster = fat32_get_next_cluster(current_cluster);
+        }
+    }
+    return true;
+}
+
 bool fat32_create_file(const char* filename, uint32_t parent_cluster, dir_entry_location_t* out_loc) {
+    TRACE(TRACE_FAT32_CREATE, parent_cluster, 0, 0, 0);
     if (fat32_find_entry_by_name(filename, parent_cluster, NULL, NULL)) {
         terminal_printf("Error: File '%s' already exists.\n", FG_RED, filename);
         return false;
@@ -271,6 +334,7 @@ void fat32_free_cluster_chain(uint32_t start_cluster) {
 }
 
 bool fat32_delete_file(const char* filename, uint32_t parent_cluster) {
+    TRACE(TRACE_FAT32_DELETE, parent_cluster, 0, 0, 0);
     dir_entry_location_t loc;
     FAT32_DirectoryEntry entry;
     if (!fat32_find_entry_by_name(filename, parent_cluster, &loc, &entry)) {
@@ -285,6 +349,7 @@ bool fat32_delete_file(const char* filename, uint32_t parent_cluster) {
     // Free the cluster chain
     uint32_t start_cluster = (entry.fst_clus_hi << 16) | entry.fst_clus_lo;
     if (start_cluster >= 2) {
+        pagecache_invalidate(start_cluster); // Clusters are about to be reused
         fat32_free_cluster_chain(start_cluster);
     }
 
@@ -322,28 +387,25 @@ bool fat32_find_entry_by_name(const char* filename, uint32_t start_cluster, dir_
         FAT32_DirectoryEntry* entries = (FAT32_DirectoryEntry*)cluster_buffer;
         uint32_t entries_per_cluster = cluster_size_bytes / sizeof(FAT32_DirectoryEntry);
 
-        for (uint32_t i = 0; i < entries_per_cluster; i++) {
-            if (entries[i].name[0] == 0x00) { // End of directory
-                free(cluster_buffer);
-                return false;
-            }
-            if ((unsigned char)entries[i].name[0] == 0xE5 || entries[i].attr == ATTR_LONG_FILE_NAME) continue;
-
-            if (strncmp(fat_filename, entries[i].name, 11) == 0) {
-                if (out_entry) *out_entry = entries[i];
-                if (out_loc) {
-                    out_loc->is_valid = true;
-                    uint32_t entry_offset = i * sizeof(FAT32_DirectoryEntry);
-                    out_loc->lba = cluster_to_lba(current_cluster) + (entry_offset / g_boot_sector.bytes_per_sec);
-                    out_loc->offset = entry_offset % g_boot_sector.bytes_per_sec;
-                }
-                free(cluster_buffer);
-                return true;
+        bool end;
+        uint32_t i = dirscan_find_name(entries, entries_per_cluster, fat_filename, &end);
+        if (i != DIRSCAN_NONE) {
+            TRACE(TRACE_FAT32_LOOKUP, start_cluster, 1, ((uint32_t)entries[i].fst_clus_hi << 16) | entries[i].fst_clus_lo, 0);
+            if (out_entry) *out_entry = entries[i];
+            if (out_loc) {
+                out_loc->is_valid = true;
+                uint32_t entry_offset = i * sizeof(FAT32_DirectoryEntry);
+                out_loc->lba = cluster_to_lba(current_cluster) + (entry_offset / g_boot_sector.bytes_per_sec);
+                out_loc->offset = entry_offset % g_boot_sector.bytes_per_sec;
             }
+            free(cluster_buffer);
+            return true;
         }
+        if (end) break; // End of directory
         current_cluster = fat32_get_next_cluster(current_cluster);
     }
     
+    TRACE(TRACE_FAT32_LOOKUP, start_cluster, 0, 0, 0);
     free(cluster_buffer);
     return false;
 }
@@ -358,32 +420,43 @@ static dir_entry_location_t find_free_directory_entry(uint32_t start_cluster) {
     uint8_t* cluster_buffer = malloc(cluster_size_bytes);
     if(cluster_buffer == NULL) return invalid_loc;
 
-    // TODO: This loop does not handle allocating a new cluster if the directory is full
-    // and needs to be extended. This should be added for a robust driver.
-
+    uint32_t last_cluster = current_cluster;
     while (current_cluster < 0x0FFFFFF8) {
+        last_cluster = current_cluster;
         uint32_t lba = cluster_to_lba(current_cluster);
         ide_read_sectors(lba, g_fat32_fs_info.sectors_per_cluster, cluster_buffer);
 
         FAT32_DirectoryEntry* entries = (FAT32_DirectoryEntry*)cluster_buffer;
         uint32_t entries_per_cluster = cluster_size_bytes / sizeof(FAT32_DirectoryEntry);
 
-        for (uint32_t i = 0; i < entries_per_cluster; i++) {
-            if (entries[i].name[0] == 0x00 || (unsigned char)entries[i].name[0] == 0xE5) {
-                dir_entry_location_t loc;
-                loc.is_valid = true;
-                uint32_t entry_offset_in_cluster = i * sizeof(FAT32_DirectoryEntry);
-                loc.lba = cluster_to_lba(current_cluster) + (entry_offset_in_cluster / g_boot_sector.bytes_per_sec);
-                loc.offset = entry_offset_in_cluster % g_boot_sector.bytes_per_sec;
-                free(cluster_buffer);
-                return loc;
-            }
+        uint32_t i = dirscan_find_free(entries, entries_per_cluster);
+        if (i != DIRSCAN_NONE) {
+            dir_entry_location_t loc;
+            loc.is_valid = true;
+            uint32_t entry_offset_in_cluster = i * sizeof(FAT32_DirectoryEntry);
+            loc.lba = cluster_to_lba(current_cluster) + (entry_offset_in_cluster / g_boot_sector.bytes_per_sec);
+            loc.offset = entry_offset_in_cluster % g_boot_sector.bytes_per_sec;
+            free(cluster_buffer);
+            return loc;
         }
         current_cluster = fat32_get_next_cluster(current_cluster);
     }
-    
+
+    // Every slot is taken: grow the directory by one cluster. It is zeroed
+    // (all end-of-directory entries) before the chain points at it.
+    uint32_t new_cluster = fat32_find_free_cluster();
+    if (new_cluster == 0) {
+        free(cluster_buffer);
+        return invalid_loc; // Disk full
+    }
+    memset(cluster_buffer, 0, cluster_size_bytes);
+    ide_write_sectors(cluster_to_lba(new_cluster), g_fat32_fs_info.sectors_per_cluster, cluster_buffer);
+    fat32_set_fat_entry(new_cluster, FAT32_EOC_MARK);
+    fat32_set_fat_entry(last_cluster, new_cluster);
+
     free(cluster_buffer);
-    return invalid_loc; // No free slot found
+    dir_entry_location_t loc = { .is_valid = true, .lba = cluster_to_lba(new_cluster), .offset = 0 };
+    return loc;
 }
 
 /**
@@ -435,37 +508,144 @@ static void fat32_set_fat_entry(uint32_t cluster_num, uint32_t value) {
     free(sector_buffer);
 }
 
+// parallel_for() body: records the first free cluster in its slice of the
+// batch, unless a lower one has already been found.
+static void fat32_scan_free(uint32_t start, uint32_t end, void* arg) {
+    fat32_scan_t* scan = arg;
+    for (uint32_t j = start; j < end; j++) {
+        uint32_t cluster_num = scan->first_cluster + j;
+        if (cluster_num >= scan->found) {
+            return; // Someone found an earlier one
+        }
+        if ((scan->entries[j] & 0x0FFFFFFF) == 0 && cluster_num >= 2) {
+            uint32_t old = scan->found;
+            while (cluster_num < old && !__sync_bool_compare_and_swap(&scan->found, old, cluster_num)) {
+                old = scan->found;
+            }
+            return;
+        }
+    }
+}
+
 static uint32_t fat32_find_free_cluster() {
     if (!g_fat_ready) return 0;
     
     uint32_t entries_per_sector = g_boot_sector.bytes_per_sec / 4;
     uint32_t total_fat_sectors = g_boot_sector.fat_sz32;
 
-    // Allocate a buffer for one sector
-    uint8_t* sector_buffer = malloc(g_fat32_fs_info.bytes_per_sec);
-    if(sector_buffer == NULL) return 0; // Out of memory
+    // Read the FAT in large batches; scanning a batch is split across CPUs
+    uint8_t* batch_buffer = malloc(FAT32_SCAN_SECTORS * g_fat32_fs_info.bytes_per_sec);
+    if(batch_buffer == NULL) return 0; // Out of memory
 
     // Start scan from cluster 2 (0 and 1 are reserved)
-    // We'll skip sector 0 of the FAT which contains clusters 0 and 1
-    for (uint32_t i = 0; i < total_fat_sectors; i++) {
-        uint32_t lba = g_boot_sector.rsvd_sec_cnt + i;
-        ide_read_sectors(lba, 1, sector_buffer);
-        
+    fat32_scan_t scan;
+    scan.entries = (const uint32_t*)batch_buffer;
+    for (uint32_t i = 0; i < total_fat_sectors; i += FAT32_SCAN_SECTORS) {
+        uint32_t sectors = MIN(FAT32_SCAN_SECTORS, total_fat_sectors - i);
+        ide_read_sectors(g_boot_sector.rsvd_sec_cnt + i, sectors, batch_buffer);
+
+        scan.first_cluster = i * entries_per_sector;
+        scan.found = 0xFFFFFFFF;
+        parallel_for(0, sectors * entries_per_sector, FAT32_SCAN_CHUNK, fat32_scan_free, &scan);
+        if (scan.found != 0xFFFFFFFF) {
+            TRACE(TRACE_FAT32_ALLOC_CLUSTER, scan.found, 0, 0, 0);
+            free(batch_buffer);
+            return scan.found;
+        }
+    }
+    
+    TRACE(TRACE_FAT32_ALLOC_CLUSTER, 0, 0, 0, 0);
+    free(batch_buffer);
+    return 0; // Disk full
+}
+
+/**
+ * @brief Finds 'count' consecutive free clusters.
+ * @return The first cluster of the run, or 0 if no run is long enough.
+ */
+static uint32_t fat32_find_free_run(uint32_t count) {
+    if (!g_fat_ready || count == 0) return 0;
+
+    uint32_t entries_per_sector = g_boot_sector.bytes_per_sec / 4;
+    uint32_t data_sectors = get_total_sectors(&g_boot_sector) - g_fat32_fs_info.first_data_sector;
+    uint32_t max_cluster = data_sectors / g_fat32_fs_info.sectors_per_cluster + 2;
+
+    uint8_t* sector_buffer = malloc(g_fat32_fs_info.bytes_per_sec);
+    if(sector_buffer == NULL) return 0;
+
+    uint32_t run_start = 0;
+    uint32_t run_length = 0;
+
+    for (uint32_t i = 0; i < g_boot_sector.fat_sz32; i++) {
+        ide_read_sectors(g_boot_sector.rsvd_sec_cnt + i, 1, sector_buffer);
         uint32_t* fat_entries = (uint32_t*)sector_buffer;
-        
+
         for (uint32_t j = 0; j < entries_per_sector; j++) {
-            if ((fat_entries[j] & 0x0FFFFFFF) == 0x00000000) {
-                uint32_t cluster_num = (i * entries_per_sector) + j;
-                if (cluster_num >= 2) { // Ensure we don't allocate 0 or 1
-                    free(sector_buffer);
-                    return cluster_num;
-                }
+            uint32_t cluster_num = (i * entries_per_sector) + j;
+            if (cluster_num < 2) continue;
+            if (cluster_num >= max_cluster) {
+                free(sector_buffer);
+                return 0;
+            }
+
+            if ((fat_entries[j] & 0x0FFFFFFF) != 0) {
+                run_length = 0;
+                continue;
+            }
+            if (run_length == 0) run_start = cluster_num;
+            if (++run_length == count) {
+                free(sector_buffer);
+                return run_start;
             }
         }
     }
-    
+
     free(sector_buffer);
-    return 0; // Disk full
+    return 0;
+}
+
+bool fat32_allocate_contiguous(FAT32_DirectoryEntry* entry, uint32_t size) {
+    if (!g_fat_ready || entry == NULL || size == 0) return false;
+
+    uint32_t cluster_size_bytes = g_fat32_fs_info.sectors_per_cluster * g_fat32_fs_info.bytes_per_sec;
+    uint32_t needed = (size + cluster_size_bytes - 1) / cluster_size_bytes;
+
+    uint32_t first_cluster = fat32_find_free_run(needed);
+    if (first_cluster == 0) {
+        return false;
+    }
+
+    // Link the run into a chain; the data itself is left as-is on disk
+    for (uint32_t i = 0; i < needed; i++) {
+        uint32_t next = (i + 1 < needed) ? first_cluster + i + 1 : FAT32_EOC_MARK;
+        fat32_set_fat_entry(first_cluster + i, next);
+    }
+
+    entry->fst_clus_hi = (first_cluster >> 16) & 0xFFFF;
+    entry->fst_clus_lo = first_cluster & 0xFFFF;
+    entry->file_size = size;
+    return true;
+}
+
+bool fat32_get_contiguous_extent(uint32_t start_cluster, uint32_t* out_lba, uint32_t* out_sectors) {
+    if (!g_fat_ready || start_cluster < 2) return false;
+
+    uint32_t cluster_count = 1;
+    uint32_t current_cluster = start_cluster;
+    uint32_t next_cluster = fat32_get_next_cluster(current_cluster);
+
+    while (next_cluster >= 2 && next_cluster < 0x0FFFFFF8) {
+        if (next_cluster != current_cluster + 1) {
+            return false; // Fragmented
+        }
+        cluster_count++;
+        current_cluster = next_cluster;
+        next_cluster = fat32_get_next_cluster(current_cluster);
+    }
+
+    *out_lba = cluster_to_lba(start_cluster);
+    *out_sectors = cluster_count * g_fat32_fs_info.sectors_per_cluster;
+    return true;
 }
 
 static void to_fat32_filename(const char* filename, char* out_name) {
@@ -610,9 +790,11 @@ uint32_t fat32_get_parent_cluster(uint32_t cluster) {
 
 bool fat32_write_file(FAT32_DirectoryEntry* entry, const void* buffer, uint32_t size) {
     uint32_t existing_cluster = ((uint32_t)entry->fst_clus_hi << 16) | entry->fst_clus_lo;
+    TRACE(TRACE_FAT32_WRITE_FILE, existing_cluster, size, 0, 0);
 
     // --- 1. Deallocate any existing cluster chain for the file ---
     if (existing_cluster != 0) {
+        pagecache_invalidate(existing_cluster); // Cached pages describe the old contents
         fat32_free_cluster_chain(existing_cluster);
     }
 
@@ -815,13 +997,19 @@ bool fat32_create_directory(const char* dirname, uint32_t parent_cluster) {
 
     // --- Initialize the new directory's cluster (. and ..) ---
     uint32_t cluster_size_bytes = g_fat32_fs_info.sectors_per_cluster * g_fat32_fs_info.bytes_per_sec;
-    uint8_t* new_dir_buffer = malloc(cluster_size_bytes);
+
+    // Clusters up to a page come pre-zeroed from the PMM pool; bigger
+    // ones still need a heap buffer and an explicit clear.
+    bool from_pool = cluster_size_bytes <= PAGE_SIZE;
+    uint8_t* new_dir_buffer = from_pool ? pmm_alloc_zeroed_page() : malloc(cluster_size_bytes);
     if(new_dir_buffer == NULL) {
         // This is bad. We've created an entry for a dir we can't initialize.
         // A robust driver would go back and delete the entry.
         return false;
     }
-    memset(new_dir_buffer, 0, cluster_size_bytes);
+    if (!from_pool) {
+        memset(new_dir_buffer, 0, cluster_size_bytes);
+    }
 
     // Create the '.' entry
     FAT32_DirectoryEntry* dot_entry = (FAT32_DirectoryEntry*)new_dir_buffer;
@@ -847,7 +1035,11 @@ bool fat32_create_directory(const char* dirname, uint32_t parent_cluster) {
     ide_write_sectors(new_dir_lba, g_fat32_fs_info.sectors_per_cluster, new_dir_buffer);
     // TODO: Check for ide_write_sectors failure
 
-    free(new_dir_buffer);
+    if (from_pool) {
+        pmm_free_page(new_dir_buffer);
+    } else {
+        free(new_dir_buffer);
+    }
     return true;
 }
 
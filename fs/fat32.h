@@ -80,6 +80,9 @@ typedef struct {
     char vol_lab[12];
 } __attribute__((packed)) disk_info;
 
+// The volume's boot sector, as read by fat32_init().
+extern FAT32_BootSector g_boot_sector;
+
 // --- Public API Functions ---
 
 // Initializes the FAT32 driver by reading the boot sector.
@@ -94,6 +97,22 @@ void fat32_list_dir(uint32_t start_cluster);
 // Reads the contents of a file into a buffer.
 void fat32_read_file(FAT32_DirectoryEntry* entry, void* buffer);
 
+// Reads 4 KiB page 'page_index' of a file straight from its cluster chain,
+// zero-filling whatever lies past the end of the file.
+bool fat32_read_file_page(uint32_t start_cluster, uint32_t file_size, uint32_t page_index, void* page);
+
+// Writes page 'page_index' of a file back in place. The chain is never
+// extended, so only bytes below 'file_size' reach the disk.
+bool fat32_write_file_page(uint32_t start_cluster, uint32_t file_size, uint32_t page_index, const void* page);
+
+// Gives an empty file 'size' bytes of physically contiguous clusters
+// without writing any data. The caller writes the entry back to disk.
+bool fat32_allocate_contiguous(FAT32_DirectoryEntry* entry, uint32_t size);
+
+// Resolves a file's cluster chain to a single run of sectors. Fails if the
+// chain is fragmented.
+bool fat32_get_contiguous_extent(uint32_t start_cluster, uint32_t* out_lba, uint32_t* out_sectors);
+
 // Finds a directory entry by its name.
 FAT32_DirectoryEntry* fat32_find_entry(const char* filename, uint32_t start_cluster);
 
@@ -0,0 +1,451 @@
+#include "pagecache.h"
+#include "fat32.h"
+#include "../memory/pmm.h"
+#include "../memory/heap.h"
+#include "../lib/string.h"
+#include "../drivers/terminal.h"
+
+#define MIN(a, b) ((a) < (b) ? (a) : (b))
+
+mutex_t fs_lock = MUTEX_INIT;
+
+// --- Radix Tree ---
+// Each node has 64 slots, so a tree of height h covers page indices below
+// 64^h. A 4 GiB file (2^20 pages) needs at most 4 levels; small files only
+// ever allocate a single node.
+#define RADIX_BITS  6
+#define RADIX_SLOTS (1 << RADIX_BITS)
+#define RADIX_MASK  (RADIX_SLOTS - 1)
+
+typedef struct radix_node {
+    void* slots[RADIX_SLOTS];
+    uint32_t count;             // Number of non-NULL slots
+} radix_node_t;
+
+typedef struct {
+    radix_node_t* root;
+    uint32_t height;            // 0 when the tree is empty
+} radix_tree_t;
+
+// --- Cache Objects ---
+typedef struct pagecache_file {
+    uint32_t start_cluster;     // Identity of the file
+    uint32_t file_size;         // Size the cached pages were filled with
+    uint32_t nr_pages;
+    radix_tree_t pages;         // page index -> pagecache_page_t*
+    struct pagecache_file* next; // Next file in the hash bucket
+} pagecache_file_t;
+
+struct pagecache_page {
+    pagecache_file_t* file;     // NULL once invalidated while still referenced
+    uint32_t index;             // Page index within the file
+    uint32_t frame;             // Physical frame holding the data
+    uint32_t refcount;          // Pins the page (e.g. user mappings)
+    bool referenced;            // Clock "second chance" bit
+    struct pagecache_page* prev; // Circular clock list
+    struct pagecache_page* next;
+};
+
+#define PAGECACHE_FILE_BUCKETS 64
+
+static pagecache_file_t* file_buckets[PAGECACHE_FILE_BUCKETS];
+static pagecache_page_t* clock_hand = NULL;
+static uint32_t cached_pages = 0;
+
+// --- Radix Tree Helpers ---
+
+static uint32_t radix_capacity(uint32_t height) {
+    if (height * RADIX_BITS >= 32) {
+        return 0xFFFFFFFF;
+    }
+    return 1u << (height * RADIX_BITS);
+}
+
+static radix_node_t* radix_new_node(void) {
+    radix_node_t* node = malloc(sizeof(radix_node_t));
+    if (node != NULL) {
+        memset(node, 0, sizeof(radix_node_t));
+    }
+    return node;
+}
+
+static void* radix_lookup(radix_tree_t* tree, uint32_t index) {
+    if (tree->root == NULL || index >= radix_capacity(tree->height)) {
+        return NULL;
+    }
+
+    radix_node_t* node = tree->root;
+    for (uint32_t level = tree->height - 1; level > 0; level--) {
+        node = node->slots[(index >> (level * RADIX_BITS)) & RADIX_MASK];
+        if (node == NULL) {
+            return NULL;
+        }
+    }
+    return node->slots[index & RADIX_MASK];
+}
+
+static bool radix_insert(radix_tree_t* tree, uint32_t index, void* item) {
+    if (tree->root == NULL) {
+        tree->root = radix_new_node();
+        if (tree->root == NULL) return false;
+        tree->height = 1;
+    }
+
+    // Grow the tree upwards until 'index' fits
+    while (index >= radix_capacity(tree->height)) {
+        radix_node_t* node = radix_new_node();
+        if (node == NULL) return false;
+        node->slots[0] = tree->root;
+        node->count = 1;
+        tree->root = node;
+        tree->height++;
+    }
+
+    radix_node_t* node = tree->root;
+    for (uint32_t level = tree->height - 1; level > 0; level--) {
+        uint32_t slot = (index >> (level * RADIX_BITS)) & RADIX_MASK;
+        if (node->slots[slot] == NULL) {
+            node->slots[slot] = radix_new_node();
+            if (node->slots[slot] == NULL) return false;
+            node->count++;
+        }
+        node = node->slots[slot];
+    }
+
+    uint32_t slot = index & RADIX_MASK;
+    if (node->slots[slot] == NULL) {
+        node->count++;
+    }
+    node->slots[slot] = item;
+    return true;
+}
+
+// Clears one slot below 'node'. Returns true if 'node' became empty and
+// was freed, so the caller can clear its own slot in turn.
+static bool radix_remove_at(radix_node_t* node, uint32_t level, uint32_t index) {
+    uint32_t slot = (index >> (level * RADIX_BITS)) & RADIX_MASK;
+    if (node->slots[slot] == NULL) {
+        return false;
+    }
+
+    if (level == 0 || radix_remove_at(node->slots[slot], level - 1, index)) {
+        node->slots[slot] = NULL;
+        node->count--;
+    }
+
+    if (node->count == 0) {
+        free(node);
+        return true;
+    }
+    return false;
+}
+
+static void radix_remove(radix_tree_t* tree, uint32_t index) {
+    if (tree->root == NULL || index >= radix_capacity(tree->height)) {
+        return;
+    }
+    if (radix_remove_at(tree->root, tree->height - 1, index)) {
+        tree->root = NULL;
+        tree->height = 0;
+    }
+}
+
+// Frees every node, handing each stored item to 'visit' first.
+static void radix_destroy_node(radix_node_t* node, uint32_t level, void (*visit)(void*)) {
+    for (uint32_t i = 0; i < RADIX_SLOTS; i++) {
+        if (node->slots[i] == NULL) continue;
+        if (level == 0) {
+            visit(node->slots[i]);
+        } else {
+            radix_destroy_node(node->slots[i], level - 1, visit);
+        }
+    }
+    free(node);
+}
+
+// --- Internal Helper Functions ---
+
+static uint32_t pagecache_hash(uint32_t start_cluster) {
+    return start_cluster % PAGECACHE_FILE_BUCKETS;
+}
+
+static pagecache_file_t* pagecache_find_file(uint32_t start_cluster) {
+    pagecache_file_t* file = file_buckets[pagecache_hash(start_cluster)];
+    while (file != NULL && file->start_cluster != start_cluster) {
+        file = file->next;
+    }
+    return file;
+}
+
+static void pagecache_unlink_file(pagecache_file_t* file) {
+    pagecache_file_t** link = &file_buckets[pagecache_hash(file->start_cluster)];
+    while (*link != NULL && *link != file) {
+        link = &(*link)->next;
+    }
+    if (*link == file) {
+        *link = file->next;
+    }
+}
+
+static void clock_insert(pagecache_page_t* page) {
+    if (clock_hand == NULL) {
+        page->prev = page;
+        page->next = page;
+        clock_hand = page;
+        return;
+    }
+    // New pages go just behind the hand, i.e. they are visited last
+    page->next = clock_hand;
+    page->prev = clock_hand->prev;
+    clock_hand->prev->next = page;
+    clock_hand->prev = page;
+}
+
+static void clock_remove(pagecache_page_t* page) {
+    if (page->next == page) {
+        clock_hand = NULL;
+    } else {
+        if (clock_hand == page) {
+            clock_hand = page->next;
+        }
+        page->prev->next = page->next;
+        page->next->prev = page->prev;
+    }
+    page->prev = page->next = NULL;
+}
+
+static void pagecache_free_page(pagecache_page_t* page) {
+    clock_remove(page);
+    pmm_free_page((void*)page->frame);
+    free(page);
+    cached_pages--;
+}
+
+// Radix destroy callback used by invalidation. Pinned pages are orphaned
+// rather than freed and go away when their last reference is dropped.
+static void pagecache_drop_page(void* item) {
+    pagecache_page_t* page = item;
+    if (page->refcount > 0) {
+        page->file = NULL;
+    } else {
+        pagecache_free_page(page);
+    }
+}
+
+static void pagecache_evict(pagecache_page_t* page) {
+    pagecache_file_t* file = page->file;
+    radix_remove(&file->pages, page->index);
+    file->nr_pages--;
+    pagecache_free_page(page);
+
+    if (file->nr_pages == 0) {
+        pagecache_unlink_file(file);
+        free(file);
+    }
+}
+
+static pagecache_file_t* pagecache_get_file(uint32_t start_cluster, uint32_t file_size) {
+    pagecache_file_t* file = pagecache_find_file(start_cluster);
+
+    // A size mismatch means the pages describe an older version of the file
+    if (file != NULL && file->file_size != file_size) {
+        pagecache_invalidate(start_cluster);
+        file = NULL;
+    }
+    if (file != NULL) {
+        return file;
+    }
+
+    file = malloc(sizeof(pagecache_file_t));
+    if (file == NULL) {
+        return NULL;
+    }
+    memset(file, 0, sizeof(pagecache_file_t));
+    file->start_cluster = start_cluster;
+    file->file_size = file_size;
+
+    uint32_t bucket = pagecache_hash(start_cluster);
+    file->next = file_buckets[bucket];
+    file_buckets[bucket] = file;
+    return file;
+}
+
+// Undoes pagecache_get_file() when a failed fill left the file without
+// pages. Looked up again by cluster, as reclaim may already have freed it.
+static void pagecache_drop_empty_file(uint32_t start_cluster) {
+    pagecache_file_t* file = pagecache_find_file(start_cluster);
+    if (file == NULL || file->nr_pages != 0) {
+        return;
+    }
+    if (file->pages.root != NULL) {
+        // Only nodes a failed insert left behind; there are no pages to visit
+        radix_destroy_node(file->pages.root, file->pages.height - 1, pagecache_drop_page);
+    }
+    pagecache_unlink_file(file);
+    free(file);
+}
+
+// --- Public API Functions ---
+
+void pagecache_init(void) {
+    pmm_register_shrinker(pagecache_shrink);
+}
+
+pagecache_page_t* pagecache_get(uint32_t start_cluster, uint32_t file_size, uint32_t index) {
+    if (start_cluster < 2 || (uint64_t)index * PAGE_SIZE >= file_size) {
+        return NULL;
+    }
+
+    pagecache_file_t* file = pagecache_get_file(start_cluster, file_size);
+    if (file == NULL) {
+        return NULL;
+    }
+
+    pagecache_page_t* page = radix_lookup(&file->pages, index);
+    if (page != NULL) {
+        page->referenced = true;
+        page->refcount++;
+        return page;
+    }
+
+    // Miss: fill a fresh frame straight from the cluster chain. This may
+    // trigger reclaim, which can free 'file' if it had no pages yet, so
+    // look it up again afterwards.
+    void* frame = pmm_alloc_page();
+    if (frame == NULL) {
+        pagecache_drop_empty_file(start_cluster);
+        return NULL;
+    }
+    if (!fat32_read_file_page(start_cluster, file_size, index, frame)) {
+        pmm_free_page(frame);
+        pagecache_drop_empty_file(start_cluster);
+        return NULL;
+    }
+
+    file = pagecache_get_file(start_cluster, file_size);
+    page = malloc(sizeof(pagecache_page_t));
+    if (file == NULL || page == NULL || !radix_insert(&file->pages, index, page)) {
+        if (page != NULL) free(page);
+        pmm_free_page(frame);
+        pagecache_drop_empty_file(start_cluster);
+        return NULL;
+    }
+
+    page->file = file;
+    page->index = index;
+    page->frame = (uint32_t)frame;
+    page->refcount = 1;
+    page->referenced = true;
+    clock_insert(page);
+    file->nr_pages++;
+    cached_pages++;
+
+    return page;
+}
+
+uint32_t pagecache_page_frame(pagecache_page_t* page) {
+    return page->frame;
+}
+
+void pagecache_release(pagecache_page_t* page) {
+    if (page == NULL || page->refcount == 0) {
+        return;
+    }
+    page->refcount--;
+
+    // Orphaned by an invalidation while we held it
+    if (page->refcount == 0 && page->file == NULL) {
+        pagecache_free_page(page);
+    }
+}
+
+bool pagecache_writeback(pagecache_page_t* page) {
+    // Never write an orphaned page: its clusters may belong to another file now
+    if (page == NULL || page->file == NULL) {
+        return false;
+    }
+    return fat32_write_file_page(page->file->start_cluster, page->file->file_size, page->index, (const void*)page->frame);
+}
+
+uint32_t pagecache_read(uint32_t start_cluster, uint32_t file_size, uint32_t offset, void* buffer, uint32_t length) {
+    if (offset >= file_size) {
+        return 0;
+    }
+    length = MIN(length, file_size - offset);
+
+    uint8_t* out = (uint8_t*)buffer;
+    uint32_t copied = 0;
+    uint8_t* bounce = NULL;
+
+    while (copied < length) {
+        uint32_t pos = offset + copied;
+        uint32_t index = pos / PAGE_SIZE;
+        uint32_t in_page = pos % PAGE_SIZE;
+        uint32_t chunk = MIN(PAGE_SIZE - in_page, length - copied);
+
+        pagecache_page_t* page = pagecache_get(start_cluster, file_size, index);
+        if (page != NULL) {
+            memcpy(out + copied, (const uint8_t*)page->frame + in_page, chunk);
+            pagecache_release(page);
+        } else {
+            // No frame to cache into: read this page uncached through a heap buffer
+            if (bounce == NULL) {
+                bounce = malloc(PAGE_SIZE);
+                if (bounce == NULL) break;
+            }
+            if (!fat32_read_file_page(start_cluster, file_size, index, bounce)) break;
+            memcpy(out + copied, bounce + in_page, chunk);
+        }
+        copied += chunk;
+    }
+
+    if (bounce != NULL) free(bounce);
+    return copied;
+}
+
+void pagecache_invalidate(uint32_t start_cluster) {
+    pagecache_file_t* file = pagecache_find_file(start_cluster);
+    if (file == NULL) {
+        return;
+    }
+
+    pagecache_unlink_file(file);
+    if (file->pages.root != NULL) {
+        radix_destroy_node(file->pages.root, file->pages.height - 1, pagecache_drop_page);
+    }
+    free(file);
+}
+
+uint32_t pagecache_shrink(uint32_t target) {
+    if (!mutex_trylock(&fs_lock)) {
+        return 0; // Another thread is mid-way through file I/O
+    }
+    uint32_t freed = 0;
+
+    // Two full turns of the clock: the first clears 'referenced' bits,
+    // the second can then evict pages that stayed idle.
+    uint32_t budget = cached_pages * 2;
+
+    while (freed < target && budget > 0 && clock_hand != NULL) {
+        pagecache_page_t* page = clock_hand;
+        clock_hand = page->next;
+        budget--;
+
+        if (page->refcount > 0 || page->file == NULL) {
+            continue; // Pinned
+        }
+        if (page->referenced) {
+            page->referenced = false;
+            continue;
+        }
+
+        pagecache_evict(page);
+        freed++;
+    }
+    mutex_unlock(&fs_lock);
+    return freed;
+}
+
+uint32_t pagecache_get_page_count(void) {
+    return cached_pages;
+}
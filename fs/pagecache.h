@@ -0,0 +1,52 @@
+#ifndef PAGECACHE_H
+#define PAGECACHE_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "../src/mutex.h"
+
+// --- Unified File Page Cache ---
+// Caches 4 KiB pages of regular file data in physical frames. A file is
+// identified by its first cluster, which is also what SYS_OPEN hands out as
+// a file descriptor. Each cached file keeps its pages in a radix tree keyed
+// by page index. Unreferenced pages are reclaimed by a clock sweep when the
+// PMM runs low on free frames.
+
+typedef struct pagecache_page pagecache_page_t;
+
+// Serializes FAT32, the page cache and the mmap regions between threads.
+// Syscalls and ring workers take it around file work, and the mmap fault
+// handler takes it around page-ins. Shrinkers that find it busy skip their
+// turn instead of waiting.
+extern mutex_t fs_lock;
+
+// Registers the cache with the PMM so it can be shrunk under pressure.
+void pagecache_init(void);
+
+// Returns page 'index' of the file, reading it from disk on a miss, and
+// takes a reference that pins it in memory. Returns NULL on failure.
+pagecache_page_t* pagecache_get(uint32_t start_cluster, uint32_t file_size, uint32_t index);
+
+// Physical frame holding a page's data.
+uint32_t pagecache_page_frame(pagecache_page_t* page);
+
+// Drops a reference taken by pagecache_get().
+void pagecache_release(pagecache_page_t* page);
+
+// Writes a cached page back to its file on disk.
+bool pagecache_writeback(pagecache_page_t* page);
+
+// Copies 'length' bytes at 'offset' of a file into 'buffer', going through
+// the cache. Returns the number of bytes copied (short at end of file).
+uint32_t pagecache_read(uint32_t start_cluster, uint32_t file_size, uint32_t offset, void* buffer, uint32_t length);
+
+// Drops every cached page of a file. Call before its clusters are freed.
+void pagecache_invalidate(uint32_t start_cluster);
+
+// Evicts up to 'target' unreferenced pages. Returns how many were freed.
+uint32_t pagecache_shrink(uint32_t target);
+
+// Number of pages currently held by the cache.
+uint32_t pagecache_get_page_count(void);
+
+#endif // PAGECACHE_H
@@ -2,7 +2,19 @@
 #include "../drivers/terminal.h" // Relative paths may vary
 #include "../drivers/pic.h"
 #include "../drivers/keyboard.h"
+#include "../drivers/ide.h"
+#include "../drivers/serial.h"
 #include "../src/syscall.h"
+#include "../memory/paging.h"
+#include "../drivers/timer.h"
+#include "../src/sched.h"
+#include "../drivers/lapic.h"
+#include "../drivers/ioapic.h"
+#include "../drivers/pci.h"
+#include "../src/process.h"
+#include "../src/fpu.h"
+#include "../src/profile.h"
+#include "../src/cpu.h"
 
 // --- Extern declarations for assembly ISR stubs ---
 // These are the low-level entry points defined in interrupts.asm
@@ -15,6 +27,9 @@ extern void isr20(); extern void isr21(); extern void isr22(); extern void isr23
 extern void isr24(); extern void isr25(); extern void isr26(); extern void isr27();
 extern void isr28(); extern void isr29(); extern void isr30(); extern void isr31();
 extern void isr128(void);
+extern void isr64(void); extern void isr65(void); extern void isr255(void);
+extern void isr80(void); extern void isr81(void); extern void isr82(void); extern void isr83(void);
+extern void isr84(void); extern void isr85(void); extern void isr86(void); extern void isr87(void);
 
 extern void irq0(); extern void irq1(); extern void irq2(); extern void irq3();
 extern void irq4(); extern void irq5(); extern void irq6(); extern void irq7();
@@ -37,7 +52,27 @@ static inline void idt_load(struct idt_ptr_struct* idt_ptr) {
 
 // This function handles all CPU exceptions (ISRs 0-31)
 void fault_handler(registers_t* regs) {
+    // Page faults can be recoverable, so let the paging code look first.
+    if (regs->int_no == 14 && paging_handle_fault(regs)) {
+        return;
+    }
+    // Device-not-available: the first FPU/SIMD use since a thread switch
+    if (regs->int_no == 7 && fpu_handle_trap()) {
+        return;
+    }
+    // A fault in a user program only ends that program
+    if ((regs->cs & 3) == 3) {
+        terminal_writeerror("EXCEPTION: %d at %x - program killed.", regs->int_no, regs->eip);
+        process_exit(-1);
+    }
+    // So does a syscall tripping over a bad pointer the program passed in
+    uint32_t fault_addr = (regs->int_no == 14) ? read_cr2() : 0;
+    if (fault_addr >= USER_SPACE_START && fault_addr < USER_SPACE_END && process_is_current()) {
+        terminal_writeerror("Bad user pointer %x in a syscall - program killed.", fault_addr);
+        process_exit(-1);
+    }
     terminal_writeerror("EXCEPTION: %d - System Halted.", regs->int_no);
+    serial_flush(); // Nothing will drain it from here on
     for (;;);
 }
 
@@ -45,10 +80,27 @@ void fault_handler(registers_t* regs) {
 void irq_handler(registers_t* regs) {
     // Dispatch to the correct driver based on the hardware interrupt number
     switch (regs->int_no) {
+        case 32: // IRQ 0: PIT
+            timer_handler();
+            // With the LAPIC up, each CPU's own timer drives scheduling
+            if (!lapic_is_enabled()) {
+                profile_tick(regs);
+                sched_tick();
+            }
+            break;
+
         case 33: // IRQ 1: Keyboard
             keyboard_handler();
             break;
 
+        case 36: // IRQ 4: COM1
+            serial_irq_handler();
+            break;
+
+        case 46: // IRQ 14: Primary IDE channel
+            ide_irq_handler();
+            break;
+
         // Add more cases here for other hardware like mice, disks, etc.
         default:
             // You can optionally print a message for unhandled IRQs
@@ -63,11 +115,40 @@ void c_interrupt_handler(registers_t* regs) {
     if (regs->int_no == 128) {
         // It's a system call, so pass the registers to the syscall handler
         syscall_handler(regs);
+    } else if (regs->int_no == LAPIC_TIMER_VECTOR || regs->int_no == LAPIC_RESCHED_VECTOR) {
+        // Per-CPU timer tick, or another CPU queued work for us
+        if (regs->int_no == LAPIC_TIMER_VECTOR) {
+            profile_tick(regs);
+            sched_tick();
+        }
+        lapic_eoi();
+        if (regs->eflags & 0x200) {
+            sched_preempt();
+        }
+    } else if (regs->int_no == LAPIC_SPURIOUS_VECTOR) {
+        // Spurious LAPIC interrupts must not be EOI'd
+    } else if (regs->int_no >= MSI_VECTOR_BASE && regs->int_no < MSI_VECTOR_BASE + MSI_VECTOR_COUNT) {
+        // A PCI device signalled us directly
+        msi_dispatch(regs->int_no);
+        lapic_eoi();
+        if (regs->eflags & 0x200) {
+            sched_preempt();
+        }
     } else if (regs->int_no >= 32 && regs->int_no <= 47) {
         // It's a hardware interrupt (IRQ).
         irq_handler(regs);
-        // We MUST send an End-of-Interrupt (EOI) to the PICs for IRQs.
-        pic_send_eoi(regs->int_no - 32);
+        // We MUST send an End-of-Interrupt (EOI) for IRQs: to the LAPIC when
+        // the I/O APIC delivered it, otherwise to the PICs.
+        if (ioapic_is_enabled()) {
+            lapic_eoi();
+        } else {
+            pic_send_eoi(regs->int_no - 32);
+        }
+        // Switch threads if the IRQ made that necessary, but only when the
+        // interrupted code had interrupts enabled and is thus preemptible.
+        if (regs->eflags & 0x200) {
+            sched_preempt();
+        }
     } else {
         // It's a CPU exception.
         fault_handler(regs);
@@ -116,11 +197,28 @@ void idt_init(void) {
     }
 
     // --- System Call Gate ---
-    // CRITICAL FIX: Set the flags to 0xEE instead of 0x8E.
-    // 0xEE = Present(1), DPL=3(11), Type=Trap Gate(1110)
-    // This allows user-mode (Ring 3) programs to call 'int 0x80'.
+    // 0xEE = Present(1), DPL=3(11), Type=32-bit Interrupt Gate(1110)
+    // DPL 3 allows user-mode (Ring 3) programs to call 'int 0x80'. It stays
+    // an interrupt gate so IF is clear until common_handler_stub has loaded
+    // GS; syscall_handler turns interrupts back on.
     idt_set_gate(128, (uint32_t)isr128, 0x08, 0xEE);
 
+    // --- Local APIC ---
+    idt_set_gate(LAPIC_TIMER_VECTOR, (uint32_t)isr64, 0x08, 0x8E);
+    idt_set_gate(LAPIC_RESCHED_VECTOR, (uint32_t)isr65, 0x08, 0x8E);
+    idt_set_gate(LAPIC_SPURIOUS_VECTOR, (uint32_t)isr255, 0x08, 0x8E);
+
+    // --- MSI ---
+    void* msi_routines[] = { isr80, isr81, isr82, isr83, isr84, isr85, isr86, isr87 };
+    for (int i = 0; i < MSI_VECTOR_COUNT; i++) {
+        idt_set_gate(MSI_VECTOR_BASE + i, (uint32_t)msi_routines[i], 0x08, 0x8E);
+    }
+
     // Load the IDT using the assembly instruction.
     idt_load(&idt_ptr);
 }
+
+// Loads the IDT built by idt_init() on an application processor.
+void idt_load_cpu(void) {
+    idt_load(&idt_ptr);
+}
@@ -30,4 +30,7 @@ typedef struct registers {
 // The main initialization function for the IDT.
 void idt_init(void);
 
+// Loads the already-built IDT on an application processor.
+void idt_load_cpu(void);
+
 #endif
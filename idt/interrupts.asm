@@ -5,6 +5,13 @@
 ; This is the single C function that will handle all interrupts.
 extern c_interrupt_handler
 
+; Fast system call dispatch (src/syscall.c)
+extern syscall_table
+extern syscall_table_size
+extern syscall_unknown
+extern syscall_traced
+extern trace_enabled
+
 ; A macro to create an ISR stub for exceptions with no error code.
 %macro ISR_NO_ERR_CODE 1
     global isr%1
@@ -36,6 +43,7 @@ extern c_interrupt_handler
 ; This is the core logic that all ISRs and IRQs jump to.
 common_handler_stub:
     pusha           ; Save all general-purpose registers.
+    cld             ; The C code (memcpy's string instructions) needs DF=0
 
     mov ax, ds      ; Save the data segment selector.
     push eax
@@ -44,7 +52,16 @@ common_handler_stub:
     mov ds, ax
     mov es, ax
     mov fs, ax
+
+    ; From the kernel, GS already holds this CPU's per-CPU segment. From
+    ; ring 3 it's null (iret clears it on the way out), so reload it: the
+    ; selector follows this CPU's TSS selector (see gdt.h).
+    test byte [esp + 48], 3 ; Saved CS: ds(4) + pusha(32) + int_no/err_code(8) + eip(4)
+    jz .from_kernel
+    str ax
+    add ax, 8
     mov gs, ax
+.from_kernel:
 
     mov eax, esp    ; Get a pointer to the registers struct on the stack
     push eax        ; Push pointer as an argument for the C handler
@@ -57,13 +74,78 @@ common_handler_stub:
     mov ds, ax
     mov es, ax
     mov fs, ax
-    mov gs, ax
 
     popa            ; Restore general-purpose registers.
     add esp, 8      ; Clean up the pushed error code and interrupt number.
     iret            ; Atomically restore EIP, CS, EFLAGS, etc. and return.
 
 
+; --- Fast System Call Entry (SYSENTER) -----------------------------------
+; In:  eax = syscall number, ebx/esi/edi = arguments,
+;      ecx = caller's esp, edx = return address.
+; Out: eax = result; ebx, esi, edi and ebp preserved.
+; No register frame: the arguments go straight to the syscall_table entry.
+; SYSENTER only loads CS, SS and the small per-CPU stack from the MSRs, so
+; the rest of the switch into the kernel is done here.
+global sysenter_entry
+sysenter_entry:
+    mov esp, [esp]  ; The running thread's kernel stack (gdt_set_kernel_stack)
+    push ecx        ; User esp and return address, for SYSEXIT
+    push edx
+    push ds
+
+    mov cx, 0x10    ; Kernel data segments, and this CPU's GS as in
+    mov ds, cx      ; common_handler_stub
+    mov es, cx
+    mov fs, cx
+    str cx
+    add cx, 8
+    mov gs, cx
+    cld             ; Whatever ring 3 left in DF, the C code needs it clear
+    sti             ; SYSENTER clears IF; syscalls run with it set (see syscall_handler)
+
+    cmp eax, [syscall_table_size]
+    jae .unknown
+    mov ecx, [syscall_table + eax * 4]
+    test ecx, ecx
+    jz .unknown
+    cmp byte [trace_enabled], 0
+    jne .traced
+
+    push edi
+    push esi
+    push ebx
+    call ecx
+    add esp, 12
+
+.exit:
+    ; SYSEXIT leaves GS alone, so clear it ourselves. Interrupts stay off
+    ; from here, since their handlers need GS until we're back in ring 3.
+    cli
+    pop ecx
+    mov ds, cx
+    mov es, cx
+    mov fs, cx
+    xor ecx, ecx
+    mov gs, cx
+    pop edx
+    pop ecx
+    sti             ; Only takes effect after the next instruction
+    sysexit
+
+.traced:
+    push edi
+    push esi
+    push ebx
+    push eax
+    call syscall_traced  ; Also calls through the table (src/syscall.c)
+    add esp, 16
+    jmp .exit
+
+.unknown:
+    push eax
+    call syscall_unknown ; Doesn't return
+
 ; =========================================================================
 ;                      GENERATE ALL STUB DEFINITIONS
 ; =========================================================================
@@ -103,6 +185,21 @@ ISR_ERR_CODE    30
 ISR_NO_ERR_CODE 31
 ISR_NO_ERR_CODE 128 ; This is 0x80, for system calls
 
+; --- Local APIC vectors ---
+ISR_NO_ERR_CODE 64  ; LAPIC timer
+ISR_NO_ERR_CODE 65  ; Reschedule IPI
+ISR_NO_ERR_CODE 255 ; LAPIC spurious interrupt
+
+; --- MSI vectors (MSI_VECTOR_BASE.. in pci.h) ---
+ISR_NO_ERR_CODE 80
+ISR_NO_ERR_CODE 81
+ISR_NO_ERR_CODE 82
+ISR_NO_ERR_CODE 83
+ISR_NO_ERR_CODE 84
+ISR_NO_ERR_CODE 85
+ISR_NO_ERR_CODE 86
+ISR_NO_ERR_CODE 87
+
 ; --- Generate all 16 IRQ stubs (Hardware Interrupts 32-47) ---
 IRQ 0, 32
 IRQ 1, 33
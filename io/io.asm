@@ -1,6 +1,8 @@
 section .text
 global outb
 global inb
+global outl
+global inl
 global insw
 global outsw
 
@@ -19,6 +21,21 @@ inb:
     in al, dx           ; Execute the 'in' instruction
     ret                 ; Result is returned in the AL register
 
+; outl: sends a dword to an I/O port
+; stack: [esp+8]: data, [esp+4]: port
+outl:
+    mov eax, [esp + 8]
+    mov dx, [esp + 4]
+    out dx, eax
+    ret
+
+; inl: receives a dword from an I/O port
+; stack: [esp+4]: port
+inl:
+    mov dx, [esp + 4]
+    in eax, dx
+    ret
+
 ; void insw(uint16_t port, void* addr, uint32_t count);
 insw:
     push ebp
@@ -9,6 +9,10 @@ void outb(uint16_t port, uint8_t data);
 // Function to receieve a byte from an I/O Port
 uint8_t inb(uint16_t port);
 
+// 32-bit port I/O (PCI configuration space)
+void outl(uint16_t port, uint32_t data);
+uint32_t inl(uint16_t port);
+
 // Reads 'count' 16-bit words from 'port' into 'addr'.
 void insw(uint16_t port, void* addr, uint32_t count);
 
@@ -1,4 +1,5 @@
 #include "math.h"
+#include <stddef.h>
 
 double floor(double x) {
     // If the number is already an integer, return it
@@ -29,3 +30,19 @@ double ceil(double x) {
     // If the number is negative, truncate it (e.g., -3.7 -> -3.0)
     return (double)(long long)x;
 }
+
+uint64_t div_u64_rem(uint64_t dividend, uint32_t divisor, uint32_t* remainder) {
+    uint32_t high = (uint32_t)(dividend >> 32);
+    uint32_t low = (uint32_t)dividend;
+
+    // High half first; its remainder seeds EDX so the second divl can't overflow
+    uint32_t q_high = high / divisor;
+    uint32_t rem = high % divisor;
+    uint32_t q_low;
+    asm("divl %4" : "=a"(q_low), "=d"(rem) : "a"(low), "d"(rem), "rm"(divisor));
+
+    if (remainder != NULL) {
+        *remainder = rem;
+    }
+    return ((uint64_t)q_high << 32) | q_low;
+}
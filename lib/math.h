@@ -4,4 +4,10 @@
 double floor(double x);
 double ceil(double x);
 
+#include <stdint.h>
+
+// Divides a 64-bit value by a 32-bit one using two 'divl' steps, since the
+// kernel doesn't link libgcc's 64-bit division. 'remainder' may be NULL.
+uint64_t div_u64_rem(uint64_t dividend, uint32_t divisor, uint32_t* remainder);
+
 #endif
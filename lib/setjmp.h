@@ -10,6 +10,6 @@ typedef struct {
 
 // Function Prototypes
 int setjmp(jmp_buf buf);
-void longjmp(jmp_buf buf, int val);
+void longjmp(jmp_buf buf, int val) __attribute__((noreturn));
 
 #endif
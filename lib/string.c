@@ -1,4 +1,233 @@
 #include "string.h"
+#include "../src/cpu_features.h"
+#include "../src/fpu.h"
+#include <stdint.h>
+#include <stdbool.h>
+
+// Sizes at which memcpy/memset change strategy
+#define ERMSB_THRESHOLD   512         // Below this, rep movsb's startup cost isn't worth it
+#define NT_COPY_THRESHOLD (64 * 1024) // Copies this big would only flush the cache
+#define NT_COPY_CHUNK     (16 * 1024) // Per kernel_fpu section, which keeps interrupts off
+
+// String scans switch to SSE2 once this much of a string has been
+// scanned without finding the end; below it, saving the FPU state for a
+// kernel_fpu section costs more than it gains
+#define SSE2_SCAN_MIN     256
+#define SSE2_SCAN_CHUNK   4096 // Per kernel_fpu section
+
+#define SCAN_PAGE_SIZE    4096
+#define ONES              0x01010101u
+#define HIGHS             0x80808080u
+
+// Strings are read a word at a time through this, which may alias chars
+typedef uint32_t __attribute__((may_alias)) word_t;
+
+typedef void (*copy_fn_t)(void* dest, const void* src, size_t n);
+typedef void (*fill_fn_t)(void* dest, uint32_t pattern, size_t n);
+typedef const char* (*scan_fn_t)(const char* p, char c);
+
+static void copy_dwords(void* dest, const void* src, size_t n);
+static void fill_dwords(void* dest, uint32_t pattern, size_t n);
+
+// The implementations in use, picked by string_init() (see cpu_features.h).
+// Until then everything takes the dword path, which works anywhere.
+static copy_fn_t copy_small = copy_dwords; // Below ERMSB_THRESHOLD
+static copy_fn_t copy_large = copy_dwords;
+static copy_fn_t copy_huge = NULL;         // From NT_COPY_THRESHOLD; NULL: copy_large
+static fill_fn_t fill_large = fill_dwords; // From ERMSB_THRESHOLD
+static scan_fn_t scan_long = NULL;         // Past SSE2_SCAN_MIN; NULL: stay word at a time
+
+// --- Internal Helper Functions ---
+
+static void copy_movsb(void* dest, const void* src, size_t n) {
+    asm volatile("rep movsb" : "+D"(dest), "+S"(src), "+c"(n) : : "memory");
+}
+
+// Aligns the destination so dword stores don't split cache lines, copies
+// dwords, then the bytes left over.
+static void copy_dwords(void* dest, const void* src, size_t n) {
+    size_t head = (0u - (uint32_t)dest) & 3;
+    if (head > n) {
+        head = n;
+    }
+    n -= head;
+    asm volatile("rep movsb\n\t"
+                 "mov %[dwords], %%ecx\n\t"
+                 "rep movsl\n\t"
+                 "mov %[tail], %%ecx\n\t"
+                 "rep movsb"
+                 : "+D"(dest), "+S"(src), "+c"(head)
+                 : [dwords] "r"(n / 4), [tail] "r"(n & 3)
+                 : "memory");
+}
+
+// Copies upwards with string instructions. Also correct for overlapping
+// buffers as long as dest is below src.
+static void copy_forward(void* dest, const void* src, size_t n) {
+    if (n >= ERMSB_THRESHOLD) {
+        copy_large(dest, src, n);
+    } else {
+        copy_small(dest, src, n);
+    }
+}
+
+// Copies with MOVNTDQ, which writes around the cache: a copy this large
+// would evict everything else and gain nothing from it. Works in chunks so
+// interrupts are never off for long.
+static void copy_nontemporal(void* dest, const void* src, size_t n) {
+    uint8_t* d = dest;
+    const uint8_t* s = src;
+
+    size_t head = (0u - (uint32_t)d) & 15; // MOVNTDQ needs 16-byte alignment
+    copy_forward(d, s, head);
+    d += head;
+    s += head;
+    n -= head;
+
+    while (n >= 64) {
+        size_t chunk = (n < NT_COPY_CHUNK) ? (n & ~63u) : NT_COPY_CHUNK;
+        n -= chunk;
+        uint32_t flags = kernel_fpu_begin();
+        asm volatile("1:\n\t"
+                     "movdqu (%1), %%xmm0\n\t"
+                     "movdqu 16(%1), %%xmm1\n\t"
+                     "movdqu 32(%1), %%xmm2\n\t"
+                     "movdqu 48(%1), %%xmm3\n\t"
+                     "movntdq %%xmm0, (%0)\n\t"
+                     "movntdq %%xmm1, 16(%0)\n\t"
+                     "movntdq %%xmm2, 32(%0)\n\t"
+                     "movntdq %%xmm3, 48(%0)\n\t"
+                     "add $64, %1\n\t"
+                     "add $64, %0\n\t"
+                     "sub $64, %2\n\t"
+                     "jnz 1b\n\t"
+                     "sfence" // Streaming stores are weakly ordered
+                     : "+r"(d), "+r"(s), "+r"(chunk)
+                     :
+                     : "memory", "cc");
+        kernel_fpu_end(flags);
+    }
+    copy_forward(d, s, n);
+}
+
+static void fill_stosb(void* dest, uint32_t pattern, size_t n) {
+    asm volatile("rep stosb" : "+D"(dest), "+c"(n) : "a"(pattern) : "memory");
+}
+
+// Aligns the destination, stores dwords, then the bytes left over.
+static void fill_dwords(void* dest, uint32_t pattern, size_t n) {
+    size_t head = (0u - (uint32_t)dest) & 3;
+    if (head > n) {
+        head = n;
+    }
+    n -= head;
+    asm volatile("rep stosb\n\t"
+                 "mov %[dwords], %%ecx\n\t"
+                 "rep stosl\n\t"
+                 "mov %[tail], %%ecx\n\t"
+                 "rep stosb"
+                 : "+D"(dest), "+c"(head)
+                 : "a"(pattern), [dwords] "r"(n / 4), [tail] "r"(n & 3)
+                 : "memory");
+}
+
+// Non-zero if any byte of 'v' is zero. The lowest flagged byte is always
+// the first zero one; flags above it may be false positives.
+static inline uint32_t has_zero_byte(uint32_t v) {
+    return (v - ONES) & ~v & HIGHS;
+}
+
+// True if a 4-byte load at 'p' stays within p's page. An unaligned load
+// that spills into the next page could fault where the string doesn't go.
+static inline bool word_load_safe(const char* p) {
+    return ((uint32_t)p & (SCAN_PAGE_SIZE - 1)) <= SCAN_PAGE_SIZE - 4;
+}
+
+// Compares up to 'count' bytes. Returns true, with the result in '*diff',
+// once the strings differ or end; otherwise advances both pointers.
+static bool compare_bytes(const char** s1, const char** s2, size_t count, int* diff) {
+    for (; count > 0; count--) {
+        unsigned char c1 = **s1;
+        unsigned char c2 = **s2;
+        if (c1 != c2 || c1 == '\0') {
+            *diff = c1 - c2;
+            return true;
+        }
+        (*s1)++;
+        (*s2)++;
+    }
+    return false;
+}
+
+// Offset of the first byte that is 0 or 'c' in the 'len' bytes at 'p', or
+// 'len' if there is none. 'p' is 16-byte aligned and 'len' a multiple of
+// 16, so no load goes past the page the match is in.
+static size_t sse2_find_byte_or_zero(const char* p, size_t len, char c) {
+    uint32_t pattern = (uint8_t)c * ONES;
+    size_t offset = 0;
+    uint32_t mask;
+
+    uint32_t flags = kernel_fpu_begin();
+    asm volatile("movd %[pattern], %%xmm1\n\t"
+                 "pshufd $0, %%xmm1, %%xmm1\n\t"
+                 "pxor %%xmm2, %%xmm2\n\t"
+                 "1:\n\t"
+                 "movdqa (%[p], %[offset]), %%xmm0\n\t"
+                 "movdqa %%xmm0, %%xmm3\n\t"
+                 "pcmpeqb %%xmm2, %%xmm0\n\t" // Terminators
+                 "pcmpeqb %%xmm1, %%xmm3\n\t" // Matches
+                 "por %%xmm3, %%xmm0\n\t"
+                 "pmovmskb %%xmm0, %[mask]\n\t"
+                 "test %[mask], %[mask]\n\t"
+                 "jnz 2f\n\t"
+                 "add $16, %[offset]\n\t"
+                 "cmp %[len], %[offset]\n\t"
+                 "jb 1b\n\t"
+                 "2:"
+                 : [offset] "+r"(offset), [mask] "=&r"(mask)
+                 : [p] "r"(p), [len] "r"(len), [pattern] "r"(pattern)
+                 : "memory", "cc");
+    kernel_fpu_end(flags);
+
+    return (mask != 0) ? offset + __builtin_ctz(mask) : len;
+}
+
+// The rest of a long string scan, from a 16-byte boundary.
+static const char* scan_sse2(const char* p, char c) {
+    for (;; p += SSE2_SCAN_CHUNK) {
+        size_t offset = sse2_find_byte_or_zero(p, SSE2_SCAN_CHUNK, c);
+        if (offset < SSE2_SCAN_CHUNK) {
+            return p + offset;
+        }
+    }
+}
+
+// Finds the first byte of 's' that is 0 or 'c'. Loads are aligned, so
+// like the byte loop they never touch a page the string doesn't reach.
+// Words are checked with the has-zero-byte trick, on the word itself for
+// the terminator and XORed with 'c' repeated for the character.
+static const char* find_byte_or_zero(const char* s, char c) {
+    for (; (uint32_t)s & 3; s++) {
+        if (*s == c || *s == '\0') {
+            return s;
+        }
+    }
+
+    uint32_t pattern = (uint8_t)c * ONES;
+    const word_t* w = (const word_t*)s;
+    for (size_t scanned = 0;; scanned += 4, w++) {
+        uint32_t found = has_zero_byte(*w) | has_zero_byte(*w ^ pattern);
+        if (found != 0) {
+            return (const char*)w + __builtin_ctz(found) / 8;
+        }
+        // A long string: hand over to SIMD at the next 16-byte boundary
+        if (scan_long != NULL && scanned >= SSE2_SCAN_MIN && ((uint32_t)(w + 1) & 15) == 0) {
+            return scan_long((const char*)(w + 1), c);
+        }
+    }
+}
+
+// --- Public API Functions ---
 
 int to_upper(int c) {
     // Check if character is in the lowercase range 'a' through 'z'
@@ -85,62 +314,67 @@ int hex_to_int(const char* hex_str) {
 }
 
 int strcmp(const char* s1, const char* s2) {
-    while(*s1 && (*s1 == *s2)) {
-        s1++;
-        s2++;
+    int diff;
+    // Align s1, then compare a word at a time until the words differ or
+    // hold the terminator, and settle those 4 bytes one by one
+    if (compare_bytes(&s1, &s2, (0u - (uint32_t)s1) & 3, &diff)) {
+        return diff;
+    }
+    for (;;) {
+        if (word_load_safe(s2)) {
+            uint32_t w1 = *(const word_t*)s1;
+            if (w1 == *(const word_t*)s2 && !has_zero_byte(w1)) {
+                s1 += 4;
+                s2 += 4;
+                continue;
+            }
+        }
+        if (compare_bytes(&s1, &s2, 4, &diff)) {
+            return diff;
+        }
     }
-    return *(const unsigned char*)s1 - *(const unsigned char*)s2;
 }
 
 int strncmp(const char* s1, const char* s2, size_t n) {
-    while (n > 0) {
-        // If the characters are different or we've hit a null terminator
-        // in s1, break out of the loop
-        if (*s1 != *s2 || *s1 == '\0') {
-            break;
+    int diff;
+    size_t head = (0u - (uint32_t)s1) & 3;
+    if (head > n) {
+        head = n;
+    }
+    if (compare_bytes(&s1, &s2, head, &diff)) {
+        return diff;
+    }
+    n -= head;
+
+    while (n >= 4) {
+        if (word_load_safe(s2)) {
+            uint32_t w1 = *(const word_t*)s1;
+            if (w1 == *(const word_t*)s2 && !has_zero_byte(w1)) {
+                s1 += 4;
+                s2 += 4;
+                n -= 4;
+                continue;
+            }
         }
-
-        // Move to the next characters
-        s1++;
-        s2++;
-        n--;
+        if (compare_bytes(&s1, &s2, 4, &diff)) {
+            return diff;
+        }
+        n -= 4;
     }
 
     // If we've compared all n characters and found no differences
     // the strings are equal for that length
-    if (n == 0) {
-        return 0;
-    }
-
-    // Return the difference between the first non-matching characters.
-    // Casting to uunsigned char is important for correct behaviour with characters outside the standard ASCII range
-    return *(const unsigned char*)s1 - *(const unsigned char*)s2;
+    return compare_bytes(&s1, &s2, n, &diff) ? diff : 0;
 }
 
-int strlen(const char* str) {
-   size_t len = 0;
-   while(str[len] != '\0') {
-    len++;
-   }
-   return len;
+size_t strlen(const char* str) {
+    return find_byte_or_zero(str, '\0') - str;
 }
 
 char* strcpy(char* dest, const char* src) {
-    // Save the original destination ptr to return later
-    char* orig_dest = dest;
-
-    // Loop until null term char is found in src string
-    while(*src != '\0') {
-        *dest = *src;   // Copy the character
-        dest++;
-        src++;
-    }
-
-    // After the loop, copy the null terminator to properly end the string
-    *dest = '\0';
-
-    // Return the original starting address of the destination string
-    return orig_dest;
+    // Copy the terminator along with the string
+    memcpy(dest, src, strlen(src) + 1);
+    return dest;
 }
 
 // Helper function to reverse a string in place
@@ -157,24 +391,9 @@ static void reverse(char* str, int length) {
 }
 
 char* strcat(char* dest, const char* src) {
-    char* orig_dest = dest;
-
-    // Find the end of the destination string
-    while (*dest != '\0') {
-        dest++;
-    }
-
-    // Copy the src str to the end of dest string
-    while (*src != '\0') {
-        *dest = *src;
-        dest++;
-        src++;
-    }
-
-    // Add the null terminator back
-    *dest = '\0';
-
-    return orig_dest;
+    // Copy the src str over the end of the dest string
+    strcpy(dest + strlen(dest), src);
+    return dest;
 }
 
 /**
@@ -185,20 +404,18 @@ char* strcat(char* dest, const char* src) {
  * @return A pointer to the last occurrence of the character, or NULL if not found.
  */
 char* strrchr(const char* s, int c) {
-    const char* last_occurrence = NULL;
-
-    // Iterate through the string until the null terminator is found.
-    // The loop also checks the null terminator itself,
-    // which is important because strrchr considers the null terminator as part of the string.
-    do {
-        // If the current character matches the target character,
-        // update our pointer to the last found occurrence.
-        if (*s == (char)c) {
-            last_occurrence = s;
+    // Find the end with the fast scan, then walk back. The terminator
+    // counts as part of the string, so strrchr(s, '\0') finds it.
+    const char* p = s + strlen(s);
+    for (;;) {
+        if (*p == (char)c) {
+            return (char*)p;
         }
-    } while (*s++ != '\0'); // Increment s to move to the next character
-
-    return (char*)last_occurrence;
+        if (p == s) {
+            return NULL;
+        }
+        p--;
+    }
 }
 
 /**
@@ -210,17 +427,10 @@ char* strrchr(const char* s, int c) {
  * or NULL if the character is not found.
  */
 char* strchr(const char* str, int c) {
-    while (*str != '\0') {
-        if (*str == (char)c) {
-            return (char*)str;
-        }
-        str++;
-    }
-    // Check for the null terminator as well, as per the C standard.
-    if (c == '\0') {
-        return (char*)str;
-    }
-    return NULL;
+    // Stops at c or the terminator; the latter only counts when c is '\0',
+    // as per the C standard
+    const char* p = find_byte_or_zero(str, (char)c);
+    return (*p == (char)c) ? (char*)p : NULL;
 }
 
 /**
@@ -268,16 +478,11 @@ char* itoa(int num, char* buffer, int base) {
 }
 
 void* memcpy(void* dest, const void* src, size_t n) {
-    // Cast the generic pointers to char pointers to work with bytes
-    unsigned char* d = dest;
-    const unsigned char* s = src;
-
-    // Loop to copy n bytes
-    while (n--) {
-        *d++ = *s++;
+    if (copy_huge != NULL && n >= NT_COPY_THRESHOLD) {
+        copy_huge(dest, src, n);
+    } else {
+        copy_forward(dest, src, n);
     }
-
-    // Return the original destination pointer
     return dest;
 }
 
@@ -286,15 +491,12 @@ void* memcpy(void* dest, const void* src, size_t n) {
  * with the constant byte c.
  */
 void* memset(void* s, int c, size_t n) {
-    // Cast the generic pointer to a char pointer to work with bytes
-    unsigned char* p = s;
-
-    // Loop to set n bytes
-    while (n--) {
-        *p++ = (unsigned char)c;
+    uint32_t pattern = (uint8_t)c * ONES;
+    if (n >= ERMSB_THRESHOLD) {
+        fill_large(s, pattern, n);
+    } else {
+        fill_dwords(s, pattern, n);
     }
-
-    // Return the original pointer
     return s;
 }
 
@@ -308,28 +510,73 @@ void* memset(void* s, int c, size_t n) {
  * @return A pointer to the destination, which is 'dest'.
  */
 void* memmove(void* dest, const void* src, size_t n) {
-    // Cast the void pointers to char pointers to work with bytes
-    char* d = (char*)dest;
-    const char* s = (const char*)src;
-
-    // If the buffers don't overlap, or if the destination is before the source,
-    // we can copy from start to finish (a forward copy).
-    if (d <= s || d >= s + n) {
-        for (size_t i = 0; i < n; i++) {
-            d[i] = s[i];
-        }
+    uint8_t* d = dest;
+    const uint8_t* s = src;
+
+    // No overlap: any memcpy strategy will do
+    if (d + n <= s || s + n <= d) {
+        return memcpy(dest, src, n);
     }
-    // Otherwise, the destination overlaps and is after the source.
-    // We must copy from end to start to avoid overwriting data we need to read.
-    else {
-        for (size_t i = n; i > 0; i--) {
-            d[i - 1] = s[i - 1];
-        }
+    // Destination below the source: a forward copy never overwrites bytes
+    // it has yet to read
+    if (d <= s) {
+        copy_forward(dest, src, n);
+        return dest;
     }
 
+    // Destination above the source: copy downwards, the odd bytes at the
+    // end first and then dwords. Interrupts that arrive with DF set clear
+    // it for themselves (see interrupts.asm).
+    uint8_t* d_last = d + n - 1;
+    const uint8_t* s_last = s + n - 1;
+    size_t tail = n & 3;
+    asm volatile("std\n\t"
+                 "rep movsb\n\t"
+                 "sub $3, %%edi\n\t"
+                 "sub $3, %%esi\n\t"
+                 "mov %[dwords], %%ecx\n\t"
+                 "rep movsl\n\t"
+                 "cld"
+                 : "+D"(d_last), "+S"(s_last), "+c"(tail)
+                 : [dwords] "r"(n / 4)
+                 : "memory");
     return dest;
 }
 
+void string_init(void) {
+    static const cpu_impl_t copy_small_impls[] = {
+        { "rep movsb (FSRM)", CPU_FEATURE_BIT(CPU_FEATURE_FSRM), copy_movsb },
+        { "rep movsd", 0, copy_dwords },
+    };
+    static const cpu_impl_t copy_large_impls[] = {
+        { "rep movsb (ERMSB)", CPU_FEATURE_BIT(CPU_FEATURE_ERMSB), copy_movsb },
+        { "rep movsd", 0, copy_dwords },
+    };
+    static const cpu_impl_t copy_huge_impls[] = {
+        { "SSE2 streaming stores", CPU_FEATURE_BIT(CPU_FEATURE_SSE2), copy_nontemporal },
+        { "as below 64 KiB", 0, NULL },
+    };
+    static const cpu_impl_t fill_large_impls[] = {
+        { "rep stosb (ERMSB)", CPU_FEATURE_BIT(CPU_FEATURE_ERMSB), fill_stosb },
+        { "rep stosd", 0, fill_dwords },
+    };
+    static const cpu_impl_t scan_long_impls[] = {
+        { "SSE2 pcmpeqb", CPU_FEATURE_BIT(CPU_FEATURE_SSE2), scan_sse2 },
+        { "word at a time", 0, NULL },
+    };
+    static cpu_dispatch_t dispatches[] = {
+        { "memcpy < 512 B", (void**)&copy_small, copy_small_impls, 2, NULL, NULL },
+        { "memcpy", (void**)&copy_large, copy_large_impls, 2, NULL, NULL },
+        { "memcpy >= 64 KiB", (void**)&copy_huge, copy_huge_impls, 2, NULL, NULL },
+        { "memset >= 512 B", (void**)&fill_large, fill_large_impls, 2, NULL, NULL },
+        { "strlen/strchr", (void**)&scan_long, scan_long_impls, 2, NULL, NULL },
+    };
+
+    for (uint32_t i = 0; i < sizeof(dispatches) / sizeof(dispatches[0]); i++) {
+        cpu_dispatch_select(&dispatches[i]);
+    }
+}
+
 /**
  * @brief A pointer to save the position between subsequent calls to strtok.
  *
@@ -7,6 +7,9 @@ int to_lower(int c);
 void str_upper(char *str);
 void str_lower(char *str);
 int hex_to_int(const char* hex_str);
+// The scanning and comparing functions below work a word at a time, and
+// strlen/strchr switch to SSE2 for long strings once string_init() has
+// found it. They only read memory the byte-at-a-time versions would.
 int strcmp(const char* s1, const char* s2);
 int strncmp(const char* s1, const char* s2, size_t n);
 /**
@@ -14,7 +17,7 @@ int strncmp(const char* s1, const char* s2, size_t n);
  * @param str The null-terminated string to measure.
  * @return The number of characters in the string, excluding the null terminator.
  */
-int strlen(const char* str);
+size_t strlen(const char* str);
 /**
  * @brief Copies a string from a source to a destination.
  * @warning This function does not perform bounds checking. The destination
@@ -30,9 +33,16 @@ char* strrchr(const char* s, int c);
 char* strchr(const char* str, int c);
 char* itoa(int num, char* buffer, int base);
 
+// memcpy, memset and memmove use string instructions, plus SSE2 streaming
+// stores for very large copies, as the CPU allows (see string_init()).
 void* memcpy(void* dest, const void* src, size_t n);
 
 void* memset(void* s, int c, size_t n);
 void* memmove(void* dest, const void* src, size_t n);
+
+// Picks the memcpy/memset and scan implementations for this CPU (see
+// cpu_dispatch_select()). Call once on the boot CPU, after fpu_init();
+// until then the portable ones are used.
+void string_init(void);
 char* strtok(char* str, const char* delim);
 #endif
@@ -1,7 +1,10 @@
 #include "heap.h"
 #include "pmm.h"
 #include "../drivers/terminal.h"
+#include "../src/spinlock.h"
+#include "../src/trace.h"
 static block_header_t *g_heap_start = NULL;
+static spinlock_t heap_lock = SPINLOCK_INIT;
 
 void heap_init() {
     // We want a 2.048 MB heap.
@@ -42,6 +45,9 @@ void* malloc(size_t size) {
         return NULL;
     }
 
+    // Other threads and CPUs allocate too, so the list is walked under a lock
+    uint32_t flags = spin_lock_irqsave(&heap_lock);
+    void* result = NULL;
     block_header_t *current = g_heap_start;
 
     while(current != NULL) {
@@ -65,14 +71,17 @@ void* malloc(size_t size) {
 
             current->is_free = false;
             // Return a ptr to the data region, which is right after the header
-            return (void*)((uint8_t*)current + sizeof(block_header_t));
+            result = (void*)((uint8_t*)current + sizeof(block_header_t));
+            break;
         }
         current = current->next;
     }
 
     // TODO: No suitable block found. need to expand the heap by calling pmm_alloc_page()
     // and adding the new memoryt to the end of the list. FOr now, we fail/
-    return NULL;
+    spin_unlock_irqrestore(&heap_lock, flags);
+    TRACE(TRACE_HEAP_ALLOC, size, result, 0, 0);
+    return result;
 }
 
 void free(void* ptr) {
@@ -80,6 +89,8 @@ void free(void* ptr) {
         return;
     }
 
+    TRACE(TRACE_HEAP_FREE, ptr, 0, 0, 0);
+    uint32_t flags = spin_lock_irqsave(&heap_lock);
     block_header_t* header = (block_header_t*)((uint8_t*)ptr - sizeof(block_header_t));
     header->is_free = true;
 
@@ -104,4 +115,5 @@ void free(void* ptr) {
         header->size += header->next->size + sizeof(block_header_t);
         header->next = header->next->next;
     }
+    spin_unlock_irqrestore(&heap_lock, flags);
 }
@@ -0,0 +1,370 @@
+#include "mmap.h"
+#include "paging.h"
+#include "heap.h"
+#include "swap.h"
+#include "../fs/pagecache.h"
+#include "../lib/string.h"
+#include "../src/process.h"
+#include "../src/smp.h"
+
+typedef struct {
+    bool in_use;
+    bool anonymous;          // Zero-filled memory backed by swap, not a file
+    bool pinned;             // Anonymous pages that stay resident (never swapped)
+    uint32_t start;          // Virtual start address (page aligned)
+    uint32_t length;         // Length in bytes, rounded up to whole pages
+    uint32_t start_cluster;  // File being mapped
+    uint32_t file_size;
+    uint32_t first_page;     // File page index that appears at 'start'
+    pagecache_page_t** pages; // Cache page pinned behind each mapped page
+} mmap_region_t;
+
+static mmap_region_t regions[MMAP_MAX_REGIONS];
+
+// Clock hand for swap-out: a region index and a page offset inside it
+static int swap_hand_region = 0;
+static uint32_t swap_hand_offset = 0;
+static uint32_t anonymous_resident = 0; // Anonymous pages currently in RAM
+
+static bool mmap_anonymous_fault(uint32_t vaddr);
+
+// --- Internal Helper Functions ---
+
+static mmap_region_t* mmap_find_region(uint32_t addr) {
+    for (int i = 0; i < MMAP_MAX_REGIONS; i++) {
+        if (regions[i].in_use && addr >= regions[i].start && addr < regions[i].start + regions[i].length) {
+            return &regions[i];
+        }
+    }
+    return NULL;
+}
+
+// First-fit search for a free virtual range inside the mmap window.
+static uint32_t mmap_find_gap(uint32_t length) {
+    uint32_t candidate = MMAP_WINDOW_START;
+
+    bool moved = true;
+    while (moved) {
+        moved = false;
+        for (int i = 0; i < MMAP_MAX_REGIONS; i++) {
+            if (!regions[i].in_use) continue;
+            uint32_t end = regions[i].start + regions[i].length;
+            if (candidate < end && candidate + length > regions[i].start) {
+                candidate = end; // Overlap: retry just past this region
+                moved = true;
+            }
+        }
+    }
+
+    if (candidate + length > MMAP_WINDOW_END) {
+        return 0;
+    }
+    return candidate;
+}
+
+// Reserves a region slot and a virtual range for 'length' bytes.
+static mmap_region_t* mmap_alloc_region(uint32_t length) {
+    mmap_region_t* region = NULL;
+    for (int i = 0; i < MMAP_MAX_REGIONS; i++) {
+        if (!regions[i].in_use) {
+            region = &regions[i];
+            break;
+        }
+    }
+    if (region == NULL) {
+        return NULL;
+    }
+
+    uint32_t start = mmap_find_gap(length);
+    if (start == 0) {
+        return NULL;
+    }
+
+    memset(region, 0, sizeof(mmap_region_t));
+    region->start = start;
+    region->length = length;
+    return region;
+}
+
+// Writes one mapped page back if the CPU marked it dirty.
+static void mmap_sync_page(mmap_region_t* region, uint32_t vaddr) {
+    if (region->anonymous) {
+        return; // Nothing to write back to
+    }
+
+    uint32_t entry = paging_get_entry(vaddr);
+    if (!(entry & PAGE_PRESENT) || !(entry & PAGE_DIRTY)) {
+        return;
+    }
+
+    pagecache_writeback(region->pages[(vaddr - region->start) / PAGE_SIZE]);
+
+    // Re-install the PTE with the dirty bit cleared
+    paging_map_page(vaddr, entry & PAGE_FRAME_MASK, PAGE_WRITABLE | PAGE_USER);
+}
+
+// --- Public API Functions ---
+
+uint32_t mmap_file(uint32_t start_cluster, uint32_t file_size, uint32_t offset, uint32_t length) {
+    if (start_cluster < 2 || length == 0 || (offset % PAGE_SIZE) != 0 || offset >= file_size) {
+        return 0;
+    }
+
+    // Mappings never extend past the end of the file
+    if (length > file_size - offset) {
+        length = file_size - offset;
+    }
+    length = (length + PAGE_SIZE - 1) & ~(PAGE_SIZE - 1);
+
+    mmap_region_t* region = mmap_alloc_region(length);
+    if (region == NULL) {
+        return 0;
+    }
+
+    uint32_t table_size = (length / PAGE_SIZE) * sizeof(pagecache_page_t*);
+    region->pages = malloc(table_size);
+    if (region->pages == NULL) {
+        return 0;
+    }
+    memset(region->pages, 0, table_size);
+
+    region->in_use = true;
+    region->start_cluster = start_cluster;
+    region->file_size = file_size;
+    region->first_page = offset / PAGE_SIZE;
+    return region->start;
+}
+
+uint32_t mmap_anonymous(uint32_t length) {
+    if (length == 0) {
+        return 0;
+    }
+    length = (length + PAGE_SIZE - 1) & ~(PAGE_SIZE - 1);
+
+    mmap_region_t* region = mmap_alloc_region(length);
+    if (region == NULL) {
+        return 0;
+    }
+
+    region->in_use = true;
+    region->anonymous = true;
+    return region->start;
+}
+
+uint32_t mmap_anonymous_pinned(uint32_t length) {
+    uint32_t addr = mmap_anonymous(length);
+    if (addr == 0) {
+        return 0;
+    }
+    mmap_region_t* region = mmap_find_region(addr);
+    region->pinned = true;
+
+    // Populate it now, so the kernel can touch it with interrupts off
+    for (uint32_t vaddr = addr; vaddr < addr + region->length; vaddr += PAGE_SIZE) {
+        if (!mmap_anonymous_fault(vaddr)) {
+            mmap_unmap(addr);
+            return 0;
+        }
+    }
+    return addr;
+}
+
+bool mmap_sync(uint32_t addr, uint32_t length) {
+    uint32_t end = addr + length;
+    bool found = false;
+
+    for (uint32_t vaddr = addr & PAGE_FRAME_MASK; vaddr < end; vaddr += PAGE_SIZE) {
+        mmap_region_t* region = mmap_find_region(vaddr);
+        if (region == NULL) continue;
+        mmap_sync_page(region, vaddr);
+        found = true;
+    }
+    return found;
+}
+
+bool mmap_unmap(uint32_t addr) {
+    mmap_region_t* region = mmap_find_region(addr);
+    if (region == NULL || region->start != addr) {
+        return false;
+    }
+
+    for (uint32_t vaddr = region->start; vaddr < region->start + region->length; vaddr += PAGE_SIZE) {
+        uint32_t entry = paging_get_entry(vaddr);
+
+        if (region->anonymous) {
+            if (entry & PAGE_PRESENT) {
+                pmm_free_page((void*)(entry & PAGE_FRAME_MASK));
+                anonymous_resident--;
+            } else if (entry & PAGE_SWAPPED) {
+                swap_free_slot(PAGE_SWAP_SLOT(entry));
+            }
+            paging_unmap_page(vaddr);
+            continue;
+        }
+
+        if (!(entry & PAGE_PRESENT)) continue;
+
+        mmap_sync_page(region, vaddr);
+        paging_unmap_page(vaddr);
+
+        uint32_t slot = (vaddr - region->start) / PAGE_SIZE;
+        pagecache_release(region->pages[slot]);
+        region->pages[slot] = NULL;
+    }
+
+    if (region->pages != NULL) {
+        free(region->pages);
+    }
+    region->pages = NULL;
+    region->in_use = false;
+    return true;
+}
+
+bool mmap_unmap_user(uint32_t addr) {
+    mmap_region_t* region = mmap_find_region(addr);
+    if (region == NULL || region->pinned) {
+        return false;
+    }
+    return mmap_unmap(addr);
+}
+
+void mmap_unmap_all(void) {
+    for (int i = 0; i < MMAP_MAX_REGIONS; i++) {
+        if (regions[i].in_use) {
+            mmap_unmap(regions[i].start);
+        }
+    }
+}
+
+// Fills a not-present anonymous page: zeroes on first touch, otherwise
+// reads it back from its swap slot and releases the slot.
+static bool mmap_anonymous_fault(uint32_t vaddr) {
+    uint32_t entry = paging_get_entry(vaddr);
+
+    // Allocating may swap out other pages, but never this one: it's not present
+    void* frame = pmm_alloc_zeroed_page();
+    if (frame == NULL) {
+        return false;
+    }
+
+    if (entry & PAGE_SWAPPED) {
+        uint32_t slot = PAGE_SWAP_SLOT(entry);
+        if (!swap_read_page(slot, frame)) {
+            pmm_free_page(frame);
+            return false;
+        }
+        swap_free_slot(slot);
+    }
+
+    if (!paging_map_page(vaddr, (uint32_t)frame, PAGE_WRITABLE | PAGE_USER)) {
+        pmm_free_page(frame);
+        return false;
+    }
+    anonymous_resident++;
+    return true;
+}
+
+static bool mmap_resolve_fault(uint32_t fault_addr) {
+    mmap_region_t* region = mmap_find_region(fault_addr);
+    if (region == NULL) {
+        return false;
+    }
+
+    uint32_t vaddr = fault_addr & PAGE_FRAME_MASK;
+    if (region->anonymous) {
+        return mmap_anonymous_fault(vaddr);
+    }
+
+    uint32_t index = region->first_page + (vaddr - region->start) / PAGE_SIZE;
+
+    // Map the cached frame itself: no copy between cache and process.
+    // The reference pins the page against eviction until munmap.
+    pagecache_page_t* page = pagecache_get(region->start_cluster, region->file_size, index);
+    if (page == NULL) {
+        return false;
+    }
+    if (!paging_map_page(vaddr, pagecache_page_frame(page), PAGE_WRITABLE | PAGE_USER)) {
+        pagecache_release(page);
+        return false;
+    }
+    region->pages[(vaddr - region->start) / PAGE_SIZE] = page;
+    return true;
+}
+
+bool mmap_handle_fault(uint32_t fault_addr) {
+    // A ring worker may be paging in on the faulting thread's behalf
+    mutex_lock(&fs_lock);
+    bool resolved = mmap_resolve_fault(fault_addr);
+    mutex_unlock(&fs_lock);
+    return resolved;
+}
+
+uint32_t mmap_swap_out(uint32_t target) {
+    if (!swap_is_active() || !mutex_trylock(&fs_lock)) {
+        return 0;
+    }
+    // Evicting flushes only this CPU's TLB. The program's CPU is the one
+    // that may cache its pages, so reclaim elsewhere leaves them alone
+    // rather than shooting down every CPU. Regions only come and go under
+    // fs_lock, so the owner can't change while we hold it.
+    struct cpu* owner = process_cpu();
+    if (owner != NULL && owner != this_cpu()) {
+        mutex_unlock(&fs_lock);
+        return 0;
+    }
+
+    uint32_t freed = 0;
+
+    // Two full turns of the clock over resident anonymous pages: the first
+    // clears the accessed bits the CPU set, the second can then evict
+    // pages that weren't touched in between.
+    uint32_t budget = anonymous_resident * 2;
+
+    // Total pages the hand may pass over, so empty regions can't spin it forever
+    uint32_t steps = (MMAP_WINDOW_END - MMAP_WINDOW_START) / PAGE_SIZE;
+
+    while (freed < target && budget > 0 && steps > 0) {
+        mmap_region_t* region = &regions[swap_hand_region];
+        if (!region->in_use || !region->anonymous || region->pinned || swap_hand_offset >= region->length) {
+            swap_hand_region = (swap_hand_region + 1) % MMAP_MAX_REGIONS;
+            swap_hand_offset = 0;
+            steps--;
+            continue;
+        }
+
+        uint32_t vaddr = region->start + swap_hand_offset;
+        swap_hand_offset += PAGE_SIZE;
+        steps--;
+
+        uint32_t entry = paging_get_entry(vaddr);
+        if (!(entry & PAGE_PRESENT)) {
+            continue;
+        }
+        budget--;
+
+        if (entry & PAGE_ACCESSED) {
+            paging_set_entry(vaddr, entry & ~PAGE_ACCESSED);
+            continue;
+        }
+
+        uint32_t slot;
+        uint32_t frame = entry & PAGE_FRAME_MASK;
+        if (!swap_write_page((void*)frame, &slot)) {
+            break; // Swap is full
+        }
+        paging_set_entry(vaddr, PAGE_SWAP_ENTRY(slot));
+        pmm_free_page((void*)frame);
+        anonymous_resident--;
+        freed++;
+    }
+    mutex_unlock(&fs_lock);
+    return freed;
+}
+
+void mmap_init(void) {
+    pmm_register_shrinker(mmap_swap_out);
+}
+
+uint32_t mmap_get_anonymous_resident(void) {
+    return anonymous_resident;
+}
@@ -0,0 +1,56 @@
+#ifndef MMAP_H
+#define MMAP_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+// Virtual window reserved for file and anonymous mappings. It lies above the direct map,
+// so every page in it is mapped explicitly and on demand.
+#define MMAP_WINDOW_START 0x60000000
+#define MMAP_WINDOW_END   0x70000000
+#define MMAP_MAX_REGIONS  32
+
+// Maps 'length' bytes of a file starting at page-aligned 'offset'.
+// Nothing is read up front: pages are filled from the page cache on first
+// touch. Returns the virtual address of the mapping, or 0 on failure.
+uint32_t mmap_file(uint32_t start_cluster, uint32_t file_size, uint32_t offset, uint32_t length);
+
+// Maps 'length' bytes of zero-filled anonymous memory. Pages are allocated
+// on first touch and may be swapped out under memory pressure once swap is
+// active. Returns the virtual address of the mapping, or 0 on failure.
+uint32_t mmap_anonymous(uint32_t length);
+
+// Like mmap_anonymous(), but every page is allocated up front and never
+// swapped out. For memory the kernel shares with a program, such as rings.
+uint32_t mmap_anonymous_pinned(uint32_t length);
+
+// Writes dirty pages in [addr, addr + length) back to their file.
+bool mmap_sync(uint32_t addr, uint32_t length);
+
+// Writes back and removes the mapping that starts at 'addr'.
+bool mmap_unmap(uint32_t addr);
+
+// Like mmap_unmap(), for a program's munmap: pinned mappings (rings) are
+// refused, since a kernel thread may still be using them. They go away
+// with ring_release_all() or mmap_unmap_all().
+bool mmap_unmap_user(uint32_t addr);
+
+// Removes every mapping, as when the program that made them exits.
+void mmap_unmap_all(void);
+
+// Registers the anonymous memory swap-out shrinker with the PMM.
+void mmap_init(void);
+
+// Swaps out up to 'target' idle anonymous pages. Returns how many frames
+// were freed; always 0 while swap is inactive, and on CPUs other than the
+// running program's.
+uint32_t mmap_swap_out(uint32_t target);
+
+// Number of anonymous pages currently resident in RAM.
+uint32_t mmap_get_anonymous_resident(void);
+
+// Resolves a not-present fault inside the mmap window. Returns false if
+// the address isn't covered by any mapping.
+bool mmap_handle_fault(uint32_t fault_addr);
+
+#endif // MMAP_H
@@ -0,0 +1,237 @@
+#include "paging.h"
+#include "mmap.h"
+#include "../src/cpu.h"
+#include "../src/cpu_features.h"
+#include "../drivers/terminal.h"
+
+// Linker-provided bounds of the read-only part of the kernel image
+// (.text and .rodata, page aligned). See linker.ld.
+extern uint32_t kernel_text_start;
+extern uint32_t kernel_rodata_end;
+
+static uint32_t* kernel_page_directory = 0;
+static bool pse_supported = false;
+static uint32_t global_flag = 0; // PAGE_GLOBAL when the CPU supports PGE
+
+// --- Internal Helper Functions ---
+
+// Allocates a zeroed page to be used as a page directory or page table.
+static uint32_t* paging_new_table(void) {
+    return (uint32_t*)pmm_alloc_zeroed_page();
+}
+
+// Builds a 4 KiB page table identity-mapping the 4 MiB slot at 'base'.
+// This is only used where permissions inside the slot differ: the null
+// page is left unmapped and the kernel's code/rodata is made read-only.
+static uint32_t* paging_build_identity_table(uint32_t base) {
+    uint32_t* table = paging_new_table();
+    if (table == NULL) {
+        return NULL;
+    }
+
+    uint32_t ro_start = (uint32_t)&kernel_text_start;
+    uint32_t ro_end = (uint32_t)&kernel_rodata_end;
+
+    for (uint32_t i = 0; i < 1024; i++) {
+        uint32_t addr = base + i * PAGE_SIZE;
+        if (addr == 0) {
+            continue; // Leave page 0 unmapped to catch NULL dereferences
+        }
+
+        uint32_t flags = PAGE_PRESENT | global_flag;
+        if (addr < ro_start || addr >= ro_end) {
+            flags |= PAGE_WRITABLE;
+        }
+        table[i] = addr | flags;
+    }
+    return table;
+}
+
+// Returns the page table covering 'virt'. With 'create' set, a missing
+// table is allocated and a 4 MiB page is split into 1024 small pages.
+static uint32_t* paging_get_table(uint32_t virt, bool create) {
+    uint32_t pd_index = virt >> 22;
+    uint32_t pde = kernel_page_directory[pd_index];
+
+    if ((pde & PAGE_PRESENT) && !(pde & PAGE_LARGE)) {
+        return (uint32_t*)(pde & PAGE_FRAME_MASK);
+    }
+    if (!create) {
+        return NULL;
+    }
+
+    uint32_t* table = paging_new_table();
+    if (table == NULL) {
+        return NULL;
+    }
+
+    if (pde & PAGE_PRESENT) {
+        // Split the large page, keeping its attributes for every small page.
+        uint32_t base = pde & LARGE_PAGE_MASK;
+        uint32_t flags = pde & (PAGE_WRITABLE | PAGE_USER | PAGE_PWT | PAGE_PCD | PAGE_GLOBAL);
+        for (uint32_t i = 0; i < 1024; i++) {
+            table[i] = (base + i * PAGE_SIZE) | flags | PAGE_PRESENT;
+        }
+    }
+
+    // The PDE grants everything; the individual PTEs decide.
+    kernel_page_directory[pd_index] = (uint32_t)table | PAGE_PRESENT | PAGE_WRITABLE | PAGE_USER;
+    invlpg(virt & LARGE_PAGE_MASK);
+    return table;
+}
+
+// --- Public API Functions ---
+
+void paging_init(void) {
+    pse_supported = cpu_has(CPU_FEATURE_PSE);
+    if (cpu_has(CPU_FEATURE_PGE)) {
+        global_flag = PAGE_GLOBAL;
+    }
+
+    kernel_page_directory = paging_new_table();
+    if (kernel_page_directory == NULL) {
+        terminal_writeerror("Paging: out of memory for the page directory.");
+        return;
+    }
+
+    uint32_t ro_start = (uint32_t)&kernel_text_start;
+    uint32_t ro_end = (uint32_t)&kernel_rodata_end;
+
+    // The PMM caps total pages at DIRECT_MAP_LIMIT, so this cannot overflow.
+    uint32_t ram_top = pmm_get_total_pages() * PAGE_SIZE;
+    uint32_t slots = (ram_top + LARGE_PAGE_SIZE - 1) / LARGE_PAGE_SIZE;
+
+    for (uint32_t slot = 0; slot < slots; slot++) {
+        uint32_t base = slot * LARGE_PAGE_SIZE;
+        bool has_ro = ro_start < base + LARGE_PAGE_SIZE && ro_end > base;
+
+        if (pse_supported && base != 0 && !has_ro) {
+            // One TLB entry covers the whole 4 MiB: heap, PMM bitmap, etc.
+            kernel_page_directory[slot] = base | PAGE_PRESENT | PAGE_WRITABLE | PAGE_LARGE | global_flag;
+            continue;
+        }
+
+        uint32_t* table = paging_build_identity_table(base);
+        if (table == NULL) {
+            terminal_writeerror("Paging: out of memory building the direct map.");
+            return;
+        }
+        kernel_page_directory[slot] = (uint32_t)table | PAGE_PRESENT | PAGE_WRITABLE;
+    }
+
+    uint32_t cr4 = read_cr4();
+    if (pse_supported) {
+        cr4 |= CR4_PSE;
+    }
+    write_cr4(cr4);
+    write_cr3((uint32_t)kernel_page_directory);
+    write_cr0(read_cr0() | CR0_PG | CR0_WP);
+
+    // Enable global pages only once paging is on, so no stale global
+    // translations can exist from before.
+    if (global_flag) {
+        write_cr4(read_cr4() | CR4_PGE);
+    }
+}
+
+bool paging_map_page(uint32_t virt, uint32_t phys, uint32_t flags) {
+    if (kernel_page_directory == NULL) {
+        return false;
+    }
+
+    uint32_t* table = paging_get_table(virt, true);
+    if (table == NULL) {
+        return false;
+    }
+
+    table[(virt >> 12) & 0x3FF] = (phys & PAGE_FRAME_MASK) | flags | PAGE_PRESENT;
+    invlpg(virt);
+    return true;
+}
+
+void paging_unmap_page(uint32_t virt) {
+    if (kernel_page_directory == NULL) {
+        return;
+    }
+
+    uint32_t* table = paging_get_table(virt, false);
+    if (table == NULL) {
+        return;
+    }
+
+    table[(virt >> 12) & 0x3FF] = 0;
+    invlpg(virt);
+}
+
+bool paging_set_entry(uint32_t virt, uint32_t entry) {
+    if (kernel_page_directory == NULL) {
+        return false;
+    }
+
+    uint32_t* table = paging_get_table(virt, true);
+    if (table == NULL) {
+        return false;
+    }
+
+    table[(virt >> 12) & 0x3FF] = entry;
+    invlpg(virt);
+    return true;
+}
+
+uint32_t paging_get_entry(uint32_t virt) {
+    if (kernel_page_directory == NULL) {
+        return 0;
+    }
+
+    uint32_t pde = kernel_page_directory[virt >> 22];
+    if (!(pde & PAGE_PRESENT)) {
+        return 0;
+    }
+    if (pde & PAGE_LARGE) {
+        return pde;
+    }
+
+    uint32_t* table = (uint32_t*)(pde & PAGE_FRAME_MASK);
+    return table[(virt >> 12) & 0x3FF];
+}
+
+void* paging_map_mmio(uint32_t phys) {
+    if (kernel_page_directory == NULL || phys < DIRECT_MAP_LIMIT) {
+        return (void*)phys;
+    }
+
+    uint32_t pd_index = phys >> 22;
+    if (pse_supported) {
+        // APIC, IOAPIC and HPET all live in the same 4 MiB window at the top
+        // of the address space, so a single uncached large page covers them.
+        if (!(kernel_page_directory[pd_index] & PAGE_PRESENT)) {
+            kernel_page_directory[pd_index] = (phys & LARGE_PAGE_MASK) | PAGE_PRESENT | PAGE_WRITABLE |
+                                              PAGE_LARGE | PAGE_PCD | PAGE_PWT | global_flag;
+            invlpg(phys & LARGE_PAGE_MASK);
+        }
+    } else {
+        paging_map_page(phys, phys, PAGE_WRITABLE | PAGE_PCD | PAGE_PWT | global_flag);
+    }
+    return (void*)phys;
+}
+
+uint32_t paging_get_directory(void) {
+    return (uint32_t)kernel_page_directory;
+}
+
+bool paging_handle_fault(registers_t* regs) {
+    uint32_t fault_addr = read_cr2();
+
+    // Not-present faults in the mmap window are demand fills, not errors
+    if (!(regs->err_code & 0x1) && fault_addr >= MMAP_WINDOW_START && fault_addr < MMAP_WINDOW_END) {
+        if (mmap_handle_fault(fault_addr)) {
+            return true;
+        }
+    }
+
+    terminal_writeerror("Page fault at %x (eip %x, %s%s%s)", fault_addr, regs->eip,
+                        (regs->err_code & 0x1) ? "protection" : "not-present",
+                        (regs->err_code & 0x2) ? ", write" : ", read",
+                        (regs->err_code & 0x4) ? ", user" : "");
+    return false;
+}
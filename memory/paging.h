@@ -0,0 +1,61 @@
+#ifndef PAGING_H
+#define PAGING_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "pmm.h"
+#include "../idt/idt.h"
+
+// --- Page directory / page table entry flags ---
+#define PAGE_PRESENT    0x001
+#define PAGE_WRITABLE   0x002
+#define PAGE_USER       0x004
+#define PAGE_PWT        0x008   // Write-through
+#define PAGE_PCD        0x010   // Cache disable
+#define PAGE_ACCESSED   0x020
+#define PAGE_DIRTY      0x040
+#define PAGE_LARGE      0x080   // PDE only: entry maps a 4 MiB page (PSE)
+#define PAGE_GLOBAL     0x100   // Survives CR3 reloads (needs CR4.PGE)
+#define PAGE_SWAPPED    0x200   // Software bit: not-present PTE holds a swap slot
+
+// A swapped-out PTE keeps its swap slot where the frame address would be
+#define PAGE_SWAP_ENTRY(slot) (((slot) << 12) | PAGE_SWAPPED)
+#define PAGE_SWAP_SLOT(entry) ((entry) >> 12)
+
+#define PAGE_FRAME_MASK 0xFFFFF000
+#define LARGE_PAGE_SIZE 0x400000
+#define LARGE_PAGE_MASK 0xFFC00000
+
+// The kernel identity-maps physical RAM below this address (the "direct
+// map"). The PMM never hands out frames above it, so a physical address
+// returned by pmm_alloc_page() can always be dereferenced as-is.
+#define DIRECT_MAP_LIMIT 0x40000000
+
+// Builds the kernel page directory and turns paging on.
+// Must run after pmm_init() since page tables come from the PMM.
+void paging_init(void);
+
+// Maps a single 4 KiB page. Splits a covering 4 MiB page if needed.
+bool paging_map_page(uint32_t virt, uint32_t phys, uint32_t flags);
+
+// Removes a 4 KiB mapping and flushes it from the TLB.
+void paging_unmap_page(uint32_t virt);
+
+// Writes a raw page table entry (which may be not-present) and flushes it
+// from the TLB. Used to park swap slot numbers in unmapped PTEs.
+bool paging_set_entry(uint32_t virt, uint32_t entry);
+
+// Returns the raw page table entry for 'virt', or 0 if nothing is mapped.
+// For addresses covered by a 4 MiB page the PDE itself is returned.
+uint32_t paging_get_entry(uint32_t virt);
+
+// Identity-maps a device register window uncached and returns its address.
+void* paging_map_mmio(uint32_t phys);
+
+// Physical address of the kernel page directory (the value loaded into CR3).
+uint32_t paging_get_directory(void);
+
+// Handles a page fault (ISR 14). Returns false if the fault is fatal.
+bool paging_handle_fault(registers_t* regs);
+
+#endif // PAGING_H
@@ -1,15 +1,67 @@
 #include "pmm.h"
+#include "paging.h"
 #include <stdint.h>
+#include <stdbool.h>
 #include "../drivers/terminal.h"
+#include "../src/spinlock.h"
+#include "../src/taskpool.h"
+#include "../src/cpu_features.h"
+#include "../src/trace.h"
 
 static uint32_t* pmm_bitmap = 0;
 static uint32_t pmm_total_pages = 0;
 static uint32_t pmm_last_used_page = 0;
+static uint32_t pmm_free_count = 0;
+
+static pmm_shrinker_t pmm_shrinkers[PMM_MAX_SHRINKERS];
+static int pmm_shrinker_count = 0;
+static volatile uint32_t pmm_reclaiming = 0;
+
+// Pages per pmm_get_used_pages() task (a multiple of 32: whole bitmap words)
+#define PMM_COUNT_CHUNK (32 * 1024)
+
+// Guards the bitmap, the counters and the zero pool. It is a leaf lock:
+// shrinkers run without it, since they free pages themselves.
+static spinlock_t pmm_lock = SPINLOCK_INIT;
+
+// Pages zeroed ahead of time by the idle loops. They count as allocated in
+// the bitmap.
+static uint32_t pmm_zero_pool[PMM_ZERO_POOL_SIZE];
+static uint32_t pmm_zero_pool_count = 0;
 
 extern uint32_t kernel_end;
 
+typedef uint32_t (*pmm_weight_fn_t)(const uint32_t* words, uint32_t count);
+
+static uint32_t pmm_weight_swar(const uint32_t* words, uint32_t count);
+
+// Counts the set bits of bitmap words; picked by pmm_init()
+static pmm_weight_fn_t pmm_weight = pmm_weight_swar;
+
 // --- Internal Helper Functions ---
 
+static uint32_t pmm_weight_swar(const uint32_t* words, uint32_t count) {
+    uint32_t total = 0;
+    for (uint32_t i = 0; i < count; i++) {
+        uint32_t x = words[i];
+        x = x - ((x >> 1) & 0x55555555);
+        x = (x & 0x33333333) + ((x >> 2) & 0x33333333);
+        x = (x + (x >> 4)) & 0x0F0F0F0F;
+        total += (x * 0x01010101) >> 24;
+    }
+    return total;
+}
+
+static uint32_t pmm_weight_popcnt(const uint32_t* words, uint32_t count) {
+    uint32_t total = 0;
+    for (uint32_t i = 0; i < count; i++) {
+        uint32_t bits;
+        asm("popcnt %1, %0" : "=r"(bits) : "rm"(words[i]));
+        total += bits;
+    }
+    return total;
+}
+
 static void pmm_set_page(uint32_t page_num) {
     if (page_num >= pmm_total_pages) return;
     pmm_bitmap[page_num / 32] |= (1 << (page_num % 32));
@@ -20,8 +72,47 @@ static void pmm_clear_page(uint32_t page_num) {
     pmm_bitmap[page_num / 32] &= ~(1 << (page_num % 32));
 }
 
+// Zeroes a page a dword at a time rather than byte by byte.
+static void pmm_zero_page(void* page) {
+    uint32_t dest = (uint32_t)page;
+    uint32_t count = PAGE_SIZE / 4;
+    asm volatile("rep stosl"
+                 : "+D"(dest), "+c"(count)
+                 : "a"(0)
+                 : "memory");
+}
+
+// parallel_for() body: counts the used pages in [start, end) and adds them
+// to the total in 'arg'. 'start' is always a multiple of 32.
+static void pmm_count_used(uint32_t start, uint32_t end, void* arg) {
+    uint32_t used = pmm_weight(&pmm_bitmap[start / 32], end / 32 - start / 32);
+    for (uint32_t i = end & ~31u; i < end; i++) {
+        used += pmm_test_page(i);
+    }
+    __sync_fetch_and_add((uint32_t*)arg, used);
+}
+
+static void* pmm_zero_pool_pop(void) {
+    void* page = NULL;
+    uint32_t flags = spin_lock_irqsave(&pmm_lock);
+    if (pmm_zero_pool_count > 0) {
+        page = (void*)pmm_zero_pool[--pmm_zero_pool_count];
+    }
+    spin_unlock_irqrestore(&pmm_lock, flags);
+    return page;
+}
+
 // --- Public API Functions ---
 
+void pmm_dispatch_init(void) {
+    static const cpu_impl_t weight_impls[] = {
+        { "popcnt", CPU_FEATURE_BIT(CPU_FEATURE_POPCNT), pmm_weight_popcnt },
+        { "SWAR", 0, pmm_weight_swar },
+    };
+    static cpu_dispatch_t weight_dispatch = { "PMM bitmap count", (void**)&pmm_weight, weight_impls, 2, NULL, NULL };
+    cpu_dispatch_select(&weight_dispatch);
+}
+
 uint8_t pmm_test_page(uint32_t page_num) {
     if (page_num >= pmm_total_pages) return 1; // Treat out of bounds as used
     return (pmm_bitmap[page_num / 32] >> (page_num % 32)) & 1;
@@ -42,6 +133,11 @@ void pmm_init(multiboot_info_t* mbi) {
         }
         mmap = (multiboot_memory_map_t*)((uint32_t)mmap + mmap->size + sizeof(mmap->size));
     }
+    // Only manage RAM covered by the kernel direct map, so every frame we
+    // hand out is addressable once paging is enabled.
+    if (highest_addr > DIRECT_MAP_LIMIT) {
+        highest_addr = DIRECT_MAP_LIMIT;
+    }
     pmm_total_pages = highest_addr / PAGE_SIZE;
 
     // 2. Place the bitmap right after the kernel
@@ -71,24 +167,115 @@ void pmm_init(multiboot_info_t* mbi) {
     for (uint32_t i = 0; i < reserved_pages; i++) {
         pmm_set_page(i);
     }
+
+    // 6. Count what's left so the watermark check doesn't need a scan
+    for (uint32_t i = 0; i < pmm_total_pages; i++) {
+        if (!pmm_test_page(i)) {
+            pmm_free_count++;
+        }
+    }
 }
 
-void* pmm_alloc_page() {
+// Asks every registered shrinker for pages until 'target' have been freed.
+static uint32_t pmm_reclaim(uint32_t target) {
+    // One reclaimer at a time, system-wide. This also stops shrinkers
+    // from recursing into reclaim when they allocate.
+    if (__sync_lock_test_and_set(&pmm_reclaiming, 1)) return 0;
+
+    // Shrinkers aren't written to be preempted halfway through a sweep
+    uint32_t flags = irq_save();
+    uint32_t freed = 0;
+    for (int i = 0; i < pmm_shrinker_count && freed < target; i++) {
+        freed += pmm_shrinkers[i](target - freed);
+    }
+    irq_restore(flags);
+
+    __sync_lock_release(&pmm_reclaiming);
+    TRACE(TRACE_PMM_RECLAIM, target, freed, 0, 0);
+    return freed;
+}
+
+static void* pmm_claim_page(void) {
     for (uint32_t i = pmm_last_used_page; i < pmm_total_pages / 32; i++) {
         if (pmm_bitmap[i] != 0xFFFFFFFF) {
-            for (int j = 0; j < 32; j++) {
-                if (!(pmm_bitmap[i] & (1 << j))) {
-                    uint32_t page_num = i * 32 + j;
-                    pmm_set_page(page_num);
-                    pmm_last_used_page = i;
-                    return (void*)(page_num * PAGE_SIZE);
-                }
-            }
+            // Lowest clear bit, in one bsf
+            uint32_t page_num = i * 32 + __builtin_ctz(~pmm_bitmap[i]);
+            pmm_set_page(page_num);
+            pmm_last_used_page = i;
+            pmm_free_count--;
+            return (void*)(page_num * PAGE_SIZE);
         }
     }
     return 0; // Out of memory
 }
 
+static void* pmm_claim_page_locked(void) {
+    uint32_t flags = spin_lock_irqsave(&pmm_lock);
+    void* page = pmm_claim_page();
+    spin_unlock_irqrestore(&pmm_lock, flags);
+    return page;
+}
+
+void* pmm_alloc_page() {
+    // Keep some headroom by trimming caches before we actually run dry
+    uint32_t free_count = pmm_free_count;
+    if (free_count < PMM_LOW_WATERMARK) {
+        pmm_reclaim(PMM_LOW_WATERMARK - free_count);
+    }
+
+    void* page = pmm_claim_page_locked();
+    if (page == NULL && pmm_reclaim(1) > 0) {
+        page = pmm_claim_page_locked();
+    }
+    if (page == NULL) {
+        page = pmm_zero_pool_pop(); // Last resort: zeroed pages are pages too
+    }
+    TRACE(TRACE_PMM_ALLOC, page, 0, 0, 0);
+    return page;
+}
+
+void* pmm_alloc_zeroed_page(void) {
+    void* page = pmm_zero_pool_pop();
+    if (page != NULL) {
+        TRACE(TRACE_PMM_ALLOC, page, 1, 0, 0);
+        return page;
+    }
+
+    // Pool is empty: pay for the zeroing now
+    page = pmm_alloc_page();
+    if (page != NULL) {
+        pmm_zero_page(page);
+    }
+    return page;
+}
+
+bool pmm_zero_pool_refill(void) {
+    // Don't hoard pages the shrinkers would otherwise have to reclaim
+    if (pmm_zero_pool_count >= PMM_ZERO_POOL_SIZE || pmm_free_count <= PMM_LOW_WATERMARK) {
+        return false;
+    }
+
+    void* page = pmm_claim_page_locked();
+    if (page == NULL) {
+        return false;
+    }
+
+    // The page is ours now, so it can be zeroed with interrupts enabled
+    pmm_zero_page(page);
+
+    uint32_t flags = spin_lock_irqsave(&pmm_lock);
+    if (pmm_zero_pool_count < PMM_ZERO_POOL_SIZE) {
+        pmm_zero_pool[pmm_zero_pool_count++] = (uint32_t)page;
+        page = NULL;
+    }
+    spin_unlock_irqrestore(&pmm_lock, flags);
+
+    if (page != NULL) {
+        pmm_free_page(page); // Another CPU filled the pool meanwhile
+    }
+    return true;
+}
+
 /**
  * Allocates a specified number of contiguous physical pages.
  * Note: This is a simple implementation and does not check for contiguity.
@@ -125,7 +312,20 @@ void* pmm_alloc_pages(size_t count) {
 
 void pmm_free_page(void* ptr) {
     uint32_t page_num = (uint32_t)ptr / PAGE_SIZE;
-    pmm_clear_page(page_num);
+    if (page_num >= pmm_total_pages) return;
+
+    TRACE(TRACE_PMM_FREE, ptr, 0, 0, 0);
+    uint32_t flags = spin_lock_irqsave(&pmm_lock);
+    if (pmm_test_page(page_num)) { // Ignore pages that are already free
+        pmm_clear_page(page_num);
+        pmm_free_count++;
+
+        // Let the next allocation find this page again
+        if (page_num / 32 < pmm_last_used_page) {
+            pmm_last_used_page = page_num / 32;
+        }
+    }
+    spin_unlock_irqrestore(&pmm_lock, flags);
 }
 
 /**
@@ -155,10 +355,20 @@ uint32_t pmm_get_total_pages(void) {
 
 uint32_t pmm_get_used_pages(void) {
     uint32_t used_pages = 0;
-    for (uint32_t i = 0; i < pmm_total_pages; i++) {
-        if (pmm_test_page(i)) {
-            used_pages++;
-        }
-    }
+    parallel_for(0, pmm_total_pages, PMM_COUNT_CHUNK, pmm_count_used, &used_pages);
     return used_pages;
 }
+
+uint32_t pmm_get_free_pages(void) {
+    return pmm_free_count;
+}
+
+uint32_t pmm_get_zero_pool_count(void) {
+    return pmm_zero_pool_count;
+}
+
+void pmm_register_shrinker(pmm_shrinker_t shrinker) {
+    if (pmm_shrinker_count < PMM_MAX_SHRINKERS) {
+        pmm_shrinkers[pmm_shrinker_count++] = shrinker;
+    }
+}
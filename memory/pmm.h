@@ -4,20 +4,44 @@
 #include <stdint.h>
 #include "../src/multiboot.h" // Include this for the multiboot_info_t struct
 #include <stddef.h>
+#include <stdbool.h>
 
 #define PAGE_SIZE 4096
+
+// When fewer than this many pages are free, allocations first ask the
+// registered shrinkers (caches) to hand memory back.
+#define PMM_LOW_WATERMARK 256
+#define PMM_MAX_SHRINKERS 4
+
+// Number of pre-zeroed pages kept ready for pmm_alloc_zeroed_page().
+#define PMM_ZERO_POOL_SIZE 64
+
+// A shrinker tries to free up to 'target' pages and returns how many it freed.
+typedef uint32_t (*pmm_shrinker_t)(uint32_t target);
 // --- Public Function Prototypes ---
 
 // Correct signature for Multiboot
 void pmm_init(multiboot_info_t* mbi);
 
+// Picks the bitmap counting routine for this CPU (see cpu_dispatch_select()).
+// Call after fpu_init(); until then the portable one is used.
+void pmm_dispatch_init(void);
+
 void* pmm_alloc_page(void);
+// Returns a page filled with zeroes, preferably from the pre-zeroed pool.
+void* pmm_alloc_zeroed_page(void);
+// Zeroes one free page into the pool. Meant for the idle loop; returns
+// false when there is nothing to do (pool full or memory low).
+bool pmm_zero_pool_refill(void);
+uint32_t pmm_get_zero_pool_count(void);
 void* pmm_alloc_pages(size_t count);
 void pmm_free_page(void* ptr);
 void pmm_free_pages(void* ptr, size_t count);
 uint32_t pmm_get_total_pages(void);
 uint32_t pmm_get_used_pages(void);
 uint8_t pmm_test_page(uint32_t page_num); // Expose this for the memmap command
+uint32_t pmm_get_free_pages(void);
+void pmm_register_shrinker(pmm_shrinker_t shrinker);
 
 #endif // PMM_H
 
@@ -0,0 +1,143 @@
+#include "swap.h"
+#include "heap.h"
+#include "../fs/fat32.h"
+#include "../drivers/ide.h"
+#include "../drivers/terminal.h"
+#include "../lib/string.h"
+
+static bool swap_active = false;
+static uint32_t swap_start_lba = 0;
+static uint32_t swap_total_slots = 0;
+static uint32_t swap_used_slots = 0;
+static uint32_t swap_next_slot = 0;   // Where the next slot search starts
+static uint32_t* swap_bitmap = NULL;  // 1 bit per slot, set = in use
+
+// --- Internal Helper Functions ---
+
+static bool swap_test_slot(uint32_t slot) {
+    return (swap_bitmap[slot / 32] >> (slot % 32)) & 1;
+}
+
+static bool swap_alloc_slot(uint32_t* out_slot) {
+    for (uint32_t n = 0; n < swap_total_slots; n++) {
+        uint32_t slot = (swap_next_slot + n) % swap_total_slots;
+        if (!swap_test_slot(slot)) {
+            swap_bitmap[slot / 32] |= (1 << (slot % 32));
+            swap_used_slots++;
+            swap_next_slot = slot + 1;
+            *out_slot = slot;
+            return true;
+        }
+    }
+    return false; // Swap is full
+}
+
+// Creates SWAPFILE.SYS with contiguous clusters and returns its entry.
+static bool swap_create_file(uint32_t dir_cluster, uint32_t size, FAT32_DirectoryEntry* out_entry) {
+    dir_entry_location_t loc;
+    if (!fat32_create_file(SWAP_FILE_NAME, dir_cluster, &loc)) {
+        return false;
+    }
+    if (!fat32_find_entry_by_name(SWAP_FILE_NAME, dir_cluster, NULL, out_entry)) {
+        return false;
+    }
+    if (!fat32_allocate_contiguous(out_entry, size)) {
+        terminal_printf("Error: No contiguous run of %d bytes for the swap file.\n", FG_RED, size);
+        fat32_delete_file(SWAP_FILE_NAME, dir_cluster);
+        return false;
+    }
+    out_entry->attr |= ATTR_SYSTEM | ATTR_HIDDEN;
+    return fat32_update_entry(out_entry, &loc);
+}
+
+// --- Public API Functions ---
+
+bool swap_activate(uint32_t dir_cluster, uint32_t size) {
+    if (swap_active) {
+        terminal_printf("Swap is already active.\n", FG_YELLOW);
+        return false;
+    }
+
+    // Slots are addressed in 512-byte IDE sectors, and the extent below is
+    // in volume sectors; only a volume whose sectors are that size lines up
+    if (g_boot_sector.bytes_per_sec != SWAP_SECTOR_SIZE) {
+        terminal_printf("Error: Swap needs %d-byte sectors; this volume has %d.\n", FG_RED,
+                        SWAP_SECTOR_SIZE, g_boot_sector.bytes_per_sec);
+        return false;
+    }
+
+    FAT32_DirectoryEntry entry;
+    if (!fat32_find_entry_by_name(SWAP_FILE_NAME, dir_cluster, NULL, &entry)) {
+        if (!swap_create_file(dir_cluster, size, &entry)) {
+            return false;
+        }
+    }
+
+    // Resolve the extent once; from here on swap I/O never touches the FAT
+    uint32_t start_cluster = (entry.fst_clus_hi << 16) | entry.fst_clus_lo;
+    uint32_t sectors;
+    if (!fat32_get_contiguous_extent(start_cluster, &swap_start_lba, &sectors)) {
+        terminal_printf("Error: %s is fragmented; delete it and retry.\n", FG_RED, SWAP_FILE_NAME);
+        return false;
+    }
+
+    // Only use whole pages that lie inside the file itself
+    uint32_t file_sectors = entry.file_size / g_boot_sector.bytes_per_sec;
+    if (file_sectors < sectors) {
+        sectors = file_sectors;
+    }
+    swap_total_slots = sectors / SWAP_SECTORS_PER_SLOT;
+    if (swap_total_slots == 0) {
+        return false;
+    }
+
+    uint32_t bitmap_size = ((swap_total_slots + 31) / 32) * sizeof(uint32_t);
+    swap_bitmap = malloc(bitmap_size);
+    if (swap_bitmap == NULL) {
+        return false;
+    }
+    memset(swap_bitmap, 0, bitmap_size);
+
+    swap_used_slots = 0;
+    swap_next_slot = 0;
+    swap_active = true;
+    return true;
+}
+
+bool swap_is_active(void) {
+    return swap_active;
+}
+
+bool swap_write_page(const void* page, uint32_t* out_slot) {
+    if (!swap_active || !swap_alloc_slot(out_slot)) {
+        return false;
+    }
+    uint32_t lba = swap_start_lba + *out_slot * SWAP_SECTORS_PER_SLOT;
+    ide_write_sectors(lba, SWAP_SECTORS_PER_SLOT, (uint8_t*)page);
+    return true;
+}
+
+bool swap_read_page(uint32_t slot, void* page) {
+    if (!swap_active || slot >= swap_total_slots || !swap_test_slot(slot)) {
+        return false;
+    }
+    uint32_t lba = swap_start_lba + slot * SWAP_SECTORS_PER_SLOT;
+    ide_read_sectors(lba, SWAP_SECTORS_PER_SLOT, (uint8_t*)page);
+    return true;
+}
+
+void swap_free_slot(uint32_t slot) {
+    if (!swap_active || slot >= swap_total_slots || !swap_test_slot(slot)) {
+        return;
+    }
+    swap_bitmap[slot / 32] &= ~(1 << (slot % 32));
+    swap_used_slots--;
+}
+
+uint32_t swap_get_total_slots(void) {
+    return swap_total_slots;
+}
+
+uint32_t swap_get_used_slots(void) {
+    return swap_used_slots;
+}
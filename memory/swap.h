@@ -0,0 +1,32 @@
+#ifndef SWAP_H
+#define SWAP_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+// Anonymous pages are swapped to a preallocated, physically contiguous file
+// on the FAT32 volume. Its sector extent is resolved once when swap is
+// activated, so swap I/O goes straight to the disk and bypasses FAT32.
+#define SWAP_FILE_NAME      "SWAPFILE.SYS"
+#define SWAP_DEFAULT_SIZE   (4 * 1024 * 1024)
+#define SWAP_SECTOR_SIZE    512 // What the IDE driver reads and writes
+#define SWAP_SECTORS_PER_SLOT 8 // One 4 KiB page per slot
+
+// Activates swapping to SWAPFILE.SYS in 'dir_cluster', creating it with
+// 'size' bytes of contiguous clusters if it doesn't exist yet.
+bool swap_activate(uint32_t dir_cluster, uint32_t size);
+
+bool swap_is_active(void);
+
+// Writes a page to a free slot and returns the slot number in 'out_slot'.
+bool swap_write_page(const void* page, uint32_t* out_slot);
+
+// Reads a slot back into 'page'. The slot stays allocated.
+bool swap_read_page(uint32_t slot, void* page);
+
+void swap_free_slot(uint32_t slot);
+
+uint32_t swap_get_total_slots(void);
+uint32_t swap_get_used_slots(void);
+
+#endif // SWAP_H
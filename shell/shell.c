@@ -6,9 +6,19 @@
 #include "../lib/math.h"
 #include "../memory/pmm.h"
 #include "../memory/heap.h"
-#include "../fs/elf.h"
+#include "../fs/pagecache.h"
+#include "../memory/swap.h"
+#include "../memory/mmap.h"
+#include "../src/sched.h"
+#include "../src/smp.h"
+#include "../src/process.h"
+#include "../drivers/ioapic.h"
+#include "../drivers/timer.h"
+#include "../src/cpu_features.h"
+#include "../src/trace.h"
+#include "../src/profile.h"
+#include "../drivers/serial.h"
 
-jmp_buf g_shell_checkpoint;
 uint32_t g_current_directory_cluster;
 #define MAX_PATH_LENGTH 256
 char g_current_path[MAX_PATH_LENGTH] = "root"; // Start at the root;
@@ -30,6 +40,14 @@ static void cmd_run(int argc, char* argv[]);
 static void cmd_dInfo(int argc, char* argv[]);
 static void cmd_fwrite(int argc, char* argv[]);
 static void cmd_cat(int argc, char* argv[]);
+static void cmd_swapon(int argc, char* argv[]);
+static void cmd_ps(int argc, char* argv[]);
+static void cmd_irqs(int argc, char* argv[]);
+static void cmd_cpustat(int argc, char* argv[]);
+static void cmd_cpuinfo(int argc, char* argv[]);
+static void cmd_trace(int argc, char* argv[]);
+static void cmd_profile(int argc, char* argv[]);
+static void cmd_membench(int argc, char* argv[]);
 
 // The command structure definition (internal)
 typedef struct {
@@ -56,7 +74,15 @@ static const shell_command_t commands[] = {
     {"run", cmd_run, "Runs a binary file!\n"},
     {"dInfo", cmd_dInfo, "Shows info of all attached drives\n"},
     {"fwrite", cmd_fwrite, "Writes a buffer to the specified file\n"},
-    {"cat", cmd_cat, "Reads a file to the terminal\n"}
+    {"cat", cmd_cat, "Reads a file to the terminal\n"},
+    {"swapon", cmd_swapon, "Enables swapping to SWAPFILE.SYS (created with the given size in KB if missing).\n"},
+    {"ps", cmd_ps, "Lists kernel threads.\n"},
+    {"irqs", cmd_irqs, "Lists which CPU takes each IRQ; 'irqs <irq> <cpu>' moves one.\n"},
+    {"cpustat", cmd_cpustat, "Shows how much time each CPU has spent idle and busy.\n"},
+    {"cpuinfo", cmd_cpuinfo, "Shows the CPU's features and which implementation each hot routine uses.\n"},
+    {"membench", cmd_membench, "Measures memcpy/memset throughput (MB/s) for a range of sizes.\n"},
+    {"trace", cmd_trace, "Event tracing: 'trace on|off|clear', 'trace dump [serial]', 'trace stream' (to serial).\n"},
+    {"profile", cmd_profile, "Sampling profiler: 'profile start [-g]', 'profile stop', 'profile report [n]', 'profile folded' (to serial).\n"}
 };
 static const int num_commands = sizeof(commands) / sizeof(shell_command_t);
 
@@ -204,6 +230,14 @@ static void cmd_memmap(int argc, char* argv[]) {
     terminal_printf("  Used:  %d pages (%d MB)\n", FG_RED, used_pages, used_mb);
     terminal_printf("  Free:  %d pages (%d MB)\n", FG_GREEN, free_pages, free_mb);
     terminal_printf("  Heap:  %d pages (%d MB)\n", FG_GREEN, HEAP_SIZE_PAGES, heap_mb);
+    terminal_printf("  Cache: %d pages (%d KB)\n", FG_GREEN, pagecache_get_page_count(), pagecache_get_page_count() * 4);
+    terminal_printf("  Zeroed: %d pages ready\n", FG_GREEN, pmm_get_zero_pool_count());
+    terminal_printf("  Anon:  %d pages (%d KB)\n", FG_GREEN, mmap_get_anonymous_resident(), mmap_get_anonymous_resident() * 4);
+    if (swap_is_active()) {
+        terminal_printf("  Swap:  %d / %d pages used\n", FG_GREEN, swap_get_used_slots(), swap_get_total_slots());
+    } else {
+        terminal_printf("  Swap:  off\n", FG_WHITE);
+    }
     terminal_printf("\nMemory Map (1 char = 512KB | 128 pages):\n", FG_MAGENTA);
 
     int pages_per_char = 128; // 1MB worth of 4KB pages
@@ -455,20 +489,13 @@ void cmd_run(int argc, char* argv[]) {
 
     terminal_printf("Executing '%s'...\n", FG_MAGENTA, argv[1]);
 
-    uint32_t entry_point = elf_load(program_entry);
-
-    if (entry_point == 0) {
+    // Runs in ring 3 on its own thread; we sleep until it exits
+    int status;
+    if (!process_run(program_entry, &status)) {
         terminal_printf("Failed to execute program (ELF loading error).\n", FG_RED);
         return;
     }
-
-    void (*program_start)(void) = (void (*)(void))entry_point;
-
-    if (setjmp(g_shell_checkpoint) == 0) {
-        program_start();
-    } else {
-        terminal_printf("\nProgram finished, returning to shell.\n", FG_GREEN);
-    }
+    terminal_printf("\nProgram finished (status %d), returning to shell.\n", FG_GREEN, status);
 }
 
 void cmd_dInfo(int argc, char* argv[]) {
@@ -552,6 +579,298 @@ void cmd_cat(int argc, char* argv[]) {
     free(buffer);
     free(file);
 }
+void cmd_swapon(int argc, char* argv[]) {
+    uint32_t size = SWAP_DEFAULT_SIZE;
+
+    if (argc >= 2) {
+        uint32_t size_kb = 0;
+        for (const char* p = argv[1]; *p; p++) {
+            if (*p < '0' || *p > '9') {
+                terminal_printf("USAGE: swapon [size_kb]\n", FG_MAGENTA);
+                return;
+            }
+            size_kb = size_kb * 10 + (*p - '0');
+        }
+        size = size_kb * 1024;
+    }
+
+    // The swap file always lives in the root directory
+    if (swap_activate(fat32_get_root_cluster(), size)) {
+        terminal_printf("Swap enabled: %d pages.\n", FG_GREEN, swap_get_total_slots());
+    } else {
+        terminal_printf("ERROR: Failed to enable swap.\n", FG_RED);
+    }
+}
+void cmd_ps(int argc, char* argv[]) {
+    (void)argc; // Unused
+    (void)argv; // Unused
+    sched_print_threads();
+}
+// Parses a decimal number. Returns false on anything else.
+static bool parse_uint(const char* str, uint32_t* out) {
+    if (*str == '\0') return false;
+    uint32_t value = 0;
+    for (const char* p = str; *p; p++) {
+        if (*p < '0' || *p > '9') return false;
+        value = value * 10 + (*p - '0');
+    }
+    *out = value;
+    return true;
+}
+void cmd_irqs(int argc, char* argv[]) {
+    if (!ioapic_is_enabled()) {
+        terminal_printf("No I/O APIC: all IRQs go through the 8259 to CPU 0.\n", FG_YELLOW);
+        return;
+    }
+
+    if (argc == 3) {
+        uint32_t irq, cpu;
+        if (!parse_uint(argv[1], &irq) || !parse_uint(argv[2], &cpu) || irq >= IOAPIC_ISA_IRQS) {
+            terminal_printf("USAGE: irqs [<irq> <cpu>]\n", FG_MAGENTA);
+            return;
+        }
+        if (cpu >= smp_cpu_count() || ioapic_get_irq_target(irq) < 0) {
+            terminal_printf("ERROR: No such CPU, or IRQ %d isn't in use.\n", FG_RED, irq);
+            return;
+        }
+        ioapic_route_irq(irq, cpus[cpu].apic_id);
+        return;
+    }
+
+    terminal_printf("  IRQ  CPU\n", FG_MAGENTA);
+    for (uint32_t irq = 0; irq < IOAPIC_ISA_IRQS; irq++) {
+        int target = ioapic_get_irq_target(irq);
+        if (target < 0) continue;
+        for (uint32_t cpu = 0; cpu < smp_cpu_count(); cpu++) {
+            if (cpus[cpu].apic_id == (uint32_t)target) {
+                terminal_printf("  %d    %d\n", FG_WHITE, irq, cpu);
+            }
+        }
+    }
+}
+
+void cmd_cpustat(int argc, char* argv[]) {
+    (void)argc; // Unused
+    (void)argv; // Unused
+
+    terminal_printf("  CPU  IDLE MS    BUSY MS    IDLE PCT\n", FG_MAGENTA);
+    for (uint32_t cpu = 0; cpu < smp_cpu_count(); cpu++) {
+        uint64_t idle_ns, total_ns;
+        sched_cpu_time(cpu, &idle_ns, &total_ns);
+        uint32_t idle_ms = (uint32_t)div_u64_rem(idle_ns, 1000000, NULL);
+        uint32_t total_ms = (uint32_t)div_u64_rem(total_ns, 1000000, NULL);
+        uint32_t busy_ms = (total_ms > idle_ms) ? total_ms - idle_ms : 0;
+        uint32_t pct = (total_ms > 0) ? (uint32_t)div_u64_rem((uint64_t)idle_ms * 100, total_ms, NULL) : 100;
+        terminal_printf("  %d    %d       %d       %d\n", FG_WHITE, cpu, idle_ms, busy_ms, pct);
+    }
+}
+
+void cmd_cpuinfo(int argc, char* argv[]) {
+    (void)argc; // Unused
+    (void)argv; // Unused
+
+    const cpu_info_t* info = cpu_get_info();
+    terminal_printf("Vendor:   %s\n", FG_WHITE, info->vendor);
+    if (info->brand[0] != '\0') {
+        terminal_printf("Model:    %s\n", FG_WHITE, info->brand);
+    }
+    terminal_printf("Family %d, model %d, stepping %d\n", FG_WHITE, info->family, info->model, info->stepping);
+
+    terminal_printf("Features:", FG_WHITE);
+    for (uint32_t f = 0; f < CPU_FEATURE_COUNT; f++) {
+        if (cpu_has((cpu_feature_t)f)) {
+            terminal_printf(" %s", FG_WHITE, cpu_feature_name((cpu_feature_t)f));
+        }
+    }
+    terminal_printf("\n", FG_WHITE);
+
+    terminal_printf("  ROUTINE               IMPLEMENTATION\n", FG_MAGENTA);
+    for (const cpu_dispatch_t* d = cpu_dispatch_list(); d != NULL; d = d->next) {
+        const char* chosen = (d->chosen != NULL) ? d->chosen->name : "(default)";
+        terminal_printf("  %s: %s\n", FG_WHITE, d->name, chosen);
+    }
+}
+
+// Writes one line of trace output to the screen or the serial port.
+static void trace_put_line(const char* line, bool serial) {
+    if (serial) {
+        serial_write(line, strlen(line));
+        serial_write("\r\n", 2);
+    } else {
+        terminal_writestring(line, FG_WHITE);
+        terminal_putchar('\n', FG_WHITE);
+    }
+}
+
+static char* trace_put_hex(char* p, uint32_t value, int digits) {
+    for (int i = digits - 1; i >= 0; i--) {
+        p[i] = "0123456789abcdef"[value & 0xF];
+        value >>= 4;
+    }
+    p[digits] = ' ';
+    return p + digits + 1;
+}
+
+// trace_read() callback: one record per line, as
+// "<cpu> <time> <thread> <event> <arg0> <arg1> <arg2> <arg3>", all in hex
+// except the event name.
+static void trace_emit_record(uint32_t cpu, const trace_record_t* record, void* arg) {
+    char line[96];
+    char* p = line;
+    p = trace_put_hex(p, cpu, 1);
+    p = trace_put_hex(p, (uint32_t)(record->time >> 32), 8);
+    p = trace_put_hex(p - 1, (uint32_t)record->time, 8); // One 16-digit number
+    p = trace_put_hex(p, record->thread, 4);
+    strcpy(p, trace_event_name(record->event));
+    p += strlen(p);
+    *p++ = ' ';
+    for (int i = 0; i < 4; i++) {
+        p = trace_put_hex(p, record->args[i], 8);
+    }
+    p[-1] = '\0';
+    trace_put_line(line, *(bool*)arg);
+}
+
+static void trace_put_lost(uint32_t lost, bool serial) {
+    if (lost > 0) {
+        char line[32] = "# lost ";
+        itoa(lost, line + strlen(line), 10);
+        trace_put_line(line, serial);
+    }
+}
+
+void cmd_trace(int argc, char* argv[]) {
+    if (argc < 2) {
+        terminal_printf("Usage: trace on|off|clear|dump [serial]|stream\n", FG_RED);
+        return;
+    }
+
+    if (strcmp(argv[1], "on") == 0) {
+        trace_set_enabled(true);
+    } else if (strcmp(argv[1], "off") == 0) {
+        trace_set_enabled(false);
+    } else if (strcmp(argv[1], "clear") == 0) {
+        trace_clear();
+    } else if (strcmp(argv[1], "dump") == 0 || strcmp(argv[1], "stream") == 0) {
+        bool stream = (argv[1][0] == 's');
+        bool serial = stream || (argc > 2 && strcmp(argv[2], "serial") == 0);
+        if (serial && !serial_present()) {
+            terminal_printf("ERROR: There is no serial port.\n", FG_RED);
+            return;
+        }
+
+        char header[48] = "# trace clock_khz=";
+        itoa(trace_clock_khz(), header + strlen(header), 10);
+        trace_put_line(header, serial);
+        trace_put_line("# cpu time thread event arg0 arg1 arg2 arg3", serial);
+
+        trace_cursor_t cursor;
+        trace_cursor_init(&cursor, !stream);
+        if (!stream) {
+            trace_put_lost(trace_read(&cursor, trace_emit_record, &serial), serial);
+            return;
+        }
+
+        terminal_printf("Streaming to the serial port; press any key to stop.\n", FG_WHITE);
+        int key;
+        while (!keyboard_try_get_key(&key)) {
+            trace_put_lost(trace_read(&cursor, trace_emit_record, &serial), serial);
+            thread_sleep_ms(10);
+        }
+    } else {
+        terminal_printf("Usage: trace on|off|clear|dump [serial]|stream\n", FG_RED);
+    }
+}
+
+#define PROFILE_REPORT_ROWS 20
+
+static void cmd_profile(int argc, char* argv[]) {
+    if (argc < 2) {
+        terminal_printf("Usage: profile start [-g]|stop|report [n]|folded\n", FG_RED);
+        return;
+    }
+
+    if (strcmp(argv[1], "start") == 0) {
+        bool callchains = (argc > 2 && strcmp(argv[2], "-g") == 0);
+        if (!profile_start(callchains)) {
+            terminal_printf("ERROR: Not enough memory for the sample buffers.\n", FG_RED);
+        }
+    } else if (strcmp(argv[1], "stop") == 0) {
+        profile_stop();
+    } else if (strcmp(argv[1], "report") == 0) {
+        uint32_t rows = PROFILE_REPORT_ROWS;
+        if (argc > 2 && !parse_uint(argv[2], &rows)) {
+            terminal_printf("Usage: profile report [n]\n", FG_RED);
+            return;
+        }
+        profile_print_report(rows);
+    } else if (strcmp(argv[1], "folded") == 0) {
+        if (!serial_present()) {
+            terminal_printf("ERROR: There is no serial port.\n", FG_RED);
+            return;
+        }
+        if (profile_running()) {
+            terminal_printf("ERROR: Stop the profiler first.\n", FG_RED);
+            return;
+        }
+        terminal_printf("Wrote %d samples to the serial port.\n", FG_WHITE, profile_export_folded());
+    } else {
+        terminal_printf("Usage: profile start [-g]|stop|report [n]|folded\n", FG_RED);
+    }
+}
+
+#define MEMBENCH_MAX_SIZE (256 * 1024)
+#define MEMBENCH_BYTES    (4 * 1024 * 1024) // Moved per measurement
+
+typedef enum { MEMBENCH_BYTE_LOOP, MEMBENCH_MEMCPY, MEMBENCH_MEMSET } membench_op_t;
+
+// Runs 'op' on 'size' bytes until MEMBENCH_BYTES have been moved and
+// returns the rate in MB/s. The byte loop is the baseline: what memcpy
+// used to be.
+static uint32_t membench_rate(membench_op_t op, uint8_t* dest, const uint8_t* src, uint32_t size) {
+    uint32_t rounds = MEMBENCH_BYTES / size;
+    uint64_t start = ktime_ns();
+    for (uint32_t i = 0; i < rounds; i++) {
+        if (op == MEMBENCH_BYTE_LOOP) {
+            volatile uint8_t* d = dest; // Keep the compiler from making it a memcpy call
+            for (uint32_t j = 0; j < size; j++) {
+                d[j] = src[j];
+            }
+        } else if (op == MEMBENCH_MEMCPY) {
+            memcpy(dest, src, size);
+        } else {
+            memset(dest, i, size);
+        }
+    }
+    uint32_t us = (uint32_t)div_u64_rem(ktime_ns() - start, 1000, NULL);
+    return (rounds * size) / (us == 0 ? 1 : us); // Bytes per microsecond is MB/s
+}
+
+void cmd_membench(int argc, char* argv[]) {
+    (void)argc; // Unused
+    (void)argv; // Unused
+
+    uint8_t* src = malloc(MEMBENCH_MAX_SIZE);
+    uint8_t* dest = malloc(MEMBENCH_MAX_SIZE);
+    if (src == NULL || dest == NULL) {
+        terminal_printf("ERROR: Not enough memory for the buffers.\n", FG_RED);
+        free(src);
+        free(dest);
+        return;
+    }
+    memset(src, 0x5A, MEMBENCH_MAX_SIZE);
+
+    terminal_printf("  BYTES     BYTE LOOP  MEMCPY     MEMSET   (MB/s)\n", FG_MAGENTA);
+    for (uint32_t size = 16; size <= MEMBENCH_MAX_SIZE; size *= 4) {
+        uint32_t loop = membench_rate(MEMBENCH_BYTE_LOOP, dest, src, size);
+        uint32_t copy = membench_rate(MEMBENCH_MEMCPY, dest, src, size);
+        uint32_t fill = membench_rate(MEMBENCH_MEMSET, dest, src, size);
+        terminal_printf("  %d     %d       %d       %d\n", FG_WHITE, size, loop, copy, fill);
+    }
+
+    free(src);
+    free(dest);
+}
 // Command History definition
 #define HISTORY_MAX_SIZE 16 // Store the last 16 commands
 
@@ -708,6 +1027,14 @@ void shell_handle_key(int key) {
     }
 }
 
+// The shell thread: takes keys from the keyboard ring and runs commands,
+// so nothing here executes in interrupt context.
+void shell_main_loop(void) {
+    for (;;) {
+        shell_handle_key(keyboard_get_key());
+    }
+}
+
 uint32_t shell_getCurrentDirCluster(void) {
   return g_current_directory_cluster;
 }
@@ -0,0 +1,156 @@
+#include "acpi.h"
+#include "../memory/paging.h"
+#include "../lib/string.h"
+
+typedef struct {
+    char signature[8];      // "RSD PTR "
+    uint8_t checksum;
+    char oem_id[6];
+    uint8_t revision;
+    uint32_t rsdt_address;
+} __attribute__((packed)) acpi_rsdp_t;
+
+typedef struct {
+    char signature[4];
+    uint32_t length;        // Including this header
+    uint8_t revision;
+    uint8_t checksum;
+    char oem_id[6];
+    char oem_table_id[8];
+    uint32_t oem_revision;
+    uint32_t creator_id;
+    uint32_t creator_revision;
+} __attribute__((packed)) acpi_sdt_header_t;
+
+typedef struct {
+    acpi_sdt_header_t header;
+    uint32_t lapic_address;
+    uint32_t flags;         // Bit 0: PCAT_COMPAT
+} __attribute__((packed)) acpi_madt_t;
+
+// MADT entry types
+#define MADT_LOCAL_APIC     0
+#define MADT_IO_APIC        1
+#define MADT_ISO            2  // Interrupt source override
+
+#define MADT_LAPIC_ENABLED  0x1
+
+static acpi_madt_info_t madt_info;
+static bool madt_found = false;
+
+// --- Internal Helper Functions ---
+
+static bool acpi_checksum_ok(const void* data, uint32_t length) {
+    const uint8_t* bytes = data;
+    uint8_t sum = 0;
+    for (uint32_t i = 0; i < length; i++) {
+        sum += bytes[i];
+    }
+    return sum == 0;
+}
+
+// Makes sure [phys, phys + length) can be read. Firmware tables usually sit
+// below the direct map limit, but on big machines they can live above it.
+static void* acpi_map(uint32_t phys, uint32_t length) {
+    for (uint32_t page = phys & PAGE_FRAME_MASK; page < phys + length; page += PAGE_SIZE) {
+        paging_map_mmio(page);
+    }
+    return (void*)phys;
+}
+
+static acpi_sdt_header_t* acpi_map_table(uint32_t phys) {
+    acpi_sdt_header_t* header = acpi_map(phys, sizeof(acpi_sdt_header_t));
+    acpi_map(phys, header->length);
+    if (!acpi_checksum_ok(header, header->length)) {
+        return NULL;
+    }
+    return header;
+}
+
+// The RSDP is on a 16-byte boundary in the EBDA or the BIOS ROM area. The
+// EBDA pointer lives in the (unmapped) null page, so scan the whole region
+// below the 640 KiB hole where the EBDA can sit instead.
+static acpi_rsdp_t* acpi_find_rsdp(void) {
+    static const uint32_t ranges[][2] = {
+        { 0x80000, 0xA0000 },   // EBDA
+        { 0xE0000, 0x100000 },  // BIOS ROM
+    };
+
+    for (int r = 0; r < 2; r++) {
+        for (uint32_t addr = ranges[r][0]; addr < ranges[r][1]; addr += 16) {
+            acpi_rsdp_t* rsdp = (acpi_rsdp_t*)addr;
+            if (strncmp(rsdp->signature, "RSD PTR ", 8) == 0 && acpi_checksum_ok(rsdp, sizeof(acpi_rsdp_t))) {
+                return rsdp;
+            }
+        }
+    }
+    return NULL;
+}
+
+static void acpi_parse_madt(acpi_madt_t* madt) {
+    madt_info.lapic_address = madt->lapic_address;
+    madt_info.has_8259 = madt->flags & 0x1;
+
+    uint8_t* entry = (uint8_t*)madt + sizeof(acpi_madt_t);
+    uint8_t* end = (uint8_t*)madt + madt->header.length;
+
+    while (entry + 2 <= end && entry[1] >= 2) {
+        switch (entry[0]) {
+            case MADT_LOCAL_APIC: {
+                uint8_t apic_id = entry[3];
+                uint32_t flags = *(uint32_t*)(entry + 4);
+                if ((flags & MADT_LAPIC_ENABLED) && madt_info.cpu_count < ACPI_MAX_CPUS) {
+                    madt_info.cpus[madt_info.cpu_count++].apic_id = apic_id;
+                }
+                break;
+            }
+            case MADT_IO_APIC:
+                if (madt_info.ioapic_count < ACPI_MAX_IOAPICS) {
+                    acpi_ioapic_t* ioapic = &madt_info.ioapics[madt_info.ioapic_count++];
+                    ioapic->id = entry[2];
+                    ioapic->address = *(uint32_t*)(entry + 4);
+                    ioapic->gsi_base = *(uint32_t*)(entry + 8);
+                }
+                break;
+            case MADT_ISO:
+                if (madt_info.override_count < ACPI_MAX_OVERRIDES) {
+                    acpi_override_t* iso = &madt_info.overrides[madt_info.override_count++];
+                    iso->source_irq = entry[3];
+                    iso->gsi = *(uint32_t*)(entry + 4);
+                    iso->flags = *(uint16_t*)(entry + 8);
+                }
+                break;
+        }
+        entry += entry[1];
+    }
+}
+
+// --- Public API Functions ---
+
+bool acpi_init(void) {
+    acpi_rsdp_t* rsdp = acpi_find_rsdp();
+    if (rsdp == NULL) {
+        return false;
+    }
+
+    acpi_sdt_header_t* rsdt = acpi_map_table(rsdp->rsdt_address);
+    if (rsdt == NULL) {
+        return false;
+    }
+
+    uint32_t count = (rsdt->length - sizeof(acpi_sdt_header_t)) / 4;
+    uint32_t* tables = (uint32_t*)((uint8_t*)rsdt + sizeof(acpi_sdt_header_t));
+    for (uint32_t i = 0; i < count; i++) {
+        acpi_sdt_header_t* table = acpi_map_table(tables[i]);
+        if (table != NULL && strncmp(table->signature, "APIC", 4) == 0) {
+            acpi_parse_madt((acpi_madt_t*)table);
+            madt_found = true;
+            break;
+        }
+    }
+    return madt_found;
+}
+
+const acpi_madt_info_t* acpi_get_madt(void) {
+    return madt_found ? &madt_info : NULL;
+}
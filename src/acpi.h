@@ -0,0 +1,49 @@
+#ifndef ACPI_H
+#define ACPI_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+// --- ACPI MADT ---
+// Just enough ACPI to find the CPUs and interrupt controllers: the RSDP is
+// located in the BIOS areas, the RSDT walked, and the MADT ("APIC") parsed.
+
+#define ACPI_MAX_CPUS      16
+#define ACPI_MAX_IOAPICS   4
+#define ACPI_MAX_OVERRIDES 16
+
+typedef struct {
+    uint8_t apic_id;
+} acpi_cpu_t;
+
+typedef struct {
+    uint8_t id;
+    uint32_t address;
+    uint32_t gsi_base;   // First global system interrupt it handles
+} acpi_ioapic_t;
+
+// A legacy ISA IRQ that is wired to a different GSI or polarity/trigger
+typedef struct {
+    uint8_t source_irq;
+    uint32_t gsi;
+    uint16_t flags;      // MPS INTI flags: polarity (bits 0-1), trigger (bits 2-3)
+} acpi_override_t;
+
+typedef struct {
+    uint32_t lapic_address;
+    bool has_8259;       // PC/AT dual 8259 present (PCAT_COMPAT)
+    uint32_t cpu_count;
+    acpi_cpu_t cpus[ACPI_MAX_CPUS];
+    uint32_t ioapic_count;
+    acpi_ioapic_t ioapics[ACPI_MAX_IOAPICS];
+    uint32_t override_count;
+    acpi_override_t overrides[ACPI_MAX_OVERRIDES];
+} acpi_madt_info_t;
+
+// Finds and parses the MADT. Returns false if there is no usable ACPI.
+bool acpi_init(void);
+
+// Parsed MADT contents, or NULL if acpi_init() failed.
+const acpi_madt_info_t* acpi_get_madt(void);
+
+#endif // ACPI_H
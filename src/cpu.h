@@ -0,0 +1,163 @@
+#ifndef CPU_H
+#define CPU_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+// Small inline wrappers around privileged x86 instructions.
+// Everything here is header-only so it can be used from any subsystem
+// without pulling in another object file.
+
+// CR0 bits
+#define CR0_PE (1 << 0)   // Protected mode enable
+#define CR0_MP (1 << 1)   // WAIT/FWAIT honour TS
+#define CR0_EM (1 << 2)   // No FPU: x87 instructions trap with #NM
+#define CR0_TS (1 << 3)   // Task switched: the next FPU/SIMD instruction traps with #NM
+#define CR0_NE (1 << 5)   // Report x87 errors as #MF rather than through the PIC
+#define CR0_WP (1 << 16)  // Honour read-only pages in ring 0
+#define CR0_PG (1u << 31) // Paging enable
+
+// CR4 bits
+#define CR4_PSE (1 << 4)  // 4 MiB pages
+#define CR4_PGE (1 << 7)  // Global pages
+#define CR4_OSFXSR (1 << 9)      // FXSAVE/FXRSTOR and SSE instructions
+#define CR4_OSXMMEXCPT (1 << 10) // Unmasked SIMD exceptions raise #XM
+#define CR4_OSXSAVE (1 << 18)    // XSAVE/XRSTOR and XGETBV/XSETBV
+
+// EFLAGS bits
+#define EFLAGS_IF 0x200   // Interrupts enabled
+
+// Model-specific registers
+#define MSR_SYSENTER_CS  0x174
+#define MSR_SYSENTER_ESP 0x175
+#define MSR_SYSENTER_EIP 0x176
+
+static inline void cpuid(uint32_t leaf, uint32_t* eax, uint32_t* ebx, uint32_t* ecx, uint32_t* edx) {
+    asm volatile("cpuid"
+                 : "=a"(*eax), "=b"(*ebx), "=c"(*ecx), "=d"(*edx)
+                 : "a"(leaf), "c"(0));
+}
+
+// Like cpuid(), for leaves that take a subleaf in ECX.
+static inline void cpuid_count(uint32_t leaf, uint32_t subleaf, uint32_t* eax, uint32_t* ebx, uint32_t* ecx, uint32_t* edx) {
+    asm volatile("cpuid"
+                 : "=a"(*eax), "=b"(*ebx), "=c"(*ecx), "=d"(*edx)
+                 : "a"(leaf), "c"(subleaf));
+}
+
+static inline uint32_t read_cr0(void) {
+    uint32_t value;
+    asm volatile("mov %%cr0, %0" : "=r"(value));
+    return value;
+}
+
+static inline void write_cr0(uint32_t value) {
+    asm volatile("mov %0, %%cr0" : : "r"(value) : "memory");
+}
+
+static inline uint32_t read_cr2(void) {
+    uint32_t value;
+    asm volatile("mov %%cr2, %0" : "=r"(value));
+    return value;
+}
+
+static inline uint32_t read_cr3(void) {
+    uint32_t value;
+    asm volatile("mov %%cr3, %0" : "=r"(value));
+    return value;
+}
+
+static inline void write_cr3(uint32_t value) {
+    asm volatile("mov %0, %%cr3" : : "r"(value) : "memory");
+}
+
+static inline uint32_t read_cr4(void) {
+    uint32_t value;
+    asm volatile("mov %%cr4, %0" : "=r"(value));
+    return value;
+}
+
+static inline void write_cr4(uint32_t value) {
+    asm volatile("mov %0, %%cr4" : : "r"(value) : "memory");
+}
+
+// Clears CR0.TS without the cost of a full CR0 write.
+static inline void clts(void) {
+    asm volatile("clts" : : : "memory");
+}
+
+// Sets extended control register 'index' (XCR0 selects the XSAVE state).
+static inline void xsetbv(uint32_t index, uint64_t value) {
+    asm volatile("xsetbv" : : "c"(index), "a"((uint32_t)value), "d"((uint32_t)(value >> 32)));
+}
+
+// Drops the TLB entry for a single virtual address.
+static inline void invlpg(uint32_t addr) {
+    asm volatile("invlpg (%0)" : : "r"(addr) : "memory");
+}
+
+static inline uint64_t rdmsr(uint32_t msr) {
+    uint32_t low, high;
+    asm volatile("rdmsr" : "=a"(low), "=d"(high) : "c"(msr));
+    return ((uint64_t)high << 32) | low;
+}
+
+static inline void wrmsr(uint32_t msr, uint64_t value) {
+    asm volatile("wrmsr" : : "c"(msr), "a"((uint32_t)value), "d"((uint32_t)(value >> 32)));
+}
+
+// Arms address monitoring on the cache line holding 'addr' for mwait().
+static inline void monitor(const volatile void* addr) {
+    asm volatile("monitor" : : "a"(addr), "c"(0), "d"(0));
+}
+
+// Enables interrupts and waits, in C1, for an interrupt or a write to the
+// monitored line. STI's one-instruction delay means an interrupt can't
+// sneak in between the caller's last check and the wait.
+static inline void sti_mwait(void) {
+    asm volatile("sti; mwait" : : "a"(0), "c"(0) : "memory");
+}
+
+// Same for HLT, which only an interrupt ends.
+static inline void sti_hlt(void) {
+    asm volatile("sti; hlt" : : : "memory");
+}
+
+// Reads the CPU's time stamp counter.
+static inline uint64_t rdtsc(void) {
+    uint32_t low, high;
+    asm volatile("rdtsc" : "=a"(low), "=d"(high));
+    return ((uint64_t)high << 32) | low;
+}
+
+#ifdef HOST_BUILD
+// tools/hostbench runs kernel code as a single-threaded Linux process,
+// where CLI faults and there is nothing to mask.
+static inline uint32_t irq_save(void) {
+    return 0;
+}
+
+static inline void irq_restore(uint32_t flags) {
+    (void)flags;
+}
+#else
+// Disables interrupts and returns the previous EFLAGS so the caller can
+// restore them with irq_restore(). Nests safely.
+static inline uint32_t irq_save(void) {
+    uint32_t flags;
+    asm volatile("pushf; pop %0; cli" : "=r"(flags) : : "memory");
+    return flags;
+}
+
+static inline void irq_restore(uint32_t flags) {
+    asm volatile("push %0; popf" : : "r"(flags) : "memory", "cc");
+}
+#endif
+
+static inline bool irqs_enabled(void) {
+    uint32_t flags;
+    asm volatile("pushf; pop %0" : "=r"(flags));
+    return (flags & EFLAGS_IF) != 0;
+}
+
+#endif // CPU_H
@@ -0,0 +1,152 @@
+#include "cpu_features.h"
+#include "cpu.h"
+#include <stddef.h>
+
+// Where each feature lives: CPUID leaf, register and bit
+typedef enum { REG_EBX, REG_ECX, REG_EDX } cpuid_reg_t;
+
+typedef struct {
+    const char* name;
+    uint32_t leaf;
+    cpuid_reg_t reg;
+    uint32_t bit;
+} cpu_feature_desc_t;
+
+static const cpu_feature_desc_t feature_descs[CPU_FEATURE_COUNT] = {
+    [CPU_FEATURE_FPU]           = { "fpu",     1,          REG_EDX, 0 },
+    [CPU_FEATURE_TSC]           = { "tsc",     1,          REG_EDX, 4 },
+    [CPU_FEATURE_INVARIANT_TSC] = { "invtsc",  0x80000007, REG_EDX, 8 },
+    [CPU_FEATURE_PSE]           = { "pse",     1,          REG_EDX, 3 },
+    [CPU_FEATURE_PGE]           = { "pge",     1,          REG_EDX, 13 },
+    [CPU_FEATURE_SEP]           = { "sep",     1,          REG_EDX, 11 },
+    [CPU_FEATURE_FXSR]          = { "fxsr",    1,          REG_EDX, 24 },
+    [CPU_FEATURE_SSE]           = { "sse",     1,          REG_EDX, 25 },
+    [CPU_FEATURE_SSE2]          = { "sse2",    1,          REG_EDX, 26 },
+    [CPU_FEATURE_SSE3]          = { "sse3",    1,          REG_ECX, 0 },
+    [CPU_FEATURE_SSSE3]         = { "ssse3",   1,          REG_ECX, 9 },
+    [CPU_FEATURE_SSE41]         = { "sse4.1",  1,          REG_ECX, 19 },
+    [CPU_FEATURE_SSE42]         = { "sse4.2",  1,          REG_ECX, 20 },
+    [CPU_FEATURE_POPCNT]        = { "popcnt",  1,          REG_ECX, 23 },
+    [CPU_FEATURE_PCLMUL]        = { "pclmul",  1,          REG_ECX, 1 },
+    [CPU_FEATURE_MONITOR]       = { "monitor", 1,          REG_ECX, 3 },
+    [CPU_FEATURE_XSAVE]         = { "xsave",   1,          REG_ECX, 26 },
+    [CPU_FEATURE_AVX]           = { "avx",     1,          REG_ECX, 28 },
+    [CPU_FEATURE_AVX2]          = { "avx2",    7,          REG_EBX, 5 },
+    [CPU_FEATURE_ERMSB]         = { "erms",    7,          REG_EBX, 9 },
+    [CPU_FEATURE_FSRM]          = { "fsrm",    7,          REG_EDX, 4 },
+};
+
+static cpu_info_t info;
+static cpu_dispatch_t* dispatch_list = NULL;
+
+// --- Internal Helper Functions ---
+
+// Reads a leaf, or zeroes if the CPU doesn't have it.
+static void cpu_read_leaf(uint32_t leaf, uint32_t max_basic, uint32_t max_extended, uint32_t regs[3]) {
+    uint32_t eax, ebx = 0, ecx = 0, edx = 0;
+    bool present = (leaf >= 0x80000000) ? leaf <= max_extended : leaf <= max_basic;
+    if (present) {
+        cpuid_count(leaf, 0, &eax, &ebx, &ecx, &edx);
+    }
+    regs[REG_EBX] = ebx;
+    regs[REG_ECX] = ecx;
+    regs[REG_EDX] = edx;
+}
+
+static void cpu_read_brand(uint32_t max_extended) {
+    if (max_extended < 0x80000004) {
+        return;
+    }
+    uint32_t* words = (uint32_t*)info.brand;
+    for (uint32_t i = 0; i < 3; i++) {
+        cpuid(0x80000002 + i, &words[i * 4], &words[i * 4 + 1], &words[i * 4 + 2], &words[i * 4 + 3]);
+    }
+    info.brand[48] = '\0';
+
+    // Intel pads the string with leading spaces
+    uint32_t skip = 0;
+    while (info.brand[skip] == ' ') {
+        skip++;
+    }
+    for (uint32_t i = 0; skip > 0 && i + skip <= 48; i++) {
+        info.brand[i] = info.brand[i + skip];
+    }
+}
+
+// --- Public API Functions ---
+
+void cpu_features_init(void) {
+    uint32_t max_basic, max_extended, eax, ebx, ecx, edx;
+    cpuid(0, &max_basic, &ebx, &ecx, &edx);
+    uint32_t* vendor = (uint32_t*)info.vendor;
+    vendor[0] = ebx;
+    vendor[1] = edx;
+    vendor[2] = ecx;
+    info.vendor[12] = '\0';
+    cpuid(0x80000000, &max_extended, &ebx, &ecx, &edx);
+    if (max_extended < 0x80000000) {
+        max_extended = 0; // No extended leaves at all
+    }
+
+    cpuid(1, &eax, &ebx, &ecx, &edx);
+    info.stepping = eax & 0xF;
+    info.model = (eax >> 4) & 0xF;
+    info.family = (eax >> 8) & 0xF;
+    if (info.family == 0xF) {
+        info.family += (eax >> 20) & 0xFF;
+    }
+    if (info.family == 0x6 || info.family >= 0xF) {
+        info.model |= ((eax >> 16) & 0xF) << 4;
+    }
+
+    // Each leaf this table uses, read once
+    static const uint32_t leaves[] = { 1, 7, 0x80000007 };
+    uint32_t regs[3][3];
+    for (uint32_t i = 0; i < 3; i++) {
+        cpu_read_leaf(leaves[i], max_basic, max_extended, regs[i]);
+    }
+    for (uint32_t f = 0; f < CPU_FEATURE_COUNT; f++) {
+        const cpu_feature_desc_t* desc = &feature_descs[f];
+        for (uint32_t i = 0; i < 3; i++) {
+            if (leaves[i] == desc->leaf && (regs[i][desc->reg] & (1u << desc->bit))) {
+                info.features |= CPU_FEATURE_BIT(f);
+            }
+        }
+    }
+
+    cpu_read_brand(max_extended);
+}
+
+bool cpu_has(cpu_feature_t feature) {
+    return (info.features & CPU_FEATURE_BIT(feature)) != 0;
+}
+
+void cpu_feature_clear(cpu_feature_t feature) {
+    info.features &= ~CPU_FEATURE_BIT(feature);
+}
+
+const cpu_info_t* cpu_get_info(void) {
+    return &info;
+}
+
+const char* cpu_feature_name(cpu_feature_t feature) {
+    return (feature < CPU_FEATURE_COUNT) ? feature_descs[feature].name : "?";
+}
+
+void cpu_dispatch_select(cpu_dispatch_t* dispatch) {
+    for (uint32_t i = 0; i < dispatch->impl_count; i++) {
+        const cpu_impl_t* impl = &dispatch->impls[i];
+        if ((info.features & impl->requires) == impl->requires) {
+            *dispatch->slot = impl->fn;
+            dispatch->chosen = impl;
+            break;
+        }
+    }
+
+    dispatch->next = dispatch_list;
+    dispatch_list = dispatch;
+}
+
+const cpu_dispatch_t* cpu_dispatch_list(void) {
+    return dispatch_list;
+}
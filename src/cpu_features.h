@@ -0,0 +1,92 @@
+#ifndef CPU_FEATURES_H
+#define CPU_FEATURES_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+// --- CPU Identification and Function Multiversioning ---
+// CPUID is read once, on the boot CPU, and everything else asks
+// cpu_has(). The APs are assumed to match the BSP. A feature counts once
+// the kernel can use it: fpu_init() withdraws the SIMD features it could
+// not enable.
+//
+// Hot routines with several implementations (string ops, directory and
+// bitmap scans) call through a function pointer. A cpu_dispatch_t lists
+// the implementations, best first, and cpu_dispatch_select() points the
+// slot at the first one this CPU supports. Until then the slot holds the
+// portable one, so callers work from the first instruction of boot.
+
+typedef enum {
+    CPU_FEATURE_FPU,
+    CPU_FEATURE_TSC,
+    CPU_FEATURE_INVARIANT_TSC, // Constant rate in every P/C-state
+    CPU_FEATURE_PSE,
+    CPU_FEATURE_PGE,
+    CPU_FEATURE_SEP,           // SYSENTER/SYSEXIT (see syscall_init_cpu())
+    CPU_FEATURE_FXSR,
+    CPU_FEATURE_SSE,
+    CPU_FEATURE_SSE2,
+    CPU_FEATURE_SSE3,
+    CPU_FEATURE_SSSE3,
+    CPU_FEATURE_SSE41,
+    CPU_FEATURE_SSE42,
+    CPU_FEATURE_POPCNT,
+    CPU_FEATURE_PCLMUL,
+    CPU_FEATURE_MONITOR,       // MONITOR/MWAIT
+    CPU_FEATURE_XSAVE,
+    CPU_FEATURE_AVX,
+    CPU_FEATURE_AVX2,
+    CPU_FEATURE_ERMSB,         // Fast rep movsb/stosb for large sizes
+    CPU_FEATURE_FSRM,          // Fast rep movsb for short copies too
+    CPU_FEATURE_COUNT
+} cpu_feature_t;
+
+#define CPU_FEATURE_BIT(feature) (1u << (feature))
+
+typedef struct {
+    char vendor[13];
+    char brand[49];            // Empty if the CPU has no brand string
+    uint32_t family;           // Display family and model, with the
+    uint32_t model;            // extended fields folded in
+    uint32_t stepping;
+    uint32_t features;         // CPU_FEATURE_BIT()s
+} cpu_info_t;
+
+// One implementation of a routine, and the features it needs.
+typedef struct {
+    const char* name;
+    uint32_t requires;         // CPU_FEATURE_BIT()s
+    void* fn;
+} cpu_impl_t;
+
+typedef struct cpu_dispatch {
+    const char* name;
+    void** slot;               // The function pointer callers go through
+    const cpu_impl_t* impls;   // Best first; the last should need nothing
+    uint32_t impl_count;
+    const cpu_impl_t* chosen;  // Set by cpu_dispatch_select()
+    struct cpu_dispatch* next;
+} cpu_dispatch_t;
+
+// Reads CPUID. Call first thing in kmain.
+void cpu_features_init(void);
+
+bool cpu_has(cpu_feature_t feature);
+
+// Withdraws a feature the kernel turned out not to be able to use.
+void cpu_feature_clear(cpu_feature_t feature);
+
+const cpu_info_t* cpu_get_info(void);
+
+// Short name of a feature, as shown by 'cpuinfo'.
+const char* cpu_feature_name(cpu_feature_t feature);
+
+// Points '*dispatch->slot' at the best implementation this CPU supports
+// and records the choice for cpu_dispatch_list(). Call once per routine,
+// after fpu_init(). If no implementation fits, the slot is left alone.
+void cpu_dispatch_select(cpu_dispatch_t* dispatch);
+
+// Every routine selected so far, most recent first.
+const cpu_dispatch_t* cpu_dispatch_list(void);
+
+#endif // CPU_FEATURES_H
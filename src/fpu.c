@@ -0,0 +1,211 @@
+#include "fpu.h"
+#include "cpu.h"
+#include "smp.h"
+#include "cpu_features.h"
+#include "../memory/heap.h"
+#include "../lib/string.h"
+#include <stddef.h>
+
+#define FPU_ALIGN      64   // XSAVE needs 64-byte alignment, FXSAVE 16
+#define FPU_STATE_MAX  1024 // x87 + SSE + AVX take 832 bytes
+#define FNSAVE_SIZE    108
+#define FXSAVE_SIZE    512
+#define MXCSR_DEFAULT  0x1F80 // All SIMD exceptions masked, round to nearest
+
+// XCR0 state components
+#define XSTATE_X87 (1 << 0)
+#define XSTATE_SSE (1 << 1)
+#define XSTATE_AVX (1 << 2)
+
+typedef enum {
+    FPU_SAVE_FNSAVE,         // x87 only
+    FPU_SAVE_FXSAVE,         // x87 and SSE
+    FPU_SAVE_XSAVE           // Every component enabled in XCR0
+} fpu_save_method_t;
+
+static fpu_save_method_t save_method = FPU_SAVE_FNSAVE;
+static uint32_t xstate_mask;  // XCR0, and what XSAVE/XRSTOR transfer
+static uint32_t state_size = FNSAVE_SIZE;
+static bool has_sse;
+
+// Clean registers after FNINIT, copied into every new thread's save area
+static uint8_t init_state[FPU_STATE_MAX] __attribute__((aligned(FPU_ALIGN)));
+
+// --- Internal Helper Functions ---
+
+static void fpu_save(void* area) {
+    if (save_method == FPU_SAVE_XSAVE) {
+        asm volatile("xsave (%0)" : : "r"(area), "a"(xstate_mask), "d"(0) : "memory");
+    } else if (save_method == FPU_SAVE_FXSAVE) {
+        asm volatile("fxsave (%0)" : : "r"(area) : "memory");
+    } else {
+        asm volatile("fnsave (%0)" : : "r"(area) : "memory");
+    }
+}
+
+static void fpu_restore(const void* area) {
+    if (save_method == FPU_SAVE_XSAVE) {
+        asm volatile("xrstor (%0)" : : "r"(area), "a"(xstate_mask), "d"(0) : "memory");
+    } else if (save_method == FPU_SAVE_FXSAVE) {
+        asm volatile("fxrstor (%0)" : : "r"(area) : "memory");
+    } else {
+        asm volatile("frstor (%0)" : : "r"(area) : "memory");
+    }
+}
+
+// Puts the registers in their power-on state.
+static void fpu_reset(void) {
+    asm volatile("fninit");
+    if (has_sse) {
+        uint32_t mxcsr = MXCSR_DEFAULT;
+        asm volatile("ldmxcsr %0" : : "m"(mxcsr));
+    }
+}
+
+// Saves the registers of whichever thread has them loaded on this CPU, and
+// leaves them unowned. Interrupts must be disabled.
+static void fpu_evict(cpu_t* cpu) {
+    if (cpu->fpu_owner != NULL) {
+        fpu_save(cpu->fpu_owner->fpu_state);
+        cpu->fpu_owner = NULL;
+    }
+}
+
+// --- Public API Functions ---
+
+void fpu_init(void) {
+    uint32_t eax, ebx, ecx, edx;
+    has_sse = cpu_has(CPU_FEATURE_SSE) && cpu_has(CPU_FEATURE_FXSR);
+
+    if (cpu_has(CPU_FEATURE_XSAVE) && has_sse) {
+        save_method = FPU_SAVE_XSAVE;
+        xstate_mask = XSTATE_X87 | XSTATE_SSE;
+        if (cpu_has(CPU_FEATURE_AVX)) {
+            xstate_mask |= XSTATE_AVX;
+        }
+    } else if (cpu_has(CPU_FEATURE_FXSR)) {
+        save_method = FPU_SAVE_FXSAVE;
+        state_size = FXSAVE_SIZE;
+    }
+    fpu_init_cpu();
+
+    if (save_method == FPU_SAVE_XSAVE) {
+        // Leaf 0xD reports the area size for what XCR0 now enables
+        cpuid_count(0xD, 0, &eax, &ebx, &ecx, &edx);
+        if (ebx > FPU_STATE_MAX) {
+            // Some unexpected component: stay with x87 and SSE
+            xstate_mask = XSTATE_X87 | XSTATE_SSE;
+            xsetbv(0, xstate_mask);
+            cpuid_count(0xD, 0, &eax, &ebx, &ecx, &edx);
+        }
+        state_size = ebx;
+    }
+
+    // Tell cpu_has() what's usable: SIMD registers the kernel doesn't
+    // save per thread must not be touched
+    if (!has_sse) {
+        cpu_feature_clear(CPU_FEATURE_SSE);
+        cpu_feature_clear(CPU_FEATURE_SSE2);
+    }
+    if (!(xstate_mask & XSTATE_AVX)) {
+        cpu_feature_clear(CPU_FEATURE_AVX);
+        cpu_feature_clear(CPU_FEATURE_AVX2);
+    }
+    fpu_save(init_state);
+}
+
+void fpu_init_cpu(void) {
+    uint32_t cr0 = read_cr0();
+    cr0 &= ~(CR0_EM | CR0_TS);
+    cr0 |= CR0_MP | CR0_NE;
+    write_cr0(cr0);
+
+    if (save_method != FPU_SAVE_FNSAVE) {
+        uint32_t cr4 = read_cr4() | CR4_OSFXSR;
+        if (has_sse) {
+            cr4 |= CR4_OSXMMEXCPT;
+        }
+        if (save_method == FPU_SAVE_XSAVE) {
+            cr4 |= CR4_OSXSAVE;
+        }
+        write_cr4(cr4);
+        if (save_method == FPU_SAVE_XSAVE) {
+            xsetbv(0, xstate_mask);
+        }
+    }
+    fpu_reset();
+    this_cpu()->fpu_owner = NULL;
+}
+
+void* fpu_state_alloc(void) {
+    // The heap only aligns to its header, so over-allocate and keep the
+    // block's address just below the aligned area for fpu_state_free()
+    uint8_t* block = malloc(state_size + FPU_ALIGN + sizeof(void*));
+    if (block == NULL) {
+        return NULL;
+    }
+    uint32_t aligned = ((uint32_t)block + sizeof(void*) + FPU_ALIGN - 1) & ~(FPU_ALIGN - 1);
+    void** state = (void**)aligned;
+    state[-1] = block;
+    memcpy(state, init_state, state_size);
+    return state;
+}
+
+void fpu_state_free(void* state) {
+    if (state != NULL) {
+        free(((void**)state)[-1]);
+    }
+}
+
+void fpu_switch(thread_t* next) {
+    uint32_t cr0 = read_cr0();
+    if (this_cpu()->fpu_owner == next) {
+        if (cr0 & CR0_TS) {
+            clts(); // Its registers are still loaded
+        }
+    } else if (!(cr0 & CR0_TS)) {
+        write_cr0(cr0 | CR0_TS);
+    }
+}
+
+void fpu_release(thread_t* thread) {
+    cpu_t* cpu = this_cpu();
+    if (cpu->fpu_owner == thread) {
+        cpu->fpu_owner = NULL;
+    }
+}
+
+bool fpu_handle_trap(void) {
+    if (!(read_cr0() & CR0_TS)) {
+        return false; // EM is never set, so a real fault
+    }
+    clts();
+
+    cpu_t* cpu = this_cpu();
+    thread_t* self = cpu->sched.current;
+    fpu_evict(cpu);
+    if (self->fpu_state != NULL) {
+        fpu_restore(self->fpu_state);
+        cpu->fpu_owner = self;
+    }
+    // Idle threads have no save area; they may use the registers, which
+    // belong to nobody now, but nothing is kept for them
+    return true;
+}
+
+uint32_t kernel_fpu_begin(void) {
+    uint32_t flags = irq_save();
+    clts();
+    fpu_evict(this_cpu());
+    fpu_reset(); // Don't run with a user program's MXCSR
+    return flags;
+}
+
+void kernel_fpu_end(uint32_t flags) {
+    if (xstate_mask & XSTATE_AVX) {
+        asm volatile("vzeroupper"); // Avoid SSE/AVX transition stalls in whoever runs next
+    }
+    // Whoever uses the registers next traps and loads their own state
+    write_cr0(read_cr0() | CR0_TS);
+    irq_restore(flags);
+}
@@ -0,0 +1,50 @@
+#ifndef FPU_H
+#define FPU_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+// --- FPU, SSE and AVX State ---
+// Boot enables x87 and SSE, and AVX where XSAVE lets the kernel manage its
+// registers. Threads get their own copy of that state, switched lazily:
+// the scheduler only sets CR0.TS when another thread runs, and the first
+// FPU/SIMD instruction afterwards traps with #NM. The trap saves the
+// previous owner's registers and loads the new thread's. Threads that
+// never touch the FPU never pay for it.
+//
+// Threads don't migrate, so each CPU tracks its own owner and a thread's
+// registers are only ever live on the CPU it belongs to.
+
+struct thread;
+
+// Enables the FPU on the boot CPU and records the state every new thread
+// starts from. Call once, before any thread is created. Afterwards
+// cpu_has() only reports the SIMD extensions that were enabled.
+void fpu_init(void);
+
+// Same for an AP, using what fpu_init() worked out.
+void fpu_init_cpu(void);
+
+// Allocates a thread's save area, set to the initial state. Returns NULL
+// if out of memory. Free it with fpu_state_free().
+void* fpu_state_alloc(void);
+void fpu_state_free(void* state);
+
+// Scheduler hook, called with interrupts off before switching to 'next':
+// leaves the registers usable only if they already hold next's state.
+void fpu_switch(struct thread* next);
+
+// Forgets a dying thread's registers, so nobody saves them later.
+void fpu_release(struct thread* thread);
+
+// #NM handler. Returns false if the trap wasn't caused by CR0.TS.
+bool fpu_handle_trap(void);
+
+// Brackets kernel code that uses SSE/AVX registers. Whatever thread owns
+// them has its state saved first, and interrupts stay off until the
+// matching kernel_fpu_end(), so keep the section short. Pass the value
+// kernel_fpu_begin() returned to kernel_fpu_end(). Don't nest.
+uint32_t kernel_fpu_begin(void);
+void kernel_fpu_end(uint32_t flags);
+
+#endif // FPU_H
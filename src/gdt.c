@@ -0,0 +1,115 @@
+#include "gdt.h"
+#include "smp.h"
+
+#define SYSENTER_STACK_WORDS 64
+
+struct gdt_entry {
+    uint16_t limit_low;
+    uint16_t base_low;
+    uint8_t  base_mid;
+    uint8_t  access;
+    uint8_t  granularity; // High nibble: flags, low nibble: limit bits 16-19
+    uint8_t  base_high;
+} __attribute__((packed));
+
+struct gdt_ptr {
+    uint16_t limit;
+    uint32_t base;
+} __attribute__((packed));
+
+// 32-bit Task State Segment. We never switch tasks with it; the CPU only
+// reads ss0:esp0 from it when an interrupt moves it from ring 3 to ring 0.
+struct tss_entry {
+    uint32_t prev_tss;
+    uint32_t esp0;
+    uint32_t ss0;
+    uint32_t esp1, ss1, esp2, ss2;
+    uint32_t cr3, eip, eflags;
+    uint32_t eax, ecx, edx, ebx, esp, ebp, esi, edi;
+    uint32_t es, cs, ss, ds, fs, gs;
+    uint32_t ldt;
+    uint16_t trap;
+    uint16_t iomap_base;
+} __attribute__((packed));
+
+// Everything one CPU needs to enter the kernel from ring 3
+struct cpu_tss {
+    struct tss_entry tss;
+    uint32_t sysenter_stack[SYSENTER_STACK_WORDS]; // Absorbs an NMI before the switch
+    uint32_t sysenter_esp0;  // MSR_SYSENTER_ESP points here; mirrors tss.esp0
+};
+
+#define GDT_ENTRIES (GDT_CPU_FIRST + 2 * MAX_CPUS)
+
+static struct gdt_entry gdt_entries[GDT_ENTRIES];
+static struct gdt_ptr gdt_pointer;
+static struct cpu_tss cpu_tss[MAX_CPUS];
+
+// --- Internal Helper Functions ---
+
+static void gdt_set_entry(int index, uint32_t base, uint32_t limit, uint8_t access, uint8_t flags) {
+    gdt_entries[index].limit_low = limit & 0xFFFF;
+    gdt_entries[index].base_low = base & 0xFFFF;
+    gdt_entries[index].base_mid = (base >> 16) & 0xFF;
+    gdt_entries[index].access = access;
+    gdt_entries[index].granularity = (flags & 0xF0) | ((limit >> 16) & 0x0F);
+    gdt_entries[index].base_high = (base >> 24) & 0xFF;
+}
+
+// --- Public API Functions ---
+
+void gdt_init(void) {
+    gdt_set_entry(0, 0, 0, 0, 0);                  // Null descriptor
+    gdt_set_entry(1, 0, 0xFFFFF, 0x9A, 0xC0);      // Kernel code: ring 0, 4 KiB granular, 32-bit
+    gdt_set_entry(2, 0, 0xFFFFF, 0x92, 0xC0);      // Kernel data
+    gdt_set_entry(3, 0, 0xFFFFF, 0xFA, 0xC0);      // User code: ring 3
+    gdt_set_entry(4, 0, 0xFFFFF, 0xF2, 0xC0);      // User data
+
+    for (int i = 0; i < MAX_CPUS; i++) {
+        // No I/O permission bitmap: the base points past the limit, so
+        // every port access from ring 3 faults
+        struct tss_entry* tss = &cpu_tss[i].tss;
+        tss->ss0 = GDT_KERNEL_DATA;
+        tss->iomap_base = sizeof(struct tss_entry);
+        gdt_set_entry(GDT_TSS_SELECTOR(i) / 8, (uint32_t)tss, sizeof(struct tss_entry) - 1, 0x89, 0x00);
+
+        // Per-CPU data segment, byte granular and just big enough for a cpu_t
+        gdt_set_entry(GDT_PERCPU_SELECTOR(i) / 8, (uint32_t)&cpus[i], sizeof(cpu_t) - 1, 0x92, 0x40);
+    }
+
+    gdt_pointer.limit = sizeof(gdt_entries) - 1;
+    gdt_pointer.base = (uint32_t)&gdt_entries;
+
+    gdt_load_cpu(0);
+}
+
+void gdt_load_cpu(uint32_t cpu_index) {
+    uint16_t percpu = GDT_PERCPU_SELECTOR(cpu_index);
+    cpus[cpu_index].self = &cpus[cpu_index]; // What %gs:0 reads
+
+    asm volatile(
+        "lgdt (%0)\n"
+        "ljmp %1, $1f\n"      // Reload CS from the new table
+        "1:\n"
+        "mov %2, %%ax\n"
+        "mov %%ax, %%ds\n"
+        "mov %%ax, %%es\n"
+        "mov %%ax, %%fs\n"
+        "mov %%ax, %%ss\n"
+        "mov %3, %%gs\n"
+        "ltr %4\n"
+        :
+        : "r"(&gdt_pointer), "i"(GDT_KERNEL_CODE), "i"(GDT_KERNEL_DATA), "r"(percpu),
+          "r"((uint16_t)GDT_TSS_SELECTOR(cpu_index))
+        : "eax", "memory");
+}
+
+void gdt_set_kernel_stack(uint32_t esp0) {
+    struct cpu_tss* ct = &cpu_tss[this_cpu()->index];
+    ct->tss.esp0 = esp0;
+    ct->sysenter_esp0 = esp0;
+}
+
+uint32_t gdt_sysenter_stack(void) {
+    return (uint32_t)&cpu_tss[this_cpu()->index].sysenter_esp0;
+}
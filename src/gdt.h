@@ -0,0 +1,44 @@
+#ifndef GDT_H
+#define GDT_H
+
+#include <stdint.h>
+
+// --- Global Descriptor Table ---
+// Flat 4 GiB kernel code/data segments at the selectors the rest of the
+// kernel (and the bootloader before us) uses, followed by flat ring-3
+// code/data segments for user programs. SYSENTER/SYSEXIT derive all four
+// from GDT_KERNEL_CODE, so their order is fixed.
+//
+// After those, every CPU has a pair of entries: its TSS, which gives the
+// kernel stack to switch to when an interrupt arrives in ring 3, and a
+// small data segment whose base points at its cpu_t. Loading the latter
+// into GS makes per-CPU data reachable with a single %gs-relative load.
+// Keeping the pair adjacent lets the entry stubs find the GS selector from
+// the task register alone.
+
+#define GDT_KERNEL_CODE  0x08
+#define GDT_KERNEL_DATA  0x10
+#define GDT_USER_CODE    0x1B // Index 3, RPL 3
+#define GDT_USER_DATA    0x23 // Index 4, RPL 3
+#define GDT_CPU_FIRST    5    // Index of CPU 0's TSS; its GS segment follows
+
+#define GDT_TSS_SELECTOR(cpu)    ((GDT_CPU_FIRST + 2 * (cpu)) * 8)
+#define GDT_PERCPU_SELECTOR(cpu) (GDT_TSS_SELECTOR(cpu) + 8)
+
+// Builds the GDT and loads it on the boot CPU, with GS set for CPU 0.
+void gdt_init(void);
+
+// Loads the (already built) GDT and the CPU's TSS on an AP, and points GS
+// at its cpu_t.
+void gdt_load_cpu(uint32_t cpu_index);
+
+// Sets the kernel stack the calling CPU switches to on entry from ring 3,
+// through an interrupt or SYSENTER. The scheduler calls it on every switch.
+void gdt_set_kernel_stack(uint32_t esp0);
+
+// Value for the calling CPU's MSR_SYSENTER_ESP. SYSENTER lands on a small
+// per-CPU stack whose top word holds the current kernel stack, so the
+// entry stub's first instruction can switch to it.
+uint32_t gdt_sysenter_stack(void);
+
+#endif // GDT_H
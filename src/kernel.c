@@ -4,15 +4,77 @@
 #include "../drivers/pic.h"
 #include "../drivers/keyboard.h"
 #include "../drivers/ide.h"
+#include "../drivers/timer.h"
+#include "../drivers/lapic.h"
+#include "../drivers/ioapic.h"
+#include "../drivers/serial.h"
+#include "sched.h"
+#include "gdt.h"
+#include "acpi.h"
+#include "smp.h"
+#include "taskpool.h"
+#include "syscall.h"
+#include "fpu.h"
+#include "trace.h"
+#include "cpu_features.h"
 #include "../fs/fat32.h"
+#include "../fs/dirscan.h"
+#include "../fs/pagecache.h"
 #include "../shell/shell.h"
 #include "../memory/pmm.h"
 #include "../memory/heap.h"
+#include "../memory/paging.h"
+#include "../memory/mmap.h"
+#include "../lib/string.h"
 #include <stdint.h>
 
+static void shell_thread(void* arg) {
+    (void)arg; // Unused
+    shell_main_loop();
+}
+
+// True if 'option' is one of the space-separated words of the kernel
+// command line.
+static bool cmdline_has(multiboot_info_t* mbi, const char* option) {
+    if (!(mbi->flags & MULTIBOOT_INFO_CMDLINE)) {
+        return false;
+    }
+    size_t option_len = strlen(option);
+    const char* p = (const char*)mbi->cmdline;
+    while (*p != '\0') {
+        while (*p == ' ') {
+            p++;
+        }
+        const char* word = p;
+        while (*p != '\0' && *p != ' ') {
+            p++;
+        }
+        if ((size_t)(p - word) == option_len && strncmp(word, option, option_len) == 0) {
+            return true;
+        }
+    }
+    return false;
+}
+
+// Reads console=vga|serial|both from the kernel command line.
+static console_mode_t cmdline_console_mode(multiboot_info_t* mbi) {
+    if (cmdline_has(mbi, "console=serial")) {
+        return CONSOLE_SERIAL;
+    }
+    if (cmdline_has(mbi, "console=both")) {
+        return CONSOLE_BOTH;
+    }
+    return CONSOLE_VGA;
+}
+
 // The kernel's main entry point
 void kmain(multiboot_info_t* mbi) {
     terminal_initialize();
+    if (serial_init()) {
+        terminal_set_console(cmdline_console_mode(mbi));
+        terminal_initialize(); // Clears the serial terminal, if it is one
+    }
+    cpu_features_init();
 
     // This check is now commented out to bypass the QEMU bug.
     // if (magic != MULTIBOOT_BOOTLOADER_MAGIC) {
@@ -26,20 +88,55 @@ void kmain(multiboot_info_t* mbi) {
     }
 
     // --- CORRECT INITIALIZATION ORDER ---
+    gdt_init(); // Per-CPU data (this_cpu) works from here on
     idt_init();
     pic_remap();
+    timer_init();
+    if (cmdline_has(mbi, "trace")) {
+        trace_set_enabled(true); // Record the boot too (needs this_cpu and the clock)
+    }
     pmm_init(mbi); // Pass the multiboot info to the PMM
     heap_init();
+    fpu_init();
+    pmm_dispatch_init();
+    string_init();
+    dirscan_init();
+    syscall_init_cpu();
+    paging_init();
+    if (acpi_init() && lapic_init(acpi_get_madt()->lapic_address) && ioapic_init()) {
+        // The I/O APIC replaces the 8259; unmask what we have drivers for
+        ioapic_route_irq(0, lapic_get_id()); // PIT
+        ioapic_route_irq(1, lapic_get_id()); // Keyboard
+        ioapic_route_irq(SERIAL_COM1_IRQ, lapic_get_id());
+        ioapic_route_irq(14, lapic_get_id()); // Primary IDE
+    } else {
+        pic_unmask_irq(SERIAL_COM1_IRQ);
+        pic_unmask_irq(14);
+    }
+    serial_enable_irq();
+    ide_init();
     fat32_init();
+    pagecache_init();
+    mmap_init();
     keyboard_init();
+    sched_init(); // From here on kmain is the BSP's idle thread
+    if (lapic_is_enabled()) {
+        lapic_timer_start();
+    }
+    smp_init();
+    if (smp_cpu_count() > 1) {
+        terminal_printf("SMP: %d CPUs online.\n", FG_GREEN, smp_cpu_count());
+    }
+    taskpool_init();
 
     asm volatile ("sti");
 
     shell_init();
-
-    while(1) {
-        asm volatile("hlt");
+    if (thread_create("shell", shell_thread, NULL, SCHED_PRIO_NORMAL) == NULL) {
+        terminal_writeerror("Failed to start the shell thread.\n");
     }
+
+    cpu_idle();
 }
 // Fix the issue with cp command not being able to copy non-empty files
 // IMPLEMENT TEXT EDITOR
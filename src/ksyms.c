@@ -0,0 +1,32 @@
+#include "ksyms.h"
+#include <stddef.h>
+
+extern uint32_t kernel_text_end; // From the linker script
+
+int ksym_find(uint32_t addr) {
+    if (ksym_count == 0 || addr < ksym_table[0].addr || addr >= (uint32_t)&kernel_text_end) {
+        return -1;
+    }
+    // Last symbol at or below 'addr'
+    uint32_t low = 0, high = ksym_count - 1;
+    while (low < high) {
+        uint32_t mid = (low + high + 1) / 2;
+        if (ksym_table[mid].addr <= addr) {
+            low = mid;
+        } else {
+            high = mid - 1;
+        }
+    }
+    return (int)low;
+}
+
+const char* ksym_lookup(uint32_t addr, uint32_t* offset) {
+    int index = ksym_find(addr);
+    if (index < 0) {
+        return NULL;
+    }
+    if (offset != NULL) {
+        *offset = addr - ksym_table[index].addr;
+    }
+    return ksym_table[index].name;
+}
@@ -0,0 +1,28 @@
+#ifndef KSYMS_H
+#define KSYMS_H
+
+#include <stdint.h>
+
+// --- Kernel Symbols ---
+// The Makefile links the kernel once, lists its text symbols with nm and
+// links again with them compiled in (the generated ksym_table.c). The
+// table only adds read-only data after .text, so no function moves.
+
+typedef struct {
+    uint32_t addr;
+    const char* name;
+} ksym_t;
+
+// Sorted by address; generated at build time
+extern const ksym_t ksym_table[];
+extern const uint32_t ksym_count;
+
+// The function containing 'addr', or -1 if it is outside the kernel's
+// text. Indexes ksym_table.
+int ksym_find(uint32_t addr);
+
+// Name of the function containing 'addr', or NULL. '*offset' (if not
+// NULL) gets the distance from its start.
+const char* ksym_lookup(uint32_t addr, uint32_t* offset);
+
+#endif // KSYMS_H
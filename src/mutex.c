@@ -0,0 +1,68 @@
+#include "mutex.h"
+#include <stddef.h>
+
+// --- Public API Functions ---
+
+void mutex_lock(mutex_t* mutex) {
+    thread_t* self = thread_current();
+
+    uint32_t flags = spin_lock_irqsave(&mutex->lock);
+    if (mutex->owner == NULL || mutex->owner == self) {
+        mutex->owner = self;
+        mutex->depth++;
+        spin_unlock_irqrestore(&mutex->lock, flags);
+        return;
+    }
+
+    self->wait_next = NULL;
+    if (mutex->waiters_tail != NULL) {
+        mutex->waiters_tail->wait_next = self;
+    } else {
+        mutex->waiters_head = self;
+    }
+    mutex->waiters_tail = self;
+    spin_unlock_irqrestore(&mutex->lock, flags);
+
+    // mutex_unlock() makes us the owner before waking us
+    while (mutex->owner != self) {
+        thread_block();
+    }
+}
+
+bool mutex_trylock(mutex_t* mutex) {
+    thread_t* self = thread_current();
+    bool taken = false;
+
+    uint32_t flags = spin_lock_irqsave(&mutex->lock);
+    if (mutex->owner == NULL || mutex->owner == self) {
+        mutex->owner = self;
+        mutex->depth++;
+        taken = true;
+    }
+    spin_unlock_irqrestore(&mutex->lock, flags);
+    return taken;
+}
+
+void mutex_unlock(mutex_t* mutex) {
+    thread_t* next = NULL;
+
+    uint32_t flags = spin_lock_irqsave(&mutex->lock);
+    if (--mutex->depth == 0) {
+        // Hand the lock straight to the first waiter, so a thread that
+        // keeps re-locking can't starve it
+        next = mutex->waiters_head;
+        if (next != NULL) {
+            mutex->waiters_head = next->wait_next;
+            if (mutex->waiters_head == NULL) {
+                mutex->waiters_tail = NULL;
+            }
+            mutex->depth = 1;
+        }
+        mutex->owner = next;
+    }
+    spin_unlock_irqrestore(&mutex->lock, flags);
+
+    if (next != NULL) {
+        thread_unblock(next);
+    }
+}
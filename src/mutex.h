@@ -0,0 +1,31 @@
+#ifndef MUTEX_H
+#define MUTEX_H
+
+#include <stdbool.h>
+#include "sched.h"
+
+// --- Sleeping Mutex ---
+// For long critical sections such as disk I/O, where spinning would waste a
+// CPU. Contended lockers block and are handed the lock in FIFO order. The
+// owner may lock it again (it is recursive), so code reached both from a
+// syscall and from a page fault inside that syscall can take it freely.
+// Only usable from thread context, never from an IRQ handler.
+
+typedef struct {
+    spinlock_t lock;
+    thread_t* volatile owner;
+    uint32_t depth;          // How many times the owner holds it
+    thread_t* waiters_head;  // Linked through thread_t.wait_next
+    thread_t* waiters_tail;
+} mutex_t;
+
+#define MUTEX_INIT { SPINLOCK_INIT, NULL, 0, NULL, NULL }
+
+void mutex_lock(mutex_t* mutex);
+
+// Takes the mutex only if that needs no waiting. Returns false otherwise.
+bool mutex_trylock(mutex_t* mutex);
+
+void mutex_unlock(mutex_t* mutex);
+
+#endif // MUTEX_H
@@ -0,0 +1,175 @@
+#include "process.h"
+#include "sched.h"
+#include "gdt.h"
+#include "cpu.h"
+#include "ring.h"
+#include "../fs/elf.h"
+#include "../fs/pagecache.h"
+#include "../memory/paging.h"
+#include "../memory/mmap.h"
+#include <stddef.h>
+
+#define USER_EFLAGS 0x202 // IF set, IOPL 0
+
+typedef struct {
+    volatile bool running;
+    uint32_t entry;
+    uint32_t image_end;      // End of the pages elf_load() mapped
+    int status;
+    thread_t* thread;
+    thread_t* waiter;        // The thread in process_run()
+} process_t;
+
+static process_t process;
+
+// --- Internal Helper Functions ---
+
+// Frees every page mapped in [start, end).
+static void process_unmap_range(uint32_t start, uint32_t end) {
+    for (uint32_t vaddr = start; vaddr < end; vaddr += PAGE_SIZE) {
+        uint32_t entry = paging_get_entry(vaddr);
+        if (entry & PAGE_PRESENT) {
+            pmm_free_page((void*)(entry & PAGE_FRAME_MASK));
+            paging_unmap_page(vaddr);
+        }
+    }
+}
+
+static bool process_map_stack(void) {
+    for (uint32_t vaddr = USER_STACK_TOP - USER_STACK_SIZE; vaddr < USER_STACK_TOP; vaddr += PAGE_SIZE) {
+        void* frame = pmm_alloc_zeroed_page();
+        if (frame == NULL) {
+            return false;
+        }
+        if (!paging_map_page(vaddr, (uint32_t)frame, PAGE_WRITABLE | PAGE_USER)) {
+            pmm_free_page(frame);
+            return false;
+        }
+    }
+    return true;
+}
+
+static void process_free_memory(void) {
+    mutex_lock(&fs_lock);
+    mmap_unmap_all();
+    mutex_unlock(&fs_lock);
+    process_unmap_range(USER_SPACE_START, process.image_end);
+    process_unmap_range(USER_STACK_TOP - USER_STACK_SIZE, USER_STACK_TOP);
+}
+
+// Thread body: drops to ring 3 at the program's entry point. The CPU
+// switches back to the top of this thread's stack (the TSS esp0) on every
+// syscall or interrupt, so the frames below are never returned to.
+static void process_start(void* arg) {
+    (void)arg;
+    asm volatile(
+        "cli\n"                 // Nothing may run with user segments loaded
+        "mov %0, %%ax\n"
+        "mov %%ax, %%ds\n"
+        "mov %%ax, %%es\n"
+        "mov %%ax, %%fs\n"
+        "push %0\n"             // ss
+        "push %1\n"             // esp
+        "push %2\n"             // eflags
+        "push %3\n"             // cs
+        "push %4\n"             // eip
+        "iret\n"
+        :
+        : "i"(GDT_USER_DATA), "i"(USER_STACK_TOP), "i"(USER_EFLAGS), "i"(GDT_USER_CODE),
+          "r"(process.entry)
+        : "eax", "memory");
+    __builtin_unreachable();
+}
+
+// --- Public API Functions ---
+
+bool process_run(FAT32_DirectoryEntry* file, int* status) {
+    if (process.running) {
+        return false;
+    }
+
+    process.image_end = USER_SPACE_START;
+    process.entry = elf_load(file, &process.image_end);
+    if (process.entry == 0 || !process_map_stack()) {
+        process_free_memory();
+        return false;
+    }
+
+    // On this CPU, like the rings it may set up; the ring workers and the
+    // program share its view of the user window without TLB shootdowns
+    process.waiter = thread_current();
+    process.thread = NULL;
+    process.running = true;
+    process.thread = thread_create("user", process_start, NULL, SCHED_PRIO_NORMAL);
+    if (process.thread == NULL) {
+        process.running = false;
+        process_free_memory();
+        return false;
+    }
+
+    while (process.running) {
+        thread_block();
+    }
+    *status = process.status;
+    return true;
+}
+
+void process_exit(int status) {
+    asm volatile("sti"); // The fault handler gets here with interrupts off
+
+    // A fault inside a syscall may have struck with the lock held
+    while (fs_lock.owner == thread_current()) {
+        mutex_unlock(&fs_lock);
+    }
+
+    // Rings first: their workers may still be writing to user memory
+    ring_release_all();
+    process_free_memory();
+    process.status = status;
+
+    // The waiter shares our CPU, so with interrupts off it can't start the
+    // next program before this thread is off the CPU for good
+    asm volatile("cli");
+    process.running = false;
+    thread_unblock(process.waiter);
+    thread_exit();
+}
+
+bool process_is_current(void) {
+    return process.running && process.thread == thread_current();
+}
+
+struct cpu* process_cpu(void) {
+    thread_t* thread = process.thread;
+    return (process.running && thread != NULL) ? thread->cpu : NULL;
+}
+
+bool process_user_range_ok(uint32_t addr, uint32_t length) {
+    if (addr < USER_SPACE_START || addr > USER_SPACE_END || length > USER_SPACE_END - addr) {
+        return false;
+    }
+    // Inside the window, a hole would still fault in ring 0
+    for (uint32_t page = addr & PAGE_FRAME_MASK; page < addr + length; page += PAGE_SIZE) {
+        if (page >= MMAP_WINDOW_START && page < MMAP_WINDOW_END) {
+            continue; // Demand-paged; a fault outside any mapping ends the program
+        }
+        if ((paging_get_entry(page) & (PAGE_PRESENT | PAGE_USER)) != (PAGE_PRESENT | PAGE_USER)) {
+            return false;
+        }
+    }
+    return true;
+}
+
+bool process_copy_string(char* dest, uint32_t src, uint32_t size) {
+    for (uint32_t i = 0; i < size; i++) {
+        uint32_t addr = src + i;
+        if ((i == 0 || (addr & (PAGE_SIZE - 1)) == 0) && !process_user_range_ok(addr, 1)) {
+            return false;
+        }
+        dest[i] = *(const char*)addr;
+        if (dest[i] == '\0') {
+            return true;
+        }
+    }
+    return false; // Unterminated, or too long
+}
@@ -0,0 +1,49 @@
+#ifndef PROCESS_H
+#define PROCESS_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "../fs/fat32.h"
+
+// --- User Processes ---
+// A user program runs in ring 3 on a kernel thread of its own, which
+// provides its kernel stack for syscalls and interrupts. There is still
+// one address space: user pages live in the window below, mapped with
+// PAGE_USER, while everything else (the direct map, MMIO) stays
+// supervisor-only. One program runs at a time, started by the shell.
+
+#define USER_SPACE_START 0x40000000 // Just above the direct map
+#define USER_IMAGE_END   0x50000000 // ELF segments must lie below this
+#define USER_STACK_TOP   0x60000000 // The mmap window starts here
+#define USER_STACK_SIZE  0x10000
+#define USER_SPACE_END   0x70000000 // End of the mmap window
+
+// Loads 'file' and runs it in ring 3, returning once it has exited.
+// Returns false if it couldn't be started; otherwise '*status' receives
+// the value passed to SYS_EXIT, or -1 if the program was killed.
+bool process_run(FAT32_DirectoryEntry* file, int* status);
+
+// Tears down the running program (its memory, mappings and rings) and ends
+// its thread. Called for SYS_EXIT and when the program faults, including
+// inside a syscall on its behalf.
+void process_exit(int status) __attribute__((noreturn));
+
+// True if the calling thread is the running program's.
+bool process_is_current(void);
+
+// The CPU the running program is on, or NULL if none is running. Only it
+// (with the program's ring workers) touches the user window, so only its
+// TLB can hold user mappings.
+struct cpu* process_cpu(void);
+
+// True if every page of [addr, addr + length) belongs to the program:
+// mapped with PAGE_USER, or in the mmap window, where a fault fills it in.
+// Syscalls check the pointers they are given with it before touching them.
+bool process_user_range_ok(uint32_t addr, uint32_t length);
+
+// Copies the NUL-terminated string at user address 'src' into 'dest',
+// checking each page before reading from it. Returns false if a page
+// isn't the program's or there is no NUL within 'size' bytes.
+bool process_copy_string(char* dest, uint32_t src, uint32_t size);
+
+#endif // PROCESS_H
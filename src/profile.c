@@ -0,0 +1,199 @@
+#include "profile.h"
+#include "ksyms.h"
+#include "smp.h"
+#include "sched.h"
+#include "../drivers/terminal.h"
+#include "../drivers/serial.h"
+#include "../memory/pmm.h"
+#include "../memory/heap.h"
+#include "../lib/string.h"
+#include <stddef.h>
+
+#define SAMPLES_PER_PAGE (PAGE_SIZE / sizeof(profile_sample_t))
+
+// One CPU's samples, in pages that need not be contiguous
+typedef struct {
+    profile_sample_t* pages[PROFILE_PAGES];
+    uint32_t capacity;
+    volatile uint32_t count;    // Only the owning CPU's timer IRQ adds
+    volatile uint32_t dropped;  // Samples that didn't fit
+} profile_cpu_t;
+
+static profile_cpu_t profile_cpus[MAX_CPUS];
+static volatile bool profiling = false;
+static bool record_callchains = false;
+
+// --- Internal Helper Functions ---
+
+static profile_sample_t* profile_sample_at(profile_cpu_t* pc, uint32_t index) {
+    return &pc->pages[index / SAMPLES_PER_PAGE][index % SAMPLES_PER_PAGE];
+}
+
+// Follows the saved EBP chain from 'fp', staying inside the interrupted
+// thread's stack so a corrupt frame can't make us fault.
+static uint16_t profile_walk_frames(uint32_t fp, uint32_t* callers) {
+    thread_t* thread = this_cpu()->sched.current;
+    if (thread == NULL || thread->stack == NULL) {
+        return 0; // Idle threads run on boot stacks of unknown extent
+    }
+    uint32_t low = (uint32_t)thread->stack;
+    uint32_t high = low + THREAD_STACK_SIZE;
+
+    uint16_t depth = 0;
+    while (depth < PROFILE_MAX_DEPTH && fp >= low && fp + 8 <= high && (fp & 3) == 0) {
+        const uint32_t* frame = (const uint32_t*)fp;
+        callers[depth++] = frame[1];
+        if (frame[0] <= fp) {
+            break; // Frames only get older going up the stack
+        }
+        fp = frame[0];
+    }
+    return depth;
+}
+
+// Name for a sampled address. Return addresses point after the call, so
+// callers look up the byte before.
+static const char* profile_name(uint32_t addr) {
+    const char* name = ksym_lookup(addr, NULL);
+    return (name != NULL) ? name : "[unknown]";
+}
+
+static bool profile_alloc_buffers(void) {
+    for (uint32_t cpu = 0; cpu < smp_cpu_count(); cpu++) {
+        profile_cpu_t* pc = &profile_cpus[cpu];
+        while (pc->capacity < PROFILE_PAGES * SAMPLES_PER_PAGE) {
+            void* page = pmm_alloc_page();
+            if (page == NULL) {
+                return false;
+            }
+            pc->pages[pc->capacity / SAMPLES_PER_PAGE] = page;
+            pc->capacity += SAMPLES_PER_PAGE;
+        }
+    }
+    return true;
+}
+
+// --- Public API Functions ---
+
+bool profile_start(bool callchains) {
+    profile_stop();
+    if (!profile_alloc_buffers()) {
+        return false;
+    }
+    for (uint32_t cpu = 0; cpu < MAX_CPUS; cpu++) {
+        profile_cpus[cpu].count = 0;
+        profile_cpus[cpu].dropped = 0;
+    }
+    record_callchains = callchains;
+    profiling = true;
+    sched_rearm_timers(); // Idle CPUs may have no timer armed at all
+    return true;
+}
+
+void profile_stop(void) {
+    profiling = false;
+}
+
+bool profile_running(void) {
+    return profiling;
+}
+
+void profile_tick(registers_t* regs) {
+    if (!profiling) {
+        return;
+    }
+    profile_cpu_t* pc = &profile_cpus[this_cpu()->index];
+    if (pc->count >= pc->capacity) {
+        pc->dropped++;
+        return;
+    }
+
+    profile_sample_t* sample = profile_sample_at(pc, pc->count);
+    sample->eip = regs->eip;
+    sample->flags = 0;
+    sample->depth = 0;
+    if ((regs->cs & 3) == 3) {
+        sample->flags |= PROFILE_SAMPLE_USER;
+    } else if (record_callchains) {
+        sample->depth = profile_walk_frames(regs->ebp, sample->callers);
+    }
+    pc->count++;
+}
+
+void profile_print_report(uint32_t max_rows) {
+    // One counter per symbol, then the user and unknown buckets
+    uint32_t buckets = ksym_count + 2;
+    uint32_t* hits = malloc(buckets * sizeof(uint32_t));
+    if (hits == NULL) {
+        terminal_writeerror("Not enough memory for the report.");
+        return;
+    }
+    memset(hits, 0, buckets * sizeof(uint32_t));
+
+    uint32_t total = 0, dropped = 0;
+    for (uint32_t cpu = 0; cpu < MAX_CPUS; cpu++) {
+        profile_cpu_t* pc = &profile_cpus[cpu];
+        for (uint32_t i = 0; i < pc->count; i++) {
+            profile_sample_t* sample = profile_sample_at(pc, i);
+            int index = ksym_find(sample->eip);
+            if (sample->flags & PROFILE_SAMPLE_USER) {
+                index = ksym_count;
+            } else if (index < 0) {
+                index = ksym_count + 1;
+            }
+            hits[index]++;
+        }
+        total += pc->count;
+        dropped += pc->dropped;
+    }
+
+    terminal_printf("%d samples, %d dropped (buffers full)\n", FG_WHITE, total, dropped);
+    if (total == 0) {
+        free(hits);
+        return;
+    }
+    terminal_printf("  PCT  SAMPLES   FUNCTION\n", FG_MAGENTA);
+    for (uint32_t row = 0; row < max_rows; row++) {
+        uint32_t best = 0;
+        for (uint32_t i = 1; i < buckets; i++) {
+            if (hits[i] > hits[best]) {
+                best = i;
+            }
+        }
+        if (hits[best] == 0) {
+            break;
+        }
+        const char* name = (best == ksym_count) ? "[user]"
+                         : (best == ksym_count + 1) ? "[unknown]"
+                         : ksym_table[best].name;
+        terminal_printf("  %d    %d       %s\n", FG_WHITE, hits[best] * 100 / total, hits[best], name);
+        hits[best] = 0;
+    }
+    free(hits);
+}
+
+uint32_t profile_export_folded(void) {
+    uint32_t written = 0;
+    char line[512];
+    for (uint32_t cpu = 0; cpu < MAX_CPUS; cpu++) {
+        profile_cpu_t* pc = &profile_cpus[cpu];
+        for (uint32_t i = 0; i < pc->count; i++) {
+            profile_sample_t* sample = profile_sample_at(pc, i);
+            if (sample->flags & PROFILE_SAMPLE_USER) {
+                strcpy(line, "[user]");
+            } else {
+                // Outermost caller first, the sampled function last
+                line[0] = '\0';
+                for (int d = sample->depth - 1; d >= 0; d--) {
+                    strcat(line, profile_name(sample->callers[d] - 1));
+                    strcat(line, ";");
+                }
+                strcat(line, profile_name(sample->eip));
+            }
+            strcat(line, " 1\r\n");
+            serial_write(line, strlen(line));
+            written++;
+        }
+    }
+    return written;
+}
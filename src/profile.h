@@ -0,0 +1,49 @@
+#ifndef PROFILE_H
+#define PROFILE_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "../idt/idt.h"
+
+// --- Sampling Profiler ---
+// While running, every CPU takes a timer interrupt each tick (TIMER_HZ),
+// busy or idle, and records where it interrupted: the EIP and, if asked
+// for, the return addresses found by following the saved frame pointers
+// (the kernel is built without -fomit-frame-pointer). Samples go into a
+// per-CPU buffer that only that CPU writes, so the IRQ path takes no
+// locks. Reports are symbolized with the table built into the kernel (see
+// ksyms.h).
+
+#define PROFILE_MAX_DEPTH   6  // Callers recorded per sample
+#define PROFILE_PAGES       64 // Buffer per CPU: 8192 samples, ~8 s
+
+#define PROFILE_SAMPLE_USER 0x1 // Interrupted a user program
+
+typedef struct {
+    uint32_t eip;
+    uint16_t depth;             // Entries of 'callers' in use
+    uint16_t flags;
+    uint32_t callers[PROFILE_MAX_DEPTH]; // Return addresses, innermost first
+} profile_sample_t;
+
+// Clears the buffers and starts sampling on every CPU; with 'callchains'
+// the frame-pointer chain is recorded too. The buffers are allocated on
+// first use. Returns false if there was no memory for them.
+bool profile_start(bool callchains);
+
+void profile_stop(void);
+
+bool profile_running(void);
+
+// Timer IRQ hook: takes a sample of the interrupted context.
+void profile_tick(registers_t* regs);
+
+// Prints the 'max_rows' functions with the most samples.
+void profile_print_report(uint32_t max_rows);
+
+// Writes every sample to the serial port in the folded-stack format that
+// flame graph tools read ("outer;caller;function 1" per line). Returns the
+// number of samples written.
+uint32_t profile_export_folded(void);
+
+#endif // PROFILE_H
@@ -0,0 +1,239 @@
+#include "ring.h"
+#include "sched.h"
+#include "smp.h"
+#include "syscall.h"
+#include "../user/lib/ioring.h"
+#include "../memory/mmap.h"
+#include "../fs/pagecache.h"
+#include <stddef.h>
+
+typedef struct {
+    bool in_use;
+    ioring_shared_t* shared;
+    thread_t* owner;
+    thread_t* worker;
+    spinlock_t lock;              // Guards everything below and the CQ tail
+    ioring_sqe_t pending[IORING_SQ_ENTRIES]; // Copies of SQEs for the worker
+    uint32_t pending_head;
+    uint32_t pending_tail;
+    uint32_t inflight;            // Handed to the worker, not yet posted
+    bool owner_waiting;
+    volatile bool stopping;
+    volatile bool worker_done;
+} ring_t;
+
+static ring_t rings[RING_MAX];
+
+// --- Internal Helper Functions ---
+
+static ring_t* ring_find(uint32_t addr) {
+    for (int i = 0; i < RING_MAX; i++) {
+        if (rings[i].in_use && (uint32_t)rings[i].shared == addr) {
+            return &rings[i];
+        }
+    }
+    return NULL;
+}
+
+static bool ring_op_is_async(uint32_t opcode) {
+    return opcode == IORING_OP_READ || opcode == IORING_OP_OPEN;
+}
+
+// Runs one operation through the syscall that has the same number.
+static int ring_execute(const ioring_sqe_t* sqe) {
+    switch (sqe->opcode) {
+        case IORING_OP_READ:
+        case IORING_OP_WRITE:
+        case IORING_OP_OPEN:
+        case IORING_OP_CLEAR_SCREEN:
+        case IORING_OP_SET_CURSOR:
+        case IORING_OP_GET_KEY:
+            return syscall_table[sqe->opcode](sqe->args[0], sqe->args[1], sqe->args[2]);
+        default:
+            return -1; // Not allowed in a ring (exit, mmap, ...)
+    }
+}
+
+// CQ slots not yet spoken for. Operations are only taken from the SQ while
+// this is non-zero, so the CQ can never overflow. Caller holds ring->lock.
+static uint32_t ring_cq_space(ring_t* ring) {
+    uint32_t used = ring->shared->cq_tail - ring->shared->cq_head;
+    if (used > IORING_CQ_ENTRIES) {
+        return 0; // The program scribbled over cq_head
+    }
+    uint32_t free_slots = IORING_CQ_ENTRIES - used;
+    return (free_slots > ring->inflight) ? free_slots - ring->inflight : 0;
+}
+
+// Posts a completion and wakes the owner if it is waiting for one.
+static void ring_post(ring_t* ring, uint32_t user_data, int res, bool from_worker) {
+    uint32_t flags = spin_lock_irqsave(&ring->lock);
+    ioring_shared_t* shared = ring->shared;
+    ioring_cqe_t* cqe = &shared->cqes[shared->cq_tail % IORING_CQ_ENTRIES];
+    cqe->user_data = user_data;
+    cqe->res = res;
+    __sync_synchronize(); // The entry must be visible before the new tail
+    shared->cq_tail++;
+
+    if (from_worker) {
+        ring->inflight--;
+    }
+    bool wake = ring->owner_waiting;
+    spin_unlock_irqrestore(&ring->lock, flags);
+
+    if (wake) {
+        thread_unblock(ring->owner);
+    }
+}
+
+static void ring_worker(void* arg) {
+    ring_t* ring = arg;
+
+    while (!ring->stopping) {
+        uint32_t flags = spin_lock_irqsave(&ring->lock);
+        if (ring->pending_head == ring->pending_tail) {
+            spin_unlock_irqrestore(&ring->lock, flags);
+            thread_block(); // ring_enter() or ring_release_all() wakes us
+            continue;
+        }
+        ioring_sqe_t sqe = ring->pending[ring->pending_head % IORING_SQ_ENTRIES];
+        ring->pending_head++;
+        spin_unlock_irqrestore(&ring->lock, flags);
+
+        ring_post(ring, sqe.user_data, ring_execute(&sqe), true);
+    }
+    ring->worker_done = true;
+}
+
+// Hands an SQE to the worker. Returns false if its queue is full.
+static bool ring_queue_async(ring_t* ring, const ioring_sqe_t* sqe) {
+    uint32_t flags = spin_lock_irqsave(&ring->lock);
+    if (ring->pending_tail - ring->pending_head >= IORING_SQ_ENTRIES) {
+        spin_unlock_irqrestore(&ring->lock, flags);
+        return false;
+    }
+    ring->pending[ring->pending_tail % IORING_SQ_ENTRIES] = *sqe;
+    ring->pending_tail++;
+    ring->inflight++;
+    spin_unlock_irqrestore(&ring->lock, flags);
+
+    thread_unblock(ring->worker);
+    return true;
+}
+
+// --- Public API Functions ---
+
+int ring_setup(uint32_t a1, uint32_t a2, uint32_t a3) {
+    (void)a1; (void)a2; (void)a3; // Unused
+
+    ring_t* ring = NULL;
+    for (int i = 0; i < RING_MAX; i++) {
+        if (!rings[i].in_use) {
+            ring = &rings[i];
+            break;
+        }
+    }
+    if (ring == NULL) {
+        return 0;
+    }
+
+    // Pinned, so posting a completion with interrupts off can never fault
+    mutex_lock(&fs_lock);
+    uint32_t addr = mmap_anonymous_pinned(sizeof(ioring_shared_t));
+    mutex_unlock(&fs_lock);
+    if (addr == 0) {
+        return 0;
+    }
+
+    ring->shared = (ioring_shared_t*)addr;
+    ring->owner = thread_current();
+    ring->lock = (spinlock_t)SPINLOCK_INIT;
+    ring->pending_head = 0;
+    ring->pending_tail = 0;
+    ring->inflight = 0;
+    ring->owner_waiting = false;
+    ring->stopping = false;
+    ring->worker_done = false;
+
+    // Same CPU as the owner: the two share the mmap window's page tables
+    // and never need a TLB shootdown between them
+    ring->worker = thread_create_on(this_cpu()->index, "ring", ring_worker, ring, SCHED_PRIO_NORMAL);
+    if (ring->worker == NULL) {
+        mutex_lock(&fs_lock);
+        mmap_unmap(addr);
+        mutex_unlock(&fs_lock);
+        return 0;
+    }
+    ring->in_use = true;
+    return addr;
+}
+
+int ring_enter(uint32_t ring_addr, uint32_t to_submit, uint32_t min_complete) {
+    ring_t* ring = ring_find(ring_addr);
+    if (ring == NULL || ring->owner != thread_current()) {
+        return -1;
+    }
+    ioring_shared_t* shared = ring->shared;
+
+    uint32_t submitted = 0;
+    while (submitted < to_submit && shared->sq_head != shared->sq_tail) {
+        uint32_t flags = spin_lock_irqsave(&ring->lock);
+        uint32_t space = ring_cq_space(ring);
+        spin_unlock_irqrestore(&ring->lock, flags);
+        if (space == 0) {
+            break; // The program has to reap completions first
+        }
+
+        ioring_sqe_t sqe = shared->sqes[shared->sq_head % IORING_SQ_ENTRIES];
+        shared->sq_head++;
+        submitted++;
+
+        if (!ring_op_is_async(sqe.opcode) || !ring_queue_async(ring, &sqe)) {
+            ring_post(ring, sqe.user_data, ring_execute(&sqe), false);
+        }
+    }
+
+    // Wait for completions, unless what's asked for can never arrive
+    for (;;) {
+        uint32_t flags = spin_lock_irqsave(&ring->lock);
+        uint32_t ready = shared->cq_tail - shared->cq_head;
+        if (ready >= min_complete || ring->inflight == 0) {
+            ring->owner_waiting = false;
+            spin_unlock_irqrestore(&ring->lock, flags);
+            break;
+        }
+        ring->owner_waiting = true;
+        spin_unlock_irqrestore(&ring->lock, flags);
+        thread_block();
+    }
+    return submitted;
+}
+
+void ring_release_all(void) {
+    for (int i = 0; i < RING_MAX; i++) {
+        ring_t* ring = &rings[i];
+        if (!ring->in_use) continue;
+
+        // Let the worker finish what it's doing; queued work is dropped
+        ring->stopping = true;
+        for (;;) {
+            // The worker shares our CPU, so with interrupts off it can't
+            // exit (and be freed) between the check and the wakeup
+            uint32_t flags = irq_save();
+            bool done = ring->worker_done;
+            if (!done) {
+                thread_unblock(ring->worker);
+            }
+            irq_restore(flags);
+            if (done) {
+                break;
+            }
+            thread_sleep_ms(1);
+        }
+
+        mutex_lock(&fs_lock);
+        mmap_unmap((uint32_t)ring->shared);
+        mutex_unlock(&fs_lock);
+        ring->in_use = false;
+    }
+}
@@ -0,0 +1,23 @@
+#ifndef RING_H
+#define RING_H
+
+#include <stdint.h>
+
+// --- Submission/Completion Rings (kernel side) ---
+// Backs SYS_RING_SETUP and SYS_ENTER_RING; the shared layout is in
+// user/lib/ioring.h. Each ring gets a worker thread on its owner's CPU for
+// the file operations, which complete asynchronously.
+
+#define RING_MAX 4
+
+// SYS_RING_SETUP: returns the shared page's address, or 0.
+int ring_setup(uint32_t a1, uint32_t a2, uint32_t a3);
+
+// SYS_ENTER_RING: submits and waits. Returns the number submitted, or -1.
+int ring_enter(uint32_t ring_addr, uint32_t to_submit, uint32_t min_complete);
+
+// Stops every ring's worker and unmaps the rings. Called once the program
+// that owned them has ended.
+void ring_release_all(void);
+
+#endif // RING_H
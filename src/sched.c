@@ -0,0 +1,474 @@
+#include "sched.h"
+#include "smp.h"
+#include "cpu.h"
+#include "gdt.h"
+#include "fpu.h"
+#include "profile.h"
+#include "../drivers/timer.h"
+#include "../drivers/lapic.h"
+#include "../drivers/terminal.h"
+#include "../memory/heap.h"
+
+extern void switch_context(uint32_t* old_esp, uint32_t new_esp);
+
+static thread_t* all_threads = NULL;
+static spinlock_t all_threads_lock = SPINLOCK_INIT;
+static uint32_t next_thread_id = 0;
+
+// --- Internal Helper Functions ---
+
+static void run_queue_push(sched_cpu_t* sc, thread_t* thread) {
+    run_queue_t* queue = &sc->run_queues[thread->priority];
+    thread->next = NULL;
+    if (queue->tail != NULL) {
+        queue->tail->next = thread;
+    } else {
+        queue->head = thread;
+    }
+    queue->tail = thread;
+}
+
+static thread_t* run_queue_pop(sched_cpu_t* sc) {
+    for (int prio = 0; prio < SCHED_PRIORITIES; prio++) {
+        run_queue_t* queue = &sc->run_queues[prio];
+        thread_t* thread = queue->head;
+        if (thread != NULL) {
+            queue->head = thread->next;
+            if (queue->head == NULL) {
+                queue->tail = NULL;
+            }
+            thread->next = NULL;
+            return thread;
+        }
+    }
+    return NULL;
+}
+
+// Queues a thread on its CPU. Returns true if it should preempt whatever
+// that CPU is running. The caller holds the CPU's scheduler lock.
+static bool sched_make_ready(thread_t* thread) {
+    sched_cpu_t* sc = &thread->cpu->sched;
+    thread->state = THREAD_READY;
+    run_queue_push(sc, thread);
+    if (sc->current != NULL && thread->priority < sc->current->priority) {
+        sc->need_resched = true;
+        return true;
+    }
+    return false;
+}
+
+// Gets a CPU to notice new work in its run queue. Remote CPUs are sent an
+// IPI, unless they're waiting in MWAIT for need_resched to change; the
+// local CPU switches now if the caller can be preempted.
+static void sched_kick(cpu_t* cpu, uint32_t caller_flags) {
+    if (cpu != this_cpu()) {
+        __sync_synchronize(); // Order the need_resched store before the 'polling' load
+        if (!cpu->sched.polling) {
+            lapic_send_ipi(cpu->apic_id, LAPIC_RESCHED_VECTOR);
+        }
+    } else if (caller_flags & EFLAGS_IF) {
+        thread_yield();
+    }
+}
+
+// Inserts a thread into the sleep list, which is kept sorted by
+// wake_tick. The caller holds the CPU's scheduler lock.
+static void sleepers_insert(sched_cpu_t* sc, thread_t* thread) {
+    thread_t** link = &sc->sleepers;
+    while (*link != NULL && (*link)->wake_tick <= thread->wake_tick) {
+        link = &(*link)->next;
+    }
+    thread->next = *link;
+    *link = thread;
+}
+
+// Takes a thread in thread_block_timeout() off the sleep list when it is
+// unblocked before its timeout. The caller holds the CPU's scheduler lock.
+static void sleepers_remove(sched_cpu_t* sc, thread_t* thread) {
+    for (thread_t** link = &sc->sleepers; *link != NULL; link = &(*link)->next) {
+        if (*link == thread) {
+            *link = thread->next;
+            break;
+        }
+    }
+    thread->wake_tick = 0;
+}
+
+static uint64_t ms_to_ticks(uint32_t ms) {
+    uint32_t ticks = (ms * TIMER_HZ + 999) / 1000;
+    return (ticks == 0) ? 1 : ticks;
+}
+
+static void all_threads_add(thread_t* thread) {
+    uint32_t flags = spin_lock_irqsave(&all_threads_lock);
+    thread->all_next = all_threads;
+    all_threads = thread;
+    spin_unlock_irqrestore(&all_threads_lock, flags);
+}
+
+static void all_threads_remove(thread_t* thread) {
+    uint32_t flags = spin_lock_irqsave(&all_threads_lock);
+    for (thread_t** link = &all_threads; *link != NULL; link = &(*link)->all_next) {
+        if (*link == thread) {
+            *link = thread->all_next;
+            break;
+        }
+    }
+    spin_unlock_irqrestore(&all_threads_lock, flags);
+}
+
+// Arms the one-shot timer for the next event on this CPU: the first
+// sleeper's wake tick, or the end of the slice unless we're idle. Skips
+// the (slow, MMIO) reprogramming if that deadline is already armed.
+// Interrupts must be disabled.
+static void sched_arm_timer(sched_cpu_t* sc) {
+    if (!lapic_timer_is_oneshot()) {
+        return; // Periodic ticks: nothing to arm
+    }
+
+    uint64_t deadline = (sc->sleepers != NULL) ? sc->sleepers->wake_tick : 0;
+    if (sc->current != &sc->idle && (deadline == 0 || sc->slice_end < deadline)) {
+        deadline = sc->slice_end;
+    }
+    if (profile_running()) {
+        deadline = timer_get_ticks() + 1; // A sample every tick, idle or not
+    }
+    if (deadline == sc->timer_deadline) {
+        return;
+    }
+    sc->timer_deadline = deadline;
+
+    if (deadline == 0) {
+        lapic_timer_arm(0);
+        return;
+    }
+    // Whole periods from the current (rounded down) tick, so the timer
+    // never fires before the deadline tick has begun
+    uint64_t now = timer_get_ticks();
+    uint64_t delta = (deadline > now) ? deadline - now : 1;
+    lapic_timer_arm(delta > 0xFFFFFFFF ? 0xFFFFFFFF : (uint32_t)delta);
+}
+
+// Frees threads that died on this CPU. Never touches the running thread,
+// whose stack is live.
+static void sched_reap(void) {
+    sched_cpu_t* sc = &this_cpu()->sched;
+    thread_t** link = &sc->zombies;
+    while (*link != NULL) {
+        thread_t* thread = *link;
+        if (thread == sc->current) {
+            link = &thread->next;
+            continue;
+        }
+        *link = thread->next;
+
+        all_threads_remove(thread);
+        fpu_state_free(thread->fpu_state);
+        free(thread->stack);
+        free(thread);
+    }
+}
+
+// Picks the next thread and switches to it. Interrupts must be disabled.
+static void schedule(void) {
+    sched_cpu_t* sc = &this_cpu()->sched;
+    uint32_t flags = spin_lock_irqsave(&sc->lock);
+
+    thread_t* prev = sc->current;
+    if (prev->state == THREAD_RUNNING) {
+        prev->state = THREAD_READY;
+        run_queue_push(sc, prev);
+    }
+
+    // The idle thread never blocks, so there is always someone to run
+    thread_t* next = run_queue_pop(sc);
+    next->state = THREAD_RUNNING;
+    sc->need_resched = false;
+    sc->current = next;
+
+    if (next != prev) {
+        // Idle accounting: the idle thread's time on the CPU is idle time,
+        // whether it is halted or pre-zeroing pages
+        if (prev == &sc->idle) {
+            sc->idle_ns += ktime_ns() - sc->idle_since;
+        } else if (next == &sc->idle) {
+            sc->idle_since = ktime_ns();
+        }
+    }
+    sc->slice_end = timer_get_ticks() + SCHED_TIMESLICE_TICKS;
+    sched_arm_timer(sc);
+
+    // A remote wakeup may queue 'prev' as soon as the lock drops, but only
+    // this CPU ever pops it, so its stack is saved before anyone resumes it.
+    spin_unlock_irqrestore(&sc->lock, flags);
+
+    if (next != prev) {
+        // Interrupts and syscalls from ring 3 land on the top of the
+        // incoming thread's stack (idle threads never leave the kernel)
+        if (next->stack != NULL) {
+            gdt_set_kernel_stack((uint32_t)next->stack + THREAD_STACK_SIZE);
+        }
+        fpu_switch(next);
+        switch_context(&prev->esp, next->esp);
+    }
+
+    // Back on prev's stack (or a fresh thread's): clean up the dead
+    sched_reap();
+}
+
+// Every new thread starts here, still holding the scheduler's interrupt-off
+// state from the switch that brought it in.
+static void thread_trampoline(void) {
+    sched_reap();
+    asm volatile("sti");
+    thread_t* self = thread_current();
+    self->entry(self->arg);
+    thread_exit();
+}
+
+// --- Public API Functions ---
+
+void sched_init(void) {
+    cpu_t* cpu = this_cpu();
+    thread_t* idle = &cpu->sched.idle;
+
+    idle->id = __sync_fetch_and_add(&next_thread_id, 1);
+    idle->name = "idle";
+    idle->state = THREAD_RUNNING;
+    idle->priority = SCHED_PRIO_IDLE;
+    idle->cpu = cpu;
+    idle->stack = NULL;
+    idle->fpu_state = NULL;
+    cpu->sched.current = idle;
+    cpu->sched.online_since = ktime_ns();
+    cpu->sched.idle_since = cpu->sched.online_since;
+    all_threads_add(idle);
+}
+
+thread_t* thread_create_on(uint32_t cpu_index, const char* name, void (*entry)(void*), void* arg, int priority) {
+    if (cpu_index >= MAX_CPUS || !cpus[cpu_index].online) {
+        return NULL;
+    }
+    if (priority < 0 || priority >= SCHED_PRIO_IDLE) {
+        priority = SCHED_PRIO_NORMAL;
+    }
+
+    thread_t* thread = malloc(sizeof(thread_t));
+    if (thread == NULL) {
+        return NULL;
+    }
+    thread->stack = malloc(THREAD_STACK_SIZE);
+    thread->fpu_state = fpu_state_alloc();
+    if (thread->stack == NULL || thread->fpu_state == NULL) {
+        fpu_state_free(thread->fpu_state);
+        free(thread->stack);
+        free(thread);
+        return NULL;
+    }
+
+    // Build the frame switch_context pops: edi, esi, ebx, ebp, return address
+    uint32_t* sp = (uint32_t*)((uint8_t*)thread->stack + THREAD_STACK_SIZE);
+    *--sp = (uint32_t)thread_trampoline;
+    *--sp = 0; // ebp
+    *--sp = 0; // ebx
+    *--sp = 0; // esi
+    *--sp = 0; // edi
+    thread->esp = (uint32_t)sp;
+
+    thread->id = __sync_fetch_and_add(&next_thread_id, 1);
+    thread->name = name;
+    thread->priority = priority;
+    thread->cpu = &cpus[cpu_index];
+    thread->wake_pending = false;
+    thread->entry = entry;
+    thread->arg = arg;
+    thread->wake_tick = 0;
+    all_threads_add(thread);
+
+    uint32_t flags = spin_lock_irqsave(&thread->cpu->sched.lock);
+    bool kick = sched_make_ready(thread);
+    spin_unlock_irqrestore(&thread->cpu->sched.lock, flags);
+
+    if (kick) {
+        sched_kick(thread->cpu, flags);
+    }
+    return thread;
+}
+
+thread_t* thread_create(const char* name, void (*entry)(void*), void* arg, int priority) {
+    return thread_create_on(this_cpu()->index, name, entry, arg, priority);
+}
+
+void thread_exit(void) {
+    asm volatile("cli");
+    sched_cpu_t* sc = &this_cpu()->sched;
+    sc->current->state = THREAD_DEAD;
+    fpu_release(sc->current);
+    sc->current->next = sc->zombies;
+    sc->zombies = sc->current;
+    schedule();
+    for (;;); // Unreachable: nobody switches back to a dead thread
+}
+
+void thread_yield(void) {
+    uint32_t flags = irq_save();
+    schedule();
+    irq_restore(flags);
+}
+
+void thread_sleep_ms(uint32_t ms) {
+    uint32_t flags = irq_save();
+    sched_cpu_t* sc = &this_cpu()->sched;
+    thread_t* self = sc->current;
+
+    uint32_t lock_flags = spin_lock_irqsave(&sc->lock);
+    self->wake_tick = timer_get_ticks() + ms_to_ticks(ms);
+    self->state = THREAD_SLEEPING;
+    sleepers_insert(sc, self);
+    spin_unlock_irqrestore(&sc->lock, lock_flags);
+
+    schedule();
+    irq_restore(flags);
+}
+
+void thread_block(void) {
+    uint32_t flags = irq_save();
+    sched_cpu_t* sc = &this_cpu()->sched;
+    thread_t* self = sc->current;
+
+    // Under the lock thread_unblock() takes, so a wakeup is either seen
+    // here as pending or finds the thread already BLOCKED
+    uint32_t lock_flags = spin_lock_irqsave(&sc->lock);
+    if (self->wake_pending) {
+        self->wake_pending = false;
+        spin_unlock_irqrestore(&sc->lock, lock_flags);
+        irq_restore(flags);
+        return;
+    }
+    self->state = THREAD_BLOCKED;
+    spin_unlock_irqrestore(&sc->lock, lock_flags);
+
+    schedule();
+    irq_restore(flags);
+}
+
+bool thread_block_timeout(uint32_t ms) {
+    uint32_t flags = irq_save();
+    sched_cpu_t* sc = &this_cpu()->sched;
+    thread_t* self = sc->current;
+
+    // Blocked and on the sleep list at once: whichever of thread_unblock()
+    // and sched_tick() gets there first takes it off both
+    uint32_t lock_flags = spin_lock_irqsave(&sc->lock);
+    if (self->wake_pending) {
+        self->wake_pending = false;
+        spin_unlock_irqrestore(&sc->lock, lock_flags);
+        irq_restore(flags);
+        return true;
+    }
+    self->state = THREAD_BLOCKED;
+    self->timed_out = false;
+    self->wake_tick = timer_get_ticks() + ms_to_ticks(ms);
+    sleepers_insert(sc, self);
+    spin_unlock_irqrestore(&sc->lock, lock_flags);
+
+    schedule();
+    irq_restore(flags);
+    return !self->timed_out;
+}
+
+void thread_unblock(thread_t* thread) {
+    cpu_t* cpu = thread->cpu;
+    bool kick = false;
+
+    uint32_t flags = spin_lock_irqsave(&cpu->sched.lock);
+    if (thread->state == THREAD_BLOCKED) {
+        if (thread->wake_tick != 0) {
+            sleepers_remove(&cpu->sched, thread); // A timed block
+        }
+        kick = sched_make_ready(thread);
+    } else if (thread->state != THREAD_DEAD) {
+        thread->wake_pending = true; // Hasn't blocked yet
+    }
+    spin_unlock_irqrestore(&cpu->sched.lock, flags);
+
+    // From an IRQ (interrupts were off) the local switch happens in
+    // sched_preempt() on the way out instead.
+    if (kick) {
+        sched_kick(cpu, flags);
+    }
+}
+
+thread_t* thread_current(void) {
+    return this_cpu()->sched.current;
+}
+
+void sched_tick(void) {
+    sched_cpu_t* sc = &this_cpu()->sched;
+    if (sc->current == NULL) {
+        return; // Scheduler not up yet
+    }
+
+    sc->timer_deadline = 0; // A one-shot timer is spent once it fires
+
+    uint64_t now = timer_get_ticks();
+    if (sc->sleepers != NULL && sc->sleepers->wake_tick <= now) {
+        uint32_t flags = spin_lock_irqsave(&sc->lock);
+        while (sc->sleepers != NULL && sc->sleepers->wake_tick <= now) {
+            thread_t* thread = sc->sleepers;
+            sc->sleepers = thread->next;
+            thread->wake_tick = 0;
+            thread->timed_out = (thread->state == THREAD_BLOCKED);
+            sched_make_ready(thread);
+        }
+        spin_unlock_irqrestore(&sc->lock, flags);
+    }
+
+    // The idle thread has no slice: it only makes way for woken threads
+    if (sc->current != &sc->idle && now >= sc->slice_end) {
+        sc->need_resched = true;
+    }
+    sched_arm_timer(sc);
+}
+
+void sched_rearm_timers(void) {
+    // Switching re-arms the timer
+    for (uint32_t i = 0; i < smp_cpu_count(); i++) {
+        if (&cpus[i] != this_cpu()) {
+            cpus[i].sched.need_resched = true;
+            sched_kick(&cpus[i], 0);
+        }
+    }
+    thread_yield();
+}
+
+void sched_preempt(void) {
+    sched_cpu_t* sc = &this_cpu()->sched;
+    if (sc->current != NULL && sc->need_resched) {
+        schedule();
+    }
+}
+
+void sched_cpu_time(uint32_t cpu_index, uint64_t* idle_ns, uint64_t* total_ns) {
+    sched_cpu_t* sc = &cpus[cpu_index].sched;
+    uint32_t flags = spin_lock_irqsave(&sc->lock);
+    uint64_t now = ktime_ns();
+    *idle_ns = sc->idle_ns;
+    if (sc->current == &sc->idle) {
+        *idle_ns += now - sc->idle_since; // Still idle right now
+    }
+    *total_ns = now - sc->online_since;
+    spin_unlock_irqrestore(&sc->lock, flags);
+}
+
+void sched_print_threads(void) {
+    static const char* state_names[] = { "ready", "running", "sleeping", "blocked", "dead" };
+
+    terminal_printf("  ID  CPU  PRIO  STATE     NAME\n", FG_MAGENTA);
+    uint32_t flags = spin_lock_irqsave(&all_threads_lock);
+    for (thread_t* thread = all_threads; thread != NULL; thread = thread->all_next) {
+        terminal_printf("  %d   %d    %d     %s  %s\n", FG_WHITE, thread->id, thread->cpu->index,
+                        thread->priority, state_names[thread->state], thread->name);
+    }
+    spin_unlock_irqrestore(&all_threads_lock, flags);
+}
@@ -0,0 +1,130 @@
+#ifndef SCHED_H
+#define SCHED_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "spinlock.h"
+
+// --- Kernel Threads ---
+// Preemptive threads scheduled round-robin within strict priority levels.
+// The timer IRQ drives time slices and sleeps; a context switch happens on
+// the way out of an interrupt, or whenever a thread blocks or yields.
+// Code running with interrupts disabled is never preempted.
+//
+// With a one-shot LAPIC timer the scheduler is tickless: each CPU arms its
+// timer only for the next thing it has to act on, the earliest sleeper or
+// the end of the running thread's slice. An idle CPU with nobody sleeping
+// takes no timer interrupts at all.
+//
+// Every CPU has its own run queues, sleep list and idle thread. A thread
+// stays on the CPU it was created on; other CPUs only ever append to its
+// run queue when they wake it up.
+
+#define SCHED_PRIORITIES      4
+#define SCHED_PRIO_HIGH       0
+#define SCHED_PRIO_NORMAL     1
+#define SCHED_PRIO_LOW        2
+#define SCHED_PRIO_IDLE       3 // Reserved for the idle thread
+
+#define SCHED_TIMESLICE_TICKS 10
+#define THREAD_STACK_SIZE     16384
+
+typedef enum {
+    THREAD_READY,
+    THREAD_RUNNING,
+    THREAD_SLEEPING,
+    THREAD_BLOCKED,
+    THREAD_DEAD
+} thread_state_t;
+
+struct cpu;
+
+typedef struct thread {
+    uint32_t esp;            // Saved stack pointer; must stay first (switch.asm)
+    uint32_t id;
+    const char* name;
+    thread_state_t state;
+    bool wake_pending;       // Unblocked before it got to block; don't sleep
+    int priority;
+    struct cpu* cpu;         // CPU whose run queue the thread belongs to
+    uint64_t wake_tick;      // When it leaves the sleep list; 0 while not on it
+    bool timed_out;          // thread_block_timeout() ran out of time
+    void* stack;             // Base of the malloc'd stack (NULL for idle threads)
+    void* fpu_state;         // FPU/SIMD registers while not loaded (NULL for idle threads)
+    void (*entry)(void*);
+    void* arg;
+    struct thread* next;     // Run queue, sleep list or zombie list link
+    struct thread* wait_next; // Mutex waiter list link
+    struct thread* all_next; // Every live thread, for 'ps'
+} thread_t;
+
+typedef struct {
+    thread_t* head;
+    thread_t* tail;
+} run_queue_t;
+
+// Scheduler state of one CPU (embedded in its cpu_t)
+typedef struct {
+    spinlock_t lock;         // Guards the run queues against remote wakeups
+    run_queue_t run_queues[SCHED_PRIORITIES];
+    thread_t* current;
+    thread_t* sleepers;      // Sorted by wake_tick; under 'lock' like the run queues
+    thread_t* zombies;       // Dead threads waiting to be freed
+    volatile bool need_resched;
+    volatile bool polling;   // Idle in MWAIT on need_resched: a store wakes it, no IPI needed
+    uint64_t slice_end;      // Tick at which the running thread's slice is up
+    uint64_t timer_deadline; // Tick the one-shot timer is armed for, 0 if disarmed
+    uint64_t idle_ns;        // Time spent in the idle thread, up to idle_since
+    uint64_t idle_since;     // When the idle thread last started running
+    uint64_t online_since;   // When sched_init() ran on this CPU
+    thread_t idle;           // The flow the CPU came up on
+} sched_cpu_t;
+
+// Turns the calling CPU's boot flow into its idle thread. Call once per
+// CPU, before it enables interrupts.
+void sched_init(void);
+
+// Starts a kernel thread running entry(arg) on the calling CPU.
+// Returns NULL on failure.
+thread_t* thread_create(const char* name, void (*entry)(void*), void* arg, int priority);
+
+// Like thread_create(), but places the thread on CPU 'cpu_index'.
+thread_t* thread_create_on(uint32_t cpu_index, const char* name, void (*entry)(void*), void* arg, int priority);
+
+// Ends the calling thread. Its stack is freed once another thread runs.
+void thread_exit(void) __attribute__((noreturn));
+
+void thread_yield(void);
+void thread_sleep_ms(uint32_t ms);
+
+// Puts the calling thread to sleep until thread_unblock(). A wakeup that
+// arrives first makes it return at once, and it may also return
+// spuriously, so callers re-check their condition in a loop.
+void thread_block(void);
+void thread_unblock(thread_t* thread);
+
+// Like thread_block(), but also returns once 'ms' milliseconds have
+// passed. Returns false if it timed out rather than being unblocked.
+bool thread_block_timeout(uint32_t ms);
+
+thread_t* thread_current(void);
+
+// Timer IRQ hook: wakes sleepers, ends the running time slice if it is
+// up, and re-arms the one-shot timer.
+void sched_tick(void);
+
+// Called on the way out of an interrupt. Switches threads if needed.
+void sched_preempt(void);
+
+// Makes every CPU reschedule, and so re-arm its timer, after something
+// that sched_arm_timer() looks at changed (the profiler starting). Call
+// from a thread with interrupts enabled.
+void sched_rearm_timers(void);
+
+void sched_print_threads(void);
+
+// Time CPU 'cpu_index' has spent in its idle thread, and in total, since
+// it came online (in nanoseconds). The rest was spent running threads.
+void sched_cpu_time(uint32_t cpu_index, uint64_t* idle_ns, uint64_t* total_ns);
+
+#endif // SCHED_H
@@ -0,0 +1,144 @@
+#include "smp.h"
+#include "acpi.h"
+#include "gdt.h"
+#include "cpu.h"
+#include "syscall.h"
+#include "fpu.h"
+#include "cpu_features.h"
+#include "../idt/idt.h"
+#include "../drivers/lapic.h"
+#include "../drivers/timer.h"
+#include "../drivers/terminal.h"
+#include "../memory/paging.h"
+#include "../memory/pmm.h"
+#include "../memory/heap.h"
+#include "../lib/string.h"
+
+#define AP_START_TIMEOUT_US 100000
+
+// Layout of the parameter block at the end of trampoline.asm
+typedef struct {
+    uint32_t cr3;
+    uint32_t cr4;
+    uint32_t stack;
+    uint32_t entry;
+    uint32_t cpu_index;
+} __attribute__((packed)) ap_params_t;
+
+extern uint8_t ap_trampoline_start[];
+extern uint8_t ap_trampoline_params[];
+extern uint8_t ap_trampoline_end[];
+
+cpu_t cpus[MAX_CPUS];
+static uint32_t cpu_count = 1; // The BSP
+
+// --- Internal Helper Functions ---
+
+// First C code an AP runs, on the stack smp_init() gave it.
+static void ap_main(uint32_t cpu_index) {
+    gdt_load_cpu(cpu_index);
+    fpu_init_cpu();
+    idt_load_cpu();
+    lapic_init_ap();
+    syscall_init_cpu();
+    sched_init();
+
+    cpus[cpu_index].online = true;
+    lapic_timer_start();
+    asm volatile("sti");
+    cpu_idle();
+}
+
+// --- Public API Functions ---
+
+void smp_init(void) {
+    const acpi_madt_info_t* madt = acpi_get_madt();
+    if (madt == NULL || !lapic_is_enabled()) {
+        return; // Uniprocessor
+    }
+
+    cpus[0].apic_id = lapic_get_id();
+
+    uint32_t size = ap_trampoline_end - ap_trampoline_start;
+    memcpy((void*)AP_TRAMPOLINE_ADDR, ap_trampoline_start, size);
+    ap_params_t* params = (ap_params_t*)(AP_TRAMPOLINE_ADDR + (ap_trampoline_params - ap_trampoline_start));
+
+    for (uint32_t i = 0; i < madt->cpu_count && cpu_count < MAX_CPUS; i++) {
+        uint8_t apic_id = madt->cpus[i].apic_id;
+        if (apic_id == cpus[0].apic_id) {
+            continue;
+        }
+
+        // The AP's boot stack becomes its idle thread's stack for good
+        void* stack = malloc(THREAD_STACK_SIZE);
+        if (stack == NULL) {
+            break;
+        }
+
+        cpu_t* cpu = &cpus[cpu_count];
+        cpu->index = cpu_count;
+        cpu->apic_id = apic_id;
+
+        params->cr3 = paging_get_directory();
+        params->cr4 = read_cr4();
+        params->stack = (uint32_t)stack + THREAD_STACK_SIZE;
+        params->entry = (uint32_t)ap_main;
+        params->cpu_index = cpu_count;
+
+        lapic_start_ap(apic_id, AP_TRAMPOLINE_ADDR);
+        for (uint32_t waited = 0; !cpu->online && waited < AP_START_TIMEOUT_US; waited += 100) {
+            timer_udelay(100);
+        }
+
+        if (!cpu->online) {
+            // Keep the stack and stop here: a late AP may still come up
+            // using this slot, so it can't be handed to the next one.
+            terminal_printf("SMP: CPU with APIC ID %d did not start.\n", FG_YELLOW, apic_id);
+            break;
+        }
+        cpu_count++;
+    }
+}
+
+uint32_t smp_cpu_count(void) {
+    return cpu_count;
+}
+
+void cpu_idle(void) {
+    sched_cpu_t* sc = &this_cpu()->sched;
+    bool use_mwait = cpu_has(CPU_FEATURE_MONITOR);
+
+    for (;;) {
+        // Use idle time to pre-zero pages; sleep once the pool is full
+        if (pmm_zero_pool_refill()) {
+            continue;
+        }
+
+        // With interrupts off, nothing can queue work between the check
+        // and the wait without also ending it
+        asm volatile("cli");
+        if (sc->need_resched) {
+            asm volatile("sti");
+        } else if (use_mwait) {
+            // Watch need_resched itself, so a remote wakeup can skip the
+            // IPI (see sched_kick) and just store to it
+            sc->polling = true;
+            __sync_synchronize();
+            monitor(&sc->need_resched);
+            if (!sc->need_resched) {
+                sti_mwait();
+            } else {
+                asm volatile("sti");
+            }
+            sc->polling = false;
+        } else {
+            sti_hlt();
+        }
+
+        // An interrupt reschedules on its way out; a store to the
+        // monitored line wakes us with no interrupt, so switch here
+        if (sc->need_resched) {
+            thread_yield();
+        }
+    }
+}
@@ -0,0 +1,42 @@
+#ifndef SMP_H
+#define SMP_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "sched.h"
+
+// --- Per-CPU Data and AP Bring-up ---
+
+#define MAX_CPUS 8
+
+// Physical page the APs start executing in (real mode, below 1 MiB)
+#define AP_TRAMPOLINE_ADDR 0x8000
+
+typedef struct cpu {
+    struct cpu* self;        // What %gs:0 reads; must stay first
+    uint32_t index;          // Position in cpus[]; CPU 0 is the BSP
+    uint32_t apic_id;
+    volatile bool online;
+    struct thread* fpu_owner; // Thread whose FPU state is in the registers (fpu.h)
+    sched_cpu_t sched;
+} cpu_t;
+
+extern cpu_t cpus[MAX_CPUS];
+
+// The calling CPU's data, through its GS segment (see gdt.h).
+static inline cpu_t* this_cpu(void) {
+    cpu_t* cpu;
+    asm volatile("mov %%gs:0, %0" : "=r"(cpu));
+    return cpu;
+}
+
+// Starts every AP listed in the MADT. Needs ACPI and the LAPIC.
+void smp_init(void);
+
+// Number of CPUs that are up, including the BSP.
+uint32_t smp_cpu_count(void);
+
+// Body of every CPU's idle thread.
+void cpu_idle(void) __attribute__((noreturn));
+
+#endif // SMP_H
@@ -0,0 +1,30 @@
+#ifndef SPINLOCK_H
+#define SPINLOCK_H
+
+#include <stdint.h>
+#include "cpu.h"
+
+// Test-and-test-and-set spinlock. Interrupts are disabled while it is held
+// so an IRQ on the same CPU can never spin on a lock its own CPU holds.
+typedef struct {
+    volatile uint32_t locked;
+} spinlock_t;
+
+#define SPINLOCK_INIT { 0 }
+
+static inline uint32_t spin_lock_irqsave(spinlock_t* lock) {
+    uint32_t flags = irq_save();
+    while (__sync_lock_test_and_set(&lock->locked, 1)) {
+        while (lock->locked) {
+            asm volatile("pause");
+        }
+    }
+    return flags;
+}
+
+static inline void spin_unlock_irqrestore(spinlock_t* lock, uint32_t flags) {
+    __sync_lock_release(&lock->locked);
+    irq_restore(flags);
+}
+
+#endif // SPINLOCK_H
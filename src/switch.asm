@@ -0,0 +1,26 @@
+; =========================================================================
+;           switch.asm - Kernel Thread Context Switch
+; =========================================================================
+
+; void switch_context(uint32_t* old_esp, uint32_t new_esp)
+; Saves the callee-saved registers on the current stack, stores the stack
+; pointer in *old_esp and resumes the thread whose stack is at new_esp.
+; Everything else was already saved by the C caller (cdecl).
+global switch_context
+switch_context:
+    mov eax, [esp + 4]  ; old_esp
+    mov edx, [esp + 8]  ; new_esp
+
+    push ebp
+    push ebx
+    push esi
+    push edi
+
+    mov [eax], esp
+    mov esp, edx
+
+    pop edi
+    pop esi
+    pop ebx
+    pop ebp
+    ret                 ; Into the new thread's switch_context caller
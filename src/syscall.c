@@ -1,60 +1,115 @@
 #include "syscall.h"
-#include "../shell/shell.h" // Or header for your shell/longjmp checkpoint
+#include "../shell/shell.h" // For the current directory
 #include "../drivers/terminal.h"
 #include "../drivers/keyboard.h"
 #include "../user/lib/syscall_numbers.h"
 #include "../fs/fat32.h"
+#include "../memory/heap.h"
+#include "../memory/mmap.h"
+#include "../fs/pagecache.h"
+#include "../drivers/timer.h"
+#include "../lib/math.h"
+#include "cpu.h"
+#include "cpu_features.h"
+#include "gdt.h"
+#include "ring.h"
+#include "process.h"
+#include "trace.h"
+
+static int kernel_sys_exit(uint32_t status, uint32_t a2, uint32_t a3);
+static int kernel_sys_write(uint32_t fd, uint32_t buf, uint32_t count);
+static int kernel_sys_open(uint32_t name, uint32_t a2, uint32_t a3);
+static int kernel_sys_read(uint32_t fd, uint32_t buf, uint32_t count);
+static int kernel_sys_clear_screen(uint32_t a1, uint32_t a2, uint32_t a3);
+static int kernel_sys_set_cursor(uint32_t x, uint32_t y, uint32_t a3);
+static int kernel_sys_get_key(uint32_t a1, uint32_t a2, uint32_t a3);
+static int kernel_sys_mmap(uint32_t fd, uint32_t offset, uint32_t length);
+static int kernel_sys_munmap(uint32_t addr, uint32_t a2, uint32_t a3);
+static int kernel_sys_msync(uint32_t addr, uint32_t length, uint32_t a3);
+static int kernel_sys_clock_gettime(uint32_t clock_id, uint32_t ts, uint32_t a3);
+
+// Indexed by syscall number. Both entry paths (int 0x80 and SYSENTER)
+// dispatch through it; empty slots are unknown syscalls.
+const syscall_fn_t syscall_table[SYSCALL_TABLE_SIZE] = {
+    [SYS_EXIT]          = kernel_sys_exit,
+    [SYS_READ]          = kernel_sys_read,
+    [SYS_WRITE]         = kernel_sys_write,
+    [SYS_OPEN]          = kernel_sys_open,
+    [SYS_CLEAR_SCREEN]  = kernel_sys_clear_screen,
+    [SYS_SET_CURSOR]    = kernel_sys_set_cursor,
+    [SYS_GET_KEY]       = kernel_sys_get_key,
+    [SYS_MMAP]          = kernel_sys_mmap,
+    [SYS_MUNMAP]        = kernel_sys_munmap,
+    [SYS_MSYNC]         = kernel_sys_msync,
+    [SYS_CLOCK_GETTIME] = kernel_sys_clock_gettime,
+    [SYS_RING_SETUP]    = ring_setup,
+    [SYS_ENTER_RING]    = ring_enter,
+};
+const uint32_t syscall_table_size = SYSCALL_TABLE_SIZE;
+
+extern void sysenter_entry(void);
+
+// Sets up the calling CPU's SYSENTER MSRs, if it has them.
+void syscall_init_cpu(void) {
+    if (!cpu_has(CPU_FEATURE_SEP)) {
+        return;
+    }
+    // Early Pentium Pros set the bit without really supporting it
+    const cpu_info_t* info = cpu_get_info();
+    if (info->family == 6 && info->model < 3 && info->stepping < 3) {
+        return;
+    }
 
-static int kernel_sys_write(registers_t* regs);
-static int kernel_sys_open(registers_t* regs);
-static int kernel_sys_read(registers_t* regs);
-static void kernel_sys_clear_screen(void);
-static void kernel_sys_set_cursor(registers_t* regs);
-// Final handler for write (syscall 4) and exit (syscall 1)
-void syscall_handler(registers_t* regs) {
-    switch (regs->eax) {
-        case SYS_EXIT: { // Syscall 1: exit
-            // Jump back to the shell's main loop to terminate the program
-            longjmp(g_shell_checkpoint, 1);
-            break;
-        }
+    // SYSENTER_CS also fixes the SYSEXIT segments: user code/data follow
+    // the kernel's in the GDT
+    wrmsr(MSR_SYSENTER_CS, GDT_KERNEL_CODE);
+    wrmsr(MSR_SYSENTER_ESP, gdt_sysenter_stack());
+    wrmsr(MSR_SYSENTER_EIP, (uint32_t)sysenter_entry);
+}
 
-        case SYS_WRITE: { // NEW CASE
-            int bytes_written = kernel_sys_write(regs);
-            regs->eax = bytes_written; // Put the return value back in EAX
-            break;
-        }
+// Called for a syscall number with no table entry. Never returns.
+void syscall_unknown(uint32_t number) {
+    terminal_printf("Unknown syscall: %d\n", FG_RED, number);
+    process_exit(-1); // Terminate on unknown syscall
+}
 
-        case SYS_OPEN: {
-            regs->eax = kernel_sys_open(regs); // Put return value in EAX
-            break;
-        }
-        case SYS_READ: {
-            regs->eax = kernel_sys_read(regs); // Put return value in EAX
-            break;
-        }
-        case SYS_CLEAR_SCREEN:
-            kernel_sys_clear_screen();
-            break;
-        case SYS_SET_CURSOR:
-            kernel_sys_set_cursor(regs);
-            break;
-        default:
-            terminal_printf("Unknown syscall: %d\n", FG_RED, regs->eax);
-            longjmp(g_shell_checkpoint, 1); // Terminate on unknown syscall
-            break;
+int syscall_traced(uint32_t number, uint32_t a1, uint32_t a2, uint32_t a3) {
+    TRACE(TRACE_SYSCALL_ENTER, number, a1, a2, a3);
+    int result = syscall_table[number](a1, a2, a3);
+    TRACE(TRACE_SYSCALL_EXIT, number, result, 0, 0);
+    return result;
+}
+
+// Entry from 'int 0x80'
+void syscall_handler(registers_t* regs) {
+    // The int 0x80 gate clears IF; like SYSENTER, run the call with it set
+    // so it can be preempted and sleep while it waits
+    asm volatile("sti");
+    if (regs->eax >= SYSCALL_TABLE_SIZE || syscall_table[regs->eax] == NULL) {
+        syscall_unknown(regs->eax);
+    }
+    if (trace_enabled) {
+        regs->eax = syscall_traced(regs->eax, regs->ebx, regs->ecx, regs->edx);
+    } else {
+        regs->eax = syscall_table[regs->eax](regs->ebx, regs->ecx, regs->edx);
     }
 }
 
+static int kernel_sys_exit(uint32_t status, uint32_t a2, uint32_t a3) {
+    (void)a2; (void)a3; // Unused
+    // Free the program's memory and end its thread; the shell picks up from there
+    process_exit((int)status);
+}
+
 // This is the kernel's internal function for writing.
 // It returns the number of bytes written.
-static int kernel_sys_write(registers_t* regs) {
-    int fd = regs->ebx;             // File descriptor
-    const char* buffer = (const char*)regs->ecx; // Pointer to user's data
-    size_t count = regs->edx;       // How many bytes to write
+static int kernel_sys_write(uint32_t fd, uint32_t buf, uint32_t count) {
+    const char* buffer = (const char*)buf; // Pointer to user's data
 
     // For now, we only handle fd 1, which is standard output (the screen).
-    // A real OS would check permissions and that the user buffer is valid.
+    if (!process_user_range_ok(buf, count)) {
+        return -1; // Not the program's memory
+    }
     if (fd == 1) {
         for (size_t i = 0; i < count; i++) {
             terminal_putchar(buffer[i], FG_WHITE);
@@ -66,13 +121,22 @@ static int kernel_sys_write(registers_t* regs) {
     return -1; // Return -1 for an error (e.g., bad file descriptor)
 }
 
+#define OPEN_NAME_MAX 64 // Including the NUL; 8.3 names need 13
+
 // Kernel-side implementation for 'open'
-static int kernel_sys_open(registers_t* regs) {
-    const char* filename = (const char*)regs->ebx;
+static int kernel_sys_open(uint32_t name, uint32_t a2, uint32_t a3) {
+    (void)a2; (void)a3; // Unused
+    // The FAT32 code reads the name to its end, so it gets a kernel copy
+    char filename[OPEN_NAME_MAX];
+    if (!process_copy_string(filename, name, sizeof(filename))) {
+        return -1;
+    }
 
     // For now, we'll just find the file. A real OS would create a file
     // descriptor and track open files in a table.
+    mutex_lock(&fs_lock); // A ring worker may be using the disk too
     FAT32_DirectoryEntry* file = fat32_find_entry(filename, g_current_directory_cluster);
+    mutex_unlock(&fs_lock);
 
     if (file == NULL) {
         return -1; // Return -1 for "file not found"
@@ -86,32 +150,94 @@ static int kernel_sys_open(registers_t* regs) {
 }
 
 // Kernel-side implementation for 'read'
-static int kernel_sys_read(registers_t* regs) {
-    int fd = regs->ebx;
-    void* buffer = (void*)regs->ecx;
-    size_t count = regs->edx;
+static int kernel_sys_read(uint32_t fd, uint32_t buf, uint32_t count) {
+    void* buffer = (void*)buf;
+    if (!process_user_range_ok(buf, count)) {
+        return -1;
+    }
 
     // We no longer handle stdin (fd=0) for now.
     // This is just for reading from files.
+    mutex_lock(&fs_lock);
     FAT32_DirectoryEntry* file = fat32_find_entry_by_cluster(fd);
     if (file == NULL) {
+        mutex_unlock(&fs_lock);
         return -1;
     }
 
-    if (count > file->file_size) {
-        count = file->file_size;
-    }
-
-    fat32_read_file(file, buffer);
-    return count;
+    // Only copy what was asked for, straight out of the page cache
+    uint32_t bytes_read = pagecache_read(fd, file->file_size, 0, buffer, count);
+    mutex_unlock(&fs_lock);
+    free(file);
+    return bytes_read;
 }
 
-static void kernel_sys_clear_screen(void) {
+static int kernel_sys_clear_screen(uint32_t a1, uint32_t a2, uint32_t a3) {
+    (void)a1; (void)a2; (void)a3; // Unused
     terminal_initialize(); // Your existing function to clear the screen
+    return 0;
 }
 
-static void kernel_sys_set_cursor(registers_t* regs) {
-    int x = regs->ebx;
-    int y = regs->ecx;
+static int kernel_sys_set_cursor(uint32_t x, uint32_t y, uint32_t a3) {
+    (void)a3; // Unused
     terminal_set_cursor(x, y); // Your existing function to move the cursor
+    return 0;
+}
+
+static int kernel_sys_get_key(uint32_t a1, uint32_t a2, uint32_t a3) {
+    (void)a1; (void)a2; (void)a3; // Unused
+    return keyboard_get_key(); // Blocks until a key is typed
+}
+
+// Kernel-side implementation for 'mmap'
+// Returns the mapped address, or 0 on failure.
+static int kernel_sys_mmap(uint32_t fd, uint32_t offset, uint32_t length) {
+    mutex_lock(&fs_lock);
+
+    // fd -1 asks for zero-filled anonymous memory instead of a file
+    uint32_t addr = 0;
+    if ((int)fd == -1) {
+        addr = mmap_anonymous(length);
+    } else {
+        // Like 'read', the fd is the file's starting cluster
+        FAT32_DirectoryEntry* file = fat32_find_entry_by_cluster(fd);
+        if (file != NULL) {
+            addr = mmap_file(fd, file->file_size, offset, length);
+            free(file);
+        }
+    }
+
+    mutex_unlock(&fs_lock);
+    return addr;
+}
+
+static int kernel_sys_munmap(uint32_t addr, uint32_t a2, uint32_t a3) {
+    (void)a2; (void)a3; // Unused
+    mutex_lock(&fs_lock);
+    bool ok = mmap_unmap_user(addr);
+    mutex_unlock(&fs_lock);
+    return ok ? 0 : -1;
+}
+
+static int kernel_sys_msync(uint32_t addr, uint32_t length, uint32_t a3) {
+    (void)a3; // Unused
+    mutex_lock(&fs_lock);
+    bool ok = mmap_sync(addr, length);
+    mutex_unlock(&fs_lock);
+    return ok ? 0 : -1;
+}
+
+// Kernel-side implementation for 'clock_gettime'
+static int kernel_sys_clock_gettime(uint32_t clock_id, uint32_t ts_addr, uint32_t a3) {
+    (void)a3; // Unused
+    uint32_t* ts = (uint32_t*)ts_addr; // struct timespec { tv_sec; tv_nsec; }
+
+    if (clock_id != CLOCK_MONOTONIC || !process_user_range_ok(ts_addr, 2 * sizeof(uint32_t))) {
+        return -1;
+    }
+
+    uint32_t nsec;
+    ts[0] = (uint32_t)div_u64_rem(ktime_ns(), NSEC_PER_SEC, &nsec);
+    ts[1] = nsec;
+    return 0;
 }
@@ -9,5 +9,24 @@
 #define SYS_OPEN    5 // And this one too
 #define SYS_GET_KEY 12
 
+// Highest syscall number + 1 (SYS_ENTER_RING is 426)
+#define SYSCALL_TABLE_SIZE 427
+
+// Every syscall takes up to three arguments (ebx, ecx, edx for int 0x80;
+// ebx, esi, edi for SYSENTER) and returns its result in eax.
+typedef int (*syscall_fn_t)(uint32_t a1, uint32_t a2, uint32_t a3);
+
+extern const syscall_fn_t syscall_table[SYSCALL_TABLE_SIZE];
+
+// Enables the SYSENTER fast path on the calling CPU when it supports it.
+void syscall_init_cpu(void);
+
 void syscall_handler(registers_t* regs);
+
+// Runs syscall 'number', which must exist, between two tracepoints. Both
+// entry paths go through here instead of the table while tracing is on.
+int syscall_traced(uint32_t number, uint32_t a1, uint32_t a2, uint32_t a3);
+
+// Ends the program that made an unknown syscall.
+void syscall_unknown(uint32_t number) __attribute__((noreturn));
 #endif
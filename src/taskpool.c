@@ -0,0 +1,243 @@
+#include "taskpool.h"
+#include "sched.h"
+#include "smp.h"
+#include "../drivers/terminal.h"
+#include "../memory/heap.h"
+
+typedef struct {
+    spinlock_t lock;
+    task_t* tasks[TASKPOOL_DEQUE_SIZE];
+    uint32_t top;            // Oldest task; thieves take from here
+    uint32_t bottom;         // Next free slot; the owner pushes and pops here
+} task_deque_t;
+
+typedef struct {
+    thread_t* thread;
+    volatile uint32_t sleeping;
+} task_worker_t;
+
+// One parallel_for() chunk
+typedef struct {
+    task_t task;
+    uint32_t start;
+    uint32_t end;
+    void (*fn)(uint32_t, uint32_t, void*);
+    void* arg;
+} range_task_t;
+
+static task_deque_t deques[MAX_CPUS];
+static task_worker_t workers[MAX_CPUS];
+static uint32_t worker_count = 0;
+
+// --- Internal Helper Functions ---
+
+static bool deque_push(task_deque_t* deque, task_t* task) {
+    bool pushed = false;
+    uint32_t flags = spin_lock_irqsave(&deque->lock);
+    if (deque->bottom - deque->top < TASKPOOL_DEQUE_SIZE) {
+        deque->tasks[deque->bottom % TASKPOOL_DEQUE_SIZE] = task;
+        deque->bottom++;
+        pushed = true;
+    }
+    spin_unlock_irqrestore(&deque->lock, flags);
+    return pushed;
+}
+
+static task_t* deque_pop(task_deque_t* deque) {
+    task_t* task = NULL;
+    uint32_t flags = spin_lock_irqsave(&deque->lock);
+    if (deque->bottom != deque->top) {
+        deque->bottom--;
+        task = deque->tasks[deque->bottom % TASKPOOL_DEQUE_SIZE];
+    }
+    spin_unlock_irqrestore(&deque->lock, flags);
+    return task;
+}
+
+static task_t* deque_steal(task_deque_t* deque) {
+    task_t* task = NULL;
+    uint32_t flags = spin_lock_irqsave(&deque->lock);
+    if (deque->bottom != deque->top) {
+        task = deque->tasks[deque->top % TASKPOOL_DEQUE_SIZE];
+        deque->top++;
+    }
+    spin_unlock_irqrestore(&deque->lock, flags);
+    return task;
+}
+
+// Takes the newest task from this CPU's deque, or steals the oldest one
+// from the next CPU that has any.
+static task_t* task_find(void) {
+    uint32_t self = this_cpu()->index;
+    uint32_t count = smp_cpu_count();
+
+    task_t* task = deque_pop(&deques[self]);
+    for (uint32_t i = 1; task == NULL && i < count; i++) {
+        task = deque_steal(&deques[(self + i) % count]);
+    }
+    return task;
+}
+
+static void task_run(task_t* task) {
+    task_group_t* group = task->group;
+    task->fn(task->arg);
+
+    // The waiter can only return after taking the lock, so the group stays
+    // valid until it is released here.
+    uint32_t flags = spin_lock_irqsave(&group->lock);
+    if (--group->pending == 0 && group->waiter != NULL) {
+        thread_unblock(group->waiter);
+    }
+    spin_unlock_irqrestore(&group->lock, flags);
+}
+
+// Wakes one sleeping worker, trying other CPUs before our own: the
+// spawning thread will work through the local deque when it waits.
+static void task_wake_worker(void) {
+    // Order the deque push before the 'sleeping' reads (see task_worker)
+    __sync_synchronize();
+
+    uint32_t self = this_cpu()->index;
+    for (uint32_t i = 1; i <= worker_count; i++) {
+        task_worker_t* worker = &workers[(self + i) % worker_count];
+        if (__sync_bool_compare_and_swap(&worker->sleeping, 1, 0)) {
+            thread_unblock(worker->thread);
+            return;
+        }
+    }
+}
+
+static void task_worker(void* arg) {
+    task_worker_t* worker = arg;
+    for (;;) {
+        task_t* task = task_find();
+        if (task != NULL) {
+            task_run(task);
+            continue;
+        }
+
+        // Announce that we're going to sleep, then look once more so a
+        // task pushed in between is either seen here or wakes us up
+        worker->sleeping = 1;
+        __sync_synchronize();
+        task = task_find();
+        if (task != NULL) {
+            worker->sleeping = 0;
+            task_run(task);
+            continue;
+        }
+        thread_block();
+        worker->sleeping = 0;
+    }
+}
+
+static void range_task_run(void* arg) {
+    range_task_t* range = arg;
+    range->fn(range->start, range->end, range->arg);
+}
+
+// --- Public API Functions ---
+
+void taskpool_init(void) {
+    uint32_t count = smp_cpu_count();
+    for (uint32_t i = 0; i < count; i++) {
+        task_worker_t* worker = &workers[worker_count];
+        worker->sleeping = 0;
+        worker->thread = thread_create_on(i, "worker", task_worker, worker, SCHED_PRIO_NORMAL);
+        if (worker->thread == NULL) {
+            terminal_printf("Task pool: no worker for CPU %d.\n", FG_YELLOW, i);
+            break;
+        }
+        worker_count++;
+    }
+}
+
+uint32_t taskpool_worker_count(void) {
+    return worker_count;
+}
+
+void task_group_init(task_group_t* group) {
+    group->lock = (spinlock_t)SPINLOCK_INIT;
+    group->pending = 0;
+    group->waiter = NULL;
+}
+
+void task_spawn(task_group_t* group, task_t* task, void (*fn)(void*), void* arg) {
+    task->fn = fn;
+    task->arg = arg;
+    task->group = group;
+
+    uint32_t flags = spin_lock_irqsave(&group->lock);
+    group->pending++;
+    spin_unlock_irqrestore(&group->lock, flags);
+
+    if (!deque_push(&deques[this_cpu()->index], task)) {
+        task_run(task); // Deque full: no point queueing more
+        return;
+    }
+    task_wake_worker();
+}
+
+void task_group_wait(task_group_t* group) {
+    for (;;) {
+        uint32_t flags = spin_lock_irqsave(&group->lock);
+        if (group->pending == 0) {
+            group->waiter = NULL;
+            spin_unlock_irqrestore(&group->lock, flags);
+            return;
+        }
+        spin_unlock_irqrestore(&group->lock, flags);
+
+        // Help out rather than sleep while anything is queued anywhere
+        task_t* task = task_find();
+        if (task != NULL) {
+            task_run(task);
+            continue;
+        }
+
+        // What's left is running on other CPUs
+        flags = spin_lock_irqsave(&group->lock);
+        bool done = group->pending == 0;
+        if (!done) {
+            group->waiter = thread_current();
+        }
+        spin_unlock_irqrestore(&group->lock, flags);
+        if (!done) {
+            thread_block();
+        }
+    }
+}
+
+void parallel_for(uint32_t start, uint32_t end, uint32_t chunk,
+                  void (*fn)(uint32_t chunk_start, uint32_t chunk_end, void* arg), void* arg) {
+    if (start >= end) {
+        return;
+    }
+    uint32_t length = end - start;
+    if (chunk == 0 || chunk > length) {
+        chunk = length;
+    }
+
+    uint32_t count = (length + chunk - 1) / chunk;
+    range_task_t* ranges = (count > 1) ? malloc(count * sizeof(range_task_t)) : NULL;
+    if (ranges == NULL) {
+        fn(start, end, arg); // One chunk, or no memory to split it up
+        return;
+    }
+
+    task_group_t group;
+    task_group_init(&group);
+
+    // Queue the tail first so this CPU pops the chunks in order, while
+    // thieves take them from the far end
+    for (uint32_t i = count; i-- > 0;) {
+        range_task_t* range = &ranges[i];
+        range->start = start + i * chunk;
+        range->end = (i == count - 1) ? end : range->start + chunk;
+        range->fn = fn;
+        range->arg = arg;
+        task_spawn(&group, &range->task, range_task_run, range);
+    }
+    task_group_wait(&group);
+    free(ranges);
+}
@@ -0,0 +1,51 @@
+#ifndef TASKPOOL_H
+#define TASKPOOL_H
+
+#include <stdint.h>
+#include "spinlock.h"
+
+// --- Kernel Task Pool ---
+// Short, data-parallel kernel jobs spread over every CPU. Each CPU has a
+// deque of tasks: its owner pushes and pops at the bottom (newest first),
+// idle workers on other CPUs steal from the top (oldest first). A thread
+// waiting for its tasks runs queued tasks itself instead of sleeping, so
+// the pool also works, just serially, on a uniprocessor.
+//
+// Tasks run with interrupts on, in a worker or in a waiting thread. They
+// must not block on anything only the spawning thread can release.
+
+#define TASKPOOL_DEQUE_SIZE 256 // Per CPU; pushing to a full deque runs the task inline
+
+typedef struct task_group {
+    spinlock_t lock;
+    uint32_t pending;           // Spawned tasks not finished yet
+    struct thread* waiter;      // Thread sleeping in task_group_wait()
+} task_group_t;
+
+typedef struct task {
+    void (*fn)(void* arg);
+    void* arg;
+    task_group_t* group;
+} task_t;
+
+// Starts one worker thread per online CPU. Call after smp_init().
+void taskpool_init(void);
+
+uint32_t taskpool_worker_count(void);
+
+void task_group_init(task_group_t* group);
+
+// Queues fn(arg) as part of 'group'. The caller owns 'task' and must keep
+// it alive until task_group_wait() returns.
+void task_spawn(task_group_t* group, task_t* task, void (*fn)(void*), void* arg);
+
+// Returns once every task spawned in 'group' has finished, running queued
+// tasks on the calling thread in the meantime.
+void task_group_wait(task_group_t* group);
+
+// Calls fn(chunk_start, chunk_end, arg) over [start, end) split into
+// 'chunk'-sized pieces, in parallel, and returns when all are done.
+void parallel_for(uint32_t start, uint32_t end, uint32_t chunk,
+                  void (*fn)(uint32_t chunk_start, uint32_t chunk_end, void* arg), void* arg);
+
+#endif // TASKPOOL_H
@@ -0,0 +1,164 @@
+#include "trace.h"
+#include "cpu.h"
+#include "../drivers/timer.h"
+#include <stddef.h>
+
+typedef struct {
+    volatile uint32_t head;   // Slots handed out so far; only this CPU adds
+    uint32_t start;           // Where the records begin since trace_clear()
+    trace_record_t records[TRACE_RING_SIZE];
+} __attribute__((aligned(64))) trace_ring_t;
+
+typedef enum {
+    SLOT_OK,
+    SLOT_BUSY,                // Still being written
+    SLOT_GONE                 // Overwritten by a newer record
+} trace_slot_state_t;
+
+static const char* const event_names[TRACE_EVENT_COUNT] = {
+    [TRACE_NONE]                = "none",
+    [TRACE_IDE_READ]            = "ide_read",
+    [TRACE_IDE_READ_DONE]       = "ide_read_done",
+    [TRACE_IDE_WRITE]           = "ide_write",
+    [TRACE_IDE_WRITE_DONE]      = "ide_write_done",
+    [TRACE_FAT32_LOOKUP]        = "fat32_lookup",
+    [TRACE_FAT32_READ_PAGE]     = "fat32_read_page",
+    [TRACE_FAT32_WRITE_PAGE]    = "fat32_write_page",
+    [TRACE_FAT32_WRITE_FILE]    = "fat32_write_file",
+    [TRACE_FAT32_CREATE]        = "fat32_create",
+    [TRACE_FAT32_DELETE]        = "fat32_delete",
+    [TRACE_FAT32_ALLOC_CLUSTER] = "fat32_alloc_cluster",
+    [TRACE_HEAP_ALLOC]          = "heap_alloc",
+    [TRACE_HEAP_FREE]           = "heap_free",
+    [TRACE_PMM_ALLOC]           = "pmm_alloc",
+    [TRACE_PMM_FREE]            = "pmm_free",
+    [TRACE_PMM_RECLAIM]         = "pmm_reclaim",
+    [TRACE_SYSCALL_ENTER]       = "syscall_enter",
+    [TRACE_SYSCALL_EXIT]        = "syscall_exit",
+};
+
+volatile bool trace_enabled = false;
+static trace_ring_t trace_rings[MAX_CPUS];
+
+// --- Internal Helper Functions ---
+
+static inline uint64_t trace_clock(void) {
+    return (timer_get_tsc_khz() != 0) ? rdtsc() : ktime_ns();
+}
+
+// Copies out the record in slot 'pos', if it is complete and still the
+// one written for 'pos'.
+static trace_slot_state_t trace_read_slot(const trace_ring_t* ring, uint32_t pos, trace_record_t* out) {
+    const volatile trace_record_t* slot = &ring->records[pos % TRACE_RING_SIZE];
+    uint32_t seq = slot->seq;
+    asm volatile("" ::: "memory"); // x86 keeps loads in order; the compiler must too
+    out->time = slot->time;
+    out->event = slot->event;
+    out->thread = slot->thread;
+    for (int i = 0; i < 4; i++) {
+        out->args[i] = slot->args[i];
+    }
+    asm volatile("" ::: "memory");
+    if (slot->seq != seq) {
+        return (seq == pos + 1) ? SLOT_GONE : SLOT_BUSY;
+    }
+    if (seq == pos + 1) {
+        return SLOT_OK;
+    }
+    return (seq == 0) ? SLOT_BUSY : SLOT_GONE;
+}
+
+// --- Public API Functions ---
+
+void trace_write(uint16_t event, uint32_t a0, uint32_t a1, uint32_t a2, uint32_t a3) {
+    cpu_t* cpu = this_cpu();
+    trace_ring_t* ring = &trace_rings[cpu->index];
+    uint32_t pos = __sync_fetch_and_add(&ring->head, 1);
+    volatile trace_record_t* record = &ring->records[pos % TRACE_RING_SIZE];
+
+    record->seq = 0;
+    asm volatile("" ::: "memory"); // Stores become visible in program order on x86
+    record->time = trace_clock();
+    record->event = event;
+    record->thread = (cpu->sched.current != NULL) ? (uint16_t)cpu->sched.current->id : 0;
+    record->args[0] = a0;
+    record->args[1] = a1;
+    record->args[2] = a2;
+    record->args[3] = a3;
+    asm volatile("" ::: "memory");
+    record->seq = pos + 1;
+}
+
+void trace_set_enabled(bool enabled) {
+    trace_enabled = enabled;
+}
+
+void trace_clear(void) {
+    for (uint32_t cpu = 0; cpu < MAX_CPUS; cpu++) {
+        trace_rings[cpu].start = trace_rings[cpu].head;
+    }
+}
+
+uint32_t trace_clock_khz(void) {
+    uint32_t khz = timer_get_tsc_khz();
+    return (khz != 0) ? khz : 1000000;
+}
+
+const char* trace_event_name(uint16_t event) {
+    return (event < TRACE_EVENT_COUNT) ? event_names[event] : "unknown";
+}
+
+void trace_cursor_init(trace_cursor_t* cursor, bool from_start) {
+    for (uint32_t cpu = 0; cpu < MAX_CPUS; cpu++) {
+        const trace_ring_t* ring = &trace_rings[cpu];
+        uint32_t head = ring->head;
+        if (!from_start) {
+            cursor->next[cpu] = head;
+        } else if (head - ring->start > TRACE_RING_SIZE) {
+            cursor->next[cpu] = head - TRACE_RING_SIZE; // The start was overwritten
+        } else {
+            cursor->next[cpu] = ring->start;
+        }
+    }
+}
+
+uint32_t trace_read(trace_cursor_t* cursor, void (*emit)(uint32_t cpu, const trace_record_t* record, void* arg), void* arg) {
+    uint32_t end[MAX_CPUS];
+    uint32_t lost = 0;
+
+    // Only read up to where the rings are now, or a busy CPU could keep
+    // this going forever
+    for (uint32_t cpu = 0; cpu < MAX_CPUS; cpu++) {
+        end[cpu] = trace_rings[cpu].head;
+        if (end[cpu] - cursor->next[cpu] > TRACE_RING_SIZE) {
+            lost += end[cpu] - cursor->next[cpu] - TRACE_RING_SIZE;
+            cursor->next[cpu] = end[cpu] - TRACE_RING_SIZE;
+        }
+    }
+
+    for (;;) {
+        int best = -1;
+        trace_record_t best_record, record;
+        for (uint32_t cpu = 0; cpu < MAX_CPUS; cpu++) {
+            while (cursor->next[cpu] != end[cpu]) {
+                trace_slot_state_t state = trace_read_slot(&trace_rings[cpu], cursor->next[cpu], &record);
+                if (state == SLOT_GONE) {
+                    lost++;
+                    cursor->next[cpu]++;
+                    continue;
+                }
+                if (state == SLOT_OK && (best < 0 || record.time < best_record.time)) {
+                    best = cpu;
+                    best_record = record;
+                }
+                break; // A busy slot waits for the next read
+            }
+        }
+        if (best < 0) {
+            break;
+        }
+        emit(best, &best_record, arg);
+        cursor->next[best]++;
+    }
+    return lost;
+}
@@ -0,0 +1,92 @@
+#ifndef TRACE_H
+#define TRACE_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "smp.h"
+
+// --- Event Tracing ---
+// Every CPU has a ring of fixed-size binary records. Tracepoints write the
+// calling CPU's ring without locks and without turning interrupts off: a
+// slot is claimed with one atomic add, so an IRQ that traces in the middle
+// of another record just takes the next slot. A record's 'seq' is zeroed
+// before it is filled and set last, which lets readers on other CPUs skip
+// records that are being written or were overwritten while being read.
+//
+// Tracing is off until trace_set_enabled() (the 'trace' shell command, or
+// 'trace' on the kernel command line); a disabled tracepoint costs one
+// load and branch. When a ring is full the oldest records are overwritten.
+
+#define TRACE_RING_SIZE 1024 // Records per CPU; a power of two
+
+typedef enum {
+    TRACE_NONE,
+    TRACE_IDE_READ,           // lba, count
+    TRACE_IDE_READ_DONE,      // lba, count, ok
+    TRACE_IDE_WRITE,          // lba, count
+    TRACE_IDE_WRITE_DONE,     // lba, count, ok
+    TRACE_FAT32_LOOKUP,       // dir cluster, found, entry cluster
+    TRACE_FAT32_READ_PAGE,    // start cluster, page index, ok
+    TRACE_FAT32_WRITE_PAGE,   // start cluster, page index, ok
+    TRACE_FAT32_WRITE_FILE,   // old start cluster, size
+    TRACE_FAT32_CREATE,       // dir cluster
+    TRACE_FAT32_DELETE,       // dir cluster
+    TRACE_FAT32_ALLOC_CLUSTER, // cluster (0: disk full)
+    TRACE_HEAP_ALLOC,         // size, address
+    TRACE_HEAP_FREE,          // address
+    TRACE_PMM_ALLOC,          // address, from the zero pool
+    TRACE_PMM_FREE,           // address
+    TRACE_PMM_RECLAIM,        // target, freed
+    TRACE_SYSCALL_ENTER,      // number, arg1, arg2, arg3
+    TRACE_SYSCALL_EXIT,       // number, result
+    TRACE_EVENT_COUNT
+} trace_event_t;
+
+typedef struct {
+    uint64_t time;            // TSC, or nanoseconds without one (see trace_clock_khz())
+    uint32_t seq;             // Slot number + 1 once complete, 0 while being written
+    uint16_t event;           // trace_event_t
+    uint16_t thread;          // Low bits of the running thread's id
+    uint32_t args[4];
+} trace_record_t;
+
+// Where a reader has got to in each CPU's ring.
+typedef struct {
+    uint32_t next[MAX_CPUS];
+} trace_cursor_t;
+
+// Read by the TRACE() fast path (and by sysenter_entry)
+extern volatile bool trace_enabled;
+
+#define TRACE(event, a0, a1, a2, a3)                                          \
+    do {                                                                      \
+        if (trace_enabled) {                                                  \
+            trace_write((event), (uint32_t)(a0), (uint32_t)(a1),              \
+                        (uint32_t)(a2), (uint32_t)(a3));                      \
+        }                                                                     \
+    } while (0)
+
+// Appends a record to the calling CPU's ring. Safe from any context once
+// per-CPU data is set up (gdt_init()).
+void trace_write(uint16_t event, uint32_t a0, uint32_t a1, uint32_t a2, uint32_t a3);
+
+void trace_set_enabled(bool enabled);
+
+// Forgets every record.
+void trace_clear(void);
+
+// Ticks of the record timestamps per millisecond.
+uint32_t trace_clock_khz(void);
+
+const char* trace_event_name(uint16_t event);
+
+// Places a cursor at the oldest record still in the rings, or, with
+// 'from_start' false, after the newest so only later records are read.
+void trace_cursor_init(trace_cursor_t* cursor, bool from_start);
+
+// Passes each complete record after the cursor to 'emit', oldest first
+// with all CPUs merged by timestamp, and advances the cursor. Returns how
+// many records were overwritten before they could be read.
+uint32_t trace_read(trace_cursor_t* cursor, void (*emit)(uint32_t cpu, const trace_record_t* record, void* arg), void* arg);
+
+#endif // TRACE_H
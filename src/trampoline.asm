@@ -0,0 +1,77 @@
+; =========================================================================
+;           trampoline.asm - Application Processor Startup Code
+; =========================================================================
+; The SIPI starts each AP in real mode at AP_TRAMPOLINE_ADDR. smp_init()
+; copies this block there and fills in the parameters at the end; every
+; address below is computed relative to where the copy runs.
+
+%define TRAMPOLINE_BASE 0x8000      ; Must match AP_TRAMPOLINE_ADDR in smp.h
+%define REL(label) (TRAMPOLINE_BASE + (label) - ap_trampoline_start)
+
+global ap_trampoline_start
+global ap_trampoline_params
+global ap_trampoline_end
+
+section .text
+
+bits 16
+ap_trampoline_start:
+    cli
+    cld
+    xor ax, ax
+    mov ds, ax
+
+    ; Temporary flat GDT, just long enough to reach protected mode
+    lgdt [REL(tramp_gdt_ptr)]
+    mov eax, cr0
+    or eax, 1                       ; CR0.PE
+    mov cr0, eax
+    jmp dword 0x08:REL(ap_protected_entry)
+
+bits 32
+ap_protected_entry:
+    mov ax, 0x10
+    mov ds, ax
+    mov es, ax
+    mov fs, ax
+    mov gs, ax
+    mov ss, ax
+
+    ; Same page directory and paging features as the BSP
+    mov eax, [REL(param_cr4)]
+    mov cr4, eax
+    mov eax, [REL(param_cr3)]
+    mov cr3, eax
+    mov eax, cr0
+    or eax, 0x80010000              ; CR0.PG | CR0.WP
+    mov cr0, eax
+
+    ; Into the kernel proper on this AP's own stack: entry(cpu_index)
+    mov esp, [REL(param_stack)]
+    push dword [REL(param_cpu_index)]
+    mov eax, [REL(param_entry)]
+    call eax
+
+.halt:
+    cli
+    hlt
+    jmp .halt
+
+align 8
+tramp_gdt:
+    dq 0                            ; Null descriptor
+    dq 0x00CF9A000000FFFF           ; 0x08: flat 32-bit code
+    dq 0x00CF92000000FFFF           ; 0x10: flat data
+tramp_gdt_ptr:
+    dw tramp_gdt_ptr - tramp_gdt - 1
+    dd REL(tramp_gdt)
+
+; Filled in by smp_init() before each AP is started (ap_params_t)
+align 4
+ap_trampoline_params:
+param_cr3:       dd 0
+param_cr4:       dd 0
+param_stack:     dd 0
+param_entry:     dd 0
+param_cpu_index: dd 0
+ap_trampoline_end:
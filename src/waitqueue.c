@@ -0,0 +1,92 @@
+#include "waitqueue.h"
+#include "smp.h"
+#include "../drivers/timer.h"
+#include <stddef.h>
+
+// --- Internal Helper Functions ---
+
+// Caller holds the queue's lock.
+static void wait_queue_add(wait_queue_t* queue, thread_t* thread) {
+    thread->wait_next = NULL;
+    if (queue->tail != NULL) {
+        queue->tail->wait_next = thread;
+    } else {
+        queue->head = thread;
+    }
+    queue->tail = thread;
+}
+
+// Caller holds the queue's lock. Does nothing if the thread isn't queued.
+static void wait_queue_remove(wait_queue_t* queue, thread_t* thread) {
+    thread_t* prev = NULL;
+    for (thread_t* cur = queue->head; cur != NULL; prev = cur, cur = cur->wait_next) {
+        if (cur != thread) continue;
+        if (prev != NULL) {
+            prev->wait_next = cur->wait_next;
+        } else {
+            queue->head = cur->wait_next;
+        }
+        if (queue->tail == cur) {
+            queue->tail = prev;
+        }
+        return;
+    }
+}
+
+// --- Public API Functions ---
+
+bool wait_event(wait_queue_t* queue, bool (*cond)(void* arg), void* arg, uint32_t timeout_ms) {
+    thread_t* self = thread_current();
+    uint64_t deadline = timer_get_ticks() + (timeout_ms * TIMER_HZ + 999) / 1000;
+
+    for (;;) {
+        uint32_t flags = spin_lock_irqsave(&queue->lock);
+        if (cond(arg)) {
+            spin_unlock_irqrestore(&queue->lock, flags);
+            return true;
+        }
+        wait_queue_add(queue, self);
+        spin_unlock_irqrestore(&queue->lock, flags);
+
+        // A wake between the unlock and here leaves a pending wakeup, so
+        // blocking returns at once
+        bool woken = true;
+        if (timeout_ms == 0) {
+            thread_block();
+        } else {
+            uint64_t now = timer_get_ticks();
+            woken = now < deadline && thread_block_timeout((uint32_t)(deadline - now) * 1000 / TIMER_HZ);
+        }
+
+        // wait_queue_wake() dequeues whoever it wakes; anything else
+        // (a timeout, a spurious return) has to leave by itself
+        flags = spin_lock_irqsave(&queue->lock);
+        wait_queue_remove(queue, self);
+        bool done = cond(arg);
+        spin_unlock_irqrestore(&queue->lock, flags);
+
+        if (done) {
+            return true;
+        }
+        if (!woken) {
+            return false;
+        }
+    }
+}
+
+void wait_queue_wake(wait_queue_t* queue) {
+    uint32_t flags = spin_lock_irqsave(&queue->lock);
+    thread_t* thread = queue->head;
+    queue->head = NULL;
+    queue->tail = NULL;
+    while (thread != NULL) {
+        thread_t* next = thread->wait_next;
+        thread_unblock(thread);
+        thread = next;
+    }
+    spin_unlock_irqrestore(&queue->lock, flags);
+}
+
+bool wait_can_sleep(void) {
+    return irqs_enabled() && this_cpu()->sched.current != NULL;
+}
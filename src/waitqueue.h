@@ -0,0 +1,35 @@
+#ifndef WAITQUEUE_H
+#define WAITQUEUE_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "sched.h"
+
+// --- Wait Queues ---
+// Lets threads sleep until some condition holds, typically one an IRQ
+// handler makes true. The waker changes the state the condition reads and
+// then calls wait_queue_wake(); the condition is checked under the queue's
+// lock, so a wakeup can never slip in between the check and going to sleep.
+
+typedef struct {
+    spinlock_t lock;
+    thread_t* head;          // Linked through thread_t.wait_next
+    thread_t* tail;
+} wait_queue_t;
+
+#define WAIT_QUEUE_INIT { SPINLOCK_INIT, NULL, NULL }
+
+// Sleeps until cond(arg) returns true. 'timeout_ms' of 0 waits forever.
+// Returns false on timeout. 'cond' runs with interrupts off, so it should
+// only look at memory.
+bool wait_event(wait_queue_t* queue, bool (*cond)(void* arg), void* arg, uint32_t timeout_ms);
+
+// Wakes every waiter so each re-checks its condition. Safe from IRQs.
+void wait_queue_wake(wait_queue_t* queue);
+
+// True if the caller may sleep: the scheduler is up and interrupts are
+// enabled (so not in an IRQ handler or under a spinlock). Drivers that
+// can also run at boot or with interrupts off poll instead otherwise.
+bool wait_can_sleep(void);
+
+#endif // WAITQUEUE_H
@@ -0,0 +1,231 @@
+#include "host.h"
+#include "shim.h"
+#include "../../fs/fat32.h"
+#include "../../fs/dirscan.h"
+#include "../../memory/heap.h"
+#include "../../src/cpu_features.h"
+#include "../../lib/string.h"
+#include <stddef.h>
+
+// Runs the FAT32 driver, the heap and the string routines against a
+// freshly made FAT32 image (see 'make hostbench') and reports how fast
+// they are. The results are checked too; any mismatch fails the run.
+
+#define HEAP_BENCH_ROUNDS   200
+#define HEAP_BENCH_SLOTS    256  // Blocks live at once
+#define HEAP_BENCH_MAX_SIZE 1024
+
+#define DIR_BENCH_ENTRIES   10000
+#define DIR_BENCH_HITS      2000
+#define DIR_BENCH_MISSES    200
+
+#define FILE_BENCH_SIZE     (8 * 1024 * 1024)
+
+static uint8_t file_data[FILE_BENCH_SIZE];
+static uint8_t file_readback[FILE_BENCH_SIZE];
+static uint32_t rng_state = 0x12345678;
+static int failures = 0;
+
+// --- Internal Helper Functions ---
+
+// xorshift32: the same sequence on every run
+static uint32_t bench_random(void) {
+    rng_state ^= rng_state << 13;
+    rng_state ^= rng_state >> 17;
+    rng_state ^= rng_state << 5;
+    return rng_state;
+}
+
+static void bench_fail(const char* what, uint32_t value) {
+    host_printf("FAIL: %s (%u)\n", what, value);
+    failures++;
+}
+
+// 'count' operations in 'ns' nanoseconds, per second
+static uint32_t bench_rate(uint32_t count, uint64_t ns) {
+    return (ns == 0) ? 0 : (uint32_t)((uint64_t)count * 1000000000ull / ns);
+}
+
+static uint32_t bench_mb_per_sec(uint32_t bytes, uint64_t ns) {
+    return (ns == 0) ? 0 : (uint32_t)((uint64_t)bytes * 1000000000ull / ns / (1024 * 1024));
+}
+
+// "F00042.DAT"-style 8.3 names
+static void bench_file_name(char* out, uint32_t index) {
+    out[0] = 'F';
+    for (int digit = 5; digit >= 1; digit--) {
+        out[digit] = '0' + index % 10;
+        index /= 10;
+    }
+    strcpy(out + 6, ".DAT");
+}
+
+static uint32_t bench_entry_cluster(const FAT32_DirectoryEntry* entry) {
+    return ((uint32_t)entry->fst_clus_hi << 16) | entry->fst_clus_lo;
+}
+
+// Allocates and frees blocks of random sizes in random order, keeping
+// HEAP_BENCH_SLOTS alive, and checks no two live blocks overlap.
+static void bench_heap(void) {
+    static uint8_t* blocks[HEAP_BENCH_SLOTS];
+    static uint32_t sizes[HEAP_BENCH_SLOTS];
+    uint32_t ops = 0;
+
+    uint64_t start = host_time_ns();
+    for (uint32_t round = 0; round < HEAP_BENCH_ROUNDS; round++) {
+        for (uint32_t i = 0; i < HEAP_BENCH_SLOTS; i++) {
+            sizes[i] = 16 + bench_random() % HEAP_BENCH_MAX_SIZE;
+            blocks[i] = malloc(sizes[i]);
+            if (blocks[i] == NULL) {
+                bench_fail("malloc returned NULL", sizes[i]);
+                return;
+            }
+            blocks[i][0] = (uint8_t)i;
+            blocks[i][sizes[i] - 1] = (uint8_t)i;
+        }
+        for (uint32_t i = HEAP_BENCH_SLOTS; i > 1; i--) {
+            uint32_t j = bench_random() % i;
+            uint8_t* block = blocks[i - 1];
+            blocks[i - 1] = blocks[j];
+            blocks[j] = block;
+            uint32_t size = sizes[i - 1];
+            sizes[i - 1] = sizes[j];
+            sizes[j] = size;
+        }
+        for (uint32_t i = 0; i < HEAP_BENCH_SLOTS; i++) {
+            if (blocks[i][0] != blocks[i][sizes[i] - 1]) {
+                bench_fail("heap block overwritten", i);
+            }
+            free(blocks[i]);
+        }
+        ops += 2 * HEAP_BENCH_SLOTS;
+    }
+    uint64_t ns = host_time_ns() - start;
+    host_printf("heap:   %u malloc/free ops/sec (%u live blocks of 16-%u bytes)\n",
+                bench_rate(ops, ns), HEAP_BENCH_SLOTS, 16 + HEAP_BENCH_MAX_SIZE - 1);
+}
+
+// Fills one directory with DIR_BENCH_ENTRIES empty files, then looks up
+// random ones, and some names that aren't there (a full scan each).
+static void bench_directory(uint32_t root) {
+    FAT32_DirectoryEntry entry;
+    char name[16];
+
+    if (!fat32_create_directory("BENCH", root) || !fat32_find_entry_by_name("BENCH", root, NULL, &entry)) {
+        bench_fail("creating the BENCH directory", 0);
+        return;
+    }
+    uint32_t dir = bench_entry_cluster(&entry);
+
+    uint64_t start = host_time_ns();
+    for (uint32_t i = 0; i < DIR_BENCH_ENTRIES; i++) {
+        bench_file_name(name, i);
+        if (!fat32_create_file(name, dir, NULL)) {
+            bench_fail("fat32_create_file", i);
+            return;
+        }
+    }
+    uint64_t ns = host_time_ns() - start;
+    host_printf("create: %u files/sec (%u files in one directory)\n", bench_rate(DIR_BENCH_ENTRIES, ns), DIR_BENCH_ENTRIES);
+
+    start = host_time_ns();
+    for (uint32_t i = 0; i < DIR_BENCH_HITS; i++) {
+        uint32_t index = bench_random() % DIR_BENCH_ENTRIES;
+        bench_file_name(name, index);
+        if (!fat32_find_entry_by_name(name, dir, NULL, &entry) || strncmp(entry.name, name, 6) != 0) {
+            bench_fail("lookup missed an existing file", index);
+            return;
+        }
+    }
+    ns = host_time_ns() - start;
+    host_printf("lookup: %u ns per hit (%u entries)\n", (uint32_t)(ns / DIR_BENCH_HITS), DIR_BENCH_ENTRIES);
+
+    start = host_time_ns();
+    for (uint32_t i = 0; i < DIR_BENCH_MISSES; i++) {
+        bench_file_name(name, DIR_BENCH_ENTRIES + i);
+        if (fat32_find_entry_by_name(name, dir, NULL, NULL)) {
+            bench_fail("lookup found a file that doesn't exist", i);
+            return;
+        }
+    }
+    ns = host_time_ns() - start;
+    host_printf("lookup: %u ns per miss\n", (uint32_t)(ns / DIR_BENCH_MISSES));
+}
+
+// Writes one FILE_BENCH_SIZE file and reads it back.
+static void bench_file_io(uint32_t root) {
+    FAT32_DirectoryEntry entry;
+    dir_entry_location_t loc;
+
+    for (uint32_t i = 0; i < FILE_BENCH_SIZE; i += 4) {
+        *(uint32_t*)&file_data[i] = bench_random();
+    }
+    if (!fat32_create_file("BIG.DAT", root, NULL) || !fat32_find_entry_by_name("BIG.DAT", root, &loc, &entry)) {
+        bench_fail("creating BIG.DAT", 0);
+        return;
+    }
+
+    uint64_t start = host_time_ns();
+    if (!fat32_write_file(&entry, file_data, FILE_BENCH_SIZE) || !fat32_update_entry(&entry, &loc)) {
+        bench_fail("fat32_write_file", FILE_BENCH_SIZE);
+        return;
+    }
+    uint64_t ns = host_time_ns() - start;
+    host_printf("write:  %u MB/s (%u KiB file)\n", bench_mb_per_sec(FILE_BENCH_SIZE, ns), FILE_BENCH_SIZE / 1024);
+
+    if (!fat32_find_entry_by_name("BIG.DAT", root, NULL, &entry) || entry.file_size != FILE_BENCH_SIZE) {
+        bench_fail("BIG.DAT has the wrong size", entry.file_size);
+        return;
+    }
+    start = host_time_ns();
+    fat32_read_file(&entry, file_readback);
+    ns = host_time_ns() - start;
+    host_printf("read:   %u MB/s\n", bench_mb_per_sec(FILE_BENCH_SIZE, ns));
+
+    for (uint32_t i = 0; i < FILE_BENCH_SIZE; i++) {
+        if (file_readback[i] != file_data[i]) {
+            bench_fail("read back different data at offset", i);
+            return;
+        }
+    }
+}
+
+// --- Public API Functions ---
+
+int main(int argc, char* argv[]) {
+    if (argc != 2) {
+        host_printf("Usage: %s <fat32 image>\n", argv[0]);
+        return 2;
+    }
+    if (!shim_disk_open(argv[1])) {
+        host_printf("Cannot open %s\n", argv[1]);
+        return 2;
+    }
+
+    // The same start-up order as kmain
+    cpu_features_init();
+    heap_init();
+    string_init();
+    dirscan_init();
+    fat32_init();
+
+    const cpu_dispatch_t* d;
+    for (d = cpu_dispatch_list(); d != NULL; d = d->next) {
+        host_printf("using:  %s: %s\n", d->name, (d->chosen != NULL) ? d->chosen->name : "(default)");
+    }
+
+    bench_heap();
+    uint32_t root = fat32_get_root_cluster();
+    bench_directory(root);
+    bench_file_io(root);
+
+    shim_disk_stats_t stats = shim_disk_stats();
+    host_printf("disk:   %u reads (%u sectors), %u writes (%u sectors)\n",
+                stats.reads, stats.sectors_read, stats.writes, stats.sectors_written);
+
+    if (failures > 0) {
+        host_printf("%d check(s) failed\n", failures);
+        return 1;
+    }
+    return 0;
+}
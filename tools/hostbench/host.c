@@ -0,0 +1,151 @@
+#include "host.h"
+#include "../../lib/string.h"
+
+// i386 Linux system call numbers
+#define SYS_EXIT_GROUP     252
+#define SYS_WRITE          4
+#define SYS_OPEN           5
+#define SYS_PREAD64        180
+#define SYS_PWRITE64       181
+#define SYS_CLOCK_GETTIME  265
+
+#define O_RDWR             2
+#define CLOCK_MONOTONIC    1
+
+// The kernel hands _start argc, argv and envp on the stack. Realign it
+// for SSE before calling C.
+asm(".globl _start\n"
+    "_start:\n"
+    "    xor %ebp, %ebp\n"
+    "    mov %esp, %eax\n"
+    "    and $-16, %esp\n"
+    "    sub $12, %esp\n"
+    "    push %eax\n"
+    "    call host_start\n"
+    "    hlt\n");
+
+// --- Internal Helper Functions ---
+
+static inline int32_t host_syscall(uint32_t number, uint32_t a1, uint32_t a2, uint32_t a3) {
+    int32_t result;
+    asm volatile("int $0x80"
+                 : "=a"(result)
+                 : "a"(number), "b"(a1), "c"(a2), "d"(a3)
+                 : "memory");
+    return result;
+}
+
+// The fifth argument goes in EBP, which can't be named as an operand
+// while frame pointers are on.
+static inline int32_t host_syscall5(uint32_t number, uint32_t a1, uint32_t a2, uint32_t a3, uint32_t a4, uint32_t a5) {
+    int32_t result;
+    asm volatile("push %%ebp\n"
+                 "mov %%edi, %%ebp\n"
+                 "int $0x80\n"
+                 "pop %%ebp"
+                 : "=a"(result)
+                 : "a"(number), "b"(a1), "c"(a2), "d"(a3), "S"(a4), "D"(a5)
+                 : "memory");
+    return result;
+}
+
+static void host_put_number(int fd, uint32_t value, uint32_t base, bool negative) {
+    char buffer[12];
+    int pos = sizeof(buffer);
+    do {
+        buffer[--pos] = "0123456789abcdef"[value % base];
+        value /= base;
+    } while (value != 0);
+    if (negative) {
+        buffer[--pos] = '-';
+    }
+    host_write(fd, buffer + pos, sizeof(buffer) - pos);
+}
+
+// --- Public API Functions ---
+
+void host_start(uint32_t* stack) {
+    int argc = (int)stack[0];
+    char** argv = (char**)(stack + 1);
+    host_exit(main(argc, argv));
+}
+
+int host_open(const char* path) {
+    return host_syscall(SYS_OPEN, (uint32_t)path, O_RDWR, 0);
+}
+
+bool host_pread(int fd, void* buf, uint32_t len, uint64_t offset) {
+    int32_t result = host_syscall5(SYS_PREAD64, fd, (uint32_t)buf, len, (uint32_t)offset, (uint32_t)(offset >> 32));
+    return result == (int32_t)len;
+}
+
+bool host_pwrite(int fd, const void* buf, uint32_t len, uint64_t offset) {
+    int32_t result = host_syscall5(SYS_PWRITE64, fd, (uint32_t)buf, len, (uint32_t)offset, (uint32_t)(offset >> 32));
+    return result == (int32_t)len;
+}
+
+void host_write(int fd, const char* data, uint32_t len) {
+    host_syscall(SYS_WRITE, fd, (uint32_t)data, len);
+}
+
+uint64_t host_time_ns(void) {
+    struct { int32_t sec; int32_t nsec; } ts;
+    host_syscall(SYS_CLOCK_GETTIME, CLOCK_MONOTONIC, (uint32_t)&ts, 0);
+    return (uint64_t)ts.sec * 1000000000ull + ts.nsec;
+}
+
+void host_exit(int code) {
+    host_syscall(SYS_EXIT_GROUP, code, 0, 0);
+    for (;;) {
+    }
+}
+
+void host_vprintf(int fd, const char* format, va_list args) {
+    const char* run = format;
+    for (const char* p = format; *p != '\0'; p++) {
+        if (*p != '%') {
+            continue;
+        }
+        host_write(fd, run, p - run);
+        p++;
+        if (*p == '\0') {
+            run = p;
+            break;
+        }
+        switch (*p) {
+            case 'c': {
+                char c = (char)va_arg(args, int);
+                host_write(fd, &c, 1);
+                break;
+            }
+            case 's': {
+                const char* s = va_arg(args, const char*);
+                host_write(fd, s, strlen(s));
+                break;
+            }
+            case 'd': {
+                int value = va_arg(args, int);
+                host_put_number(fd, (value < 0) ? -(uint32_t)value : (uint32_t)value, 10, value < 0);
+                break;
+            }
+            case 'u':
+                host_put_number(fd, va_arg(args, uint32_t), 10, false);
+                break;
+            case 'x':
+                host_put_number(fd, va_arg(args, uint32_t), 16, false);
+                break;
+            default:
+                host_write(fd, p - 1, 2);
+                break;
+        }
+        run = p + 1;
+    }
+    host_write(fd, run, strlen(run));
+}
+
+void host_printf(const char* format, ...) {
+    va_list args;
+    va_start(args, format);
+    host_vprintf(HOST_STDOUT, format, args);
+    va_end(args);
+}
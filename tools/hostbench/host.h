@@ -0,0 +1,37 @@
+#ifndef HOSTBENCH_HOST_H
+#define HOSTBENCH_HOST_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stdarg.h>
+
+// --- Host Runtime ---
+// The harness runs fs/, memory/ and lib/ code as an i386 Linux program.
+// It links no C library: the kernel's malloc, memcpy and friends are the
+// ones being measured, and glibc's would clash with them. These are the
+// few system calls it needs, made directly with int $0x80.
+
+#define HOST_STDOUT 1
+#define HOST_STDERR 2
+
+// Opens a file for reading and writing. Returns a negative errno on failure.
+int host_open(const char* path);
+
+bool host_pread(int fd, void* buf, uint32_t len, uint64_t offset);
+bool host_pwrite(int fd, const void* buf, uint32_t len, uint64_t offset);
+
+void host_write(int fd, const char* data, uint32_t len);
+
+// CLOCK_MONOTONIC in nanoseconds.
+uint64_t host_time_ns(void);
+
+void host_exit(int code) __attribute__((noreturn));
+
+// Formats like terminal_printf() (%c, %s, %d, %x) plus %u.
+void host_vprintf(int fd, const char* format, va_list args);
+void host_printf(const char* format, ...);
+
+// Entry point, called by _start.
+int main(int argc, char* argv[]);
+
+#endif // HOSTBENCH_HOST_H
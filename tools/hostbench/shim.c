@@ -0,0 +1,170 @@
+#include "shim.h"
+#include "host.h"
+#include "../../drivers/ide.h"
+#include "../../drivers/terminal.h"
+#include "../../memory/pmm.h"
+#include "../../fs/pagecache.h"
+#include "../../fs/fat32.h"
+#include "../../src/fpu.h"
+#include "../../src/taskpool.h"
+#include "../../src/trace.h"
+#include "../../lib/string.h"
+#include <stddef.h>
+
+#define SECTOR_SIZE 512
+
+static int disk_fd = -1;
+static shim_disk_stats_t disk_stats;
+
+static uint8_t arena[SHIM_ARENA_PAGES][PAGE_SIZE] __attribute__((aligned(PAGE_SIZE)));
+static uint32_t arena_next = 0;
+static void* free_pages = NULL;  // Freed pages, linked through their first word
+
+volatile bool trace_enabled = false;
+
+// --- Internal Helper Functions ---
+
+static void shim_fatal(const char* message, uint32_t value) {
+    host_printf("FATAL: %s %u\n", message, value);
+    host_exit(2);
+}
+
+// --- Public API Functions ---
+
+bool shim_disk_open(const char* path) {
+    disk_fd = host_open(path);
+    return disk_fd >= 0;
+}
+
+shim_disk_stats_t shim_disk_stats(void) {
+    return disk_stats;
+}
+
+// --- drivers/ide.h ---
+
+void ide_read_sectors(uint32_t lba, uint8_t count, uint8_t* buf) {
+    // The real driver treats a count of 0 as 256 sectors
+    uint32_t sectors = (count == 0) ? 256 : count;
+    if (!host_pread(disk_fd, buf, sectors * SECTOR_SIZE, (uint64_t)lba * SECTOR_SIZE)) {
+        shim_fatal("image read failed at LBA", lba);
+    }
+    disk_stats.reads++;
+    disk_stats.sectors_read += sectors;
+}
+
+void ide_write_sectors(uint32_t lba, uint8_t count, uint8_t* buf) {
+    uint32_t sectors = (count == 0) ? 256 : count;
+    if (!host_pwrite(disk_fd, buf, sectors * SECTOR_SIZE, (uint64_t)lba * SECTOR_SIZE)) {
+        shim_fatal("image write failed at LBA", lba);
+    }
+    disk_stats.writes++;
+    disk_stats.sectors_written += sectors;
+}
+
+// --- drivers/terminal.h ---
+
+void terminal_printf(const char* format, uint8_t color, ...) {
+    (void)color;
+    va_list args;
+    va_start(args, color);
+    host_vprintf(HOST_STDOUT, format, args);
+    va_end(args);
+}
+
+void terminal_writeerror(const char* format, ...) {
+    host_write(HOST_STDOUT, "ERROR: ", 7);
+    va_list args;
+    va_start(args, format);
+    host_vprintf(HOST_STDOUT, format, args);
+    va_end(args);
+    host_write(HOST_STDOUT, "\n", 1);
+}
+
+// --- memory/pmm.h ---
+
+void* pmm_alloc_page(void) {
+    if (free_pages != NULL) {
+        void* page = free_pages;
+        free_pages = *(void**)page;
+        return page;
+    }
+    // Fresh pages come out in address order, which heap_init() relies on
+    if (arena_next == SHIM_ARENA_PAGES) {
+        return NULL;
+    }
+    return arena[arena_next++];
+}
+
+void* pmm_alloc_zeroed_page(void) {
+    void* page = pmm_alloc_page();
+    if (page != NULL) {
+        memset(page, 0, PAGE_SIZE);
+    }
+    return page;
+}
+
+void pmm_free_page(void* ptr) {
+    *(void**)ptr = free_pages;
+    free_pages = ptr;
+}
+
+// --- fs/pagecache.h ---
+// No cache: every read goes to the disk, like a cold one in the kernel.
+
+uint32_t pagecache_read(uint32_t start_cluster, uint32_t file_size, uint32_t offset, void* buffer, uint32_t length) {
+    static uint8_t page[PAGE_SIZE];
+    uint32_t copied = 0;
+    if (offset >= file_size) {
+        return 0;
+    }
+    if (length > file_size - offset) {
+        length = file_size - offset;
+    }
+    while (copied < length) {
+        uint32_t position = offset + copied;
+        uint32_t in_page = position % PAGE_SIZE;
+        uint32_t chunk = PAGE_SIZE - in_page;
+        if (chunk > length - copied) {
+            chunk = length - copied;
+        }
+        if (!fat32_read_file_page(start_cluster, file_size, position / PAGE_SIZE, page)) {
+            break;
+        }
+        memcpy((uint8_t*)buffer + copied, page + in_page, chunk);
+        copied += chunk;
+    }
+    return copied;
+}
+
+void pagecache_invalidate(uint32_t start_cluster) {
+    (void)start_cluster;
+}
+
+// --- src/fpu.h ---
+
+uint32_t kernel_fpu_begin(void) {
+    return 0; // Linux saves our registers itself
+}
+
+void kernel_fpu_end(uint32_t flags) {
+    (void)flags;
+}
+
+// --- src/taskpool.h ---
+
+void parallel_for(uint32_t start, uint32_t end, uint32_t chunk,
+                  void (*fn)(uint32_t chunk_start, uint32_t chunk_end, void* arg), void* arg) {
+    for (uint32_t i = start; i < end; i += chunk) {
+        fn(i, (end - i > chunk) ? i + chunk : end, arg);
+    }
+}
+
+// --- src/trace.h ---
+
+void trace_write(uint16_t event, uint32_t a0, uint32_t a1, uint32_t a2, uint32_t a3) {
+    (void)event;
+    (void)a0;
+    (void)a1;
+    (void)a2;
+    (void)a3;
+}
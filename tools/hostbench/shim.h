@@ -0,0 +1,29 @@
+#ifndef HOSTBENCH_SHIM_H
+#define HOSTBENCH_SHIM_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+// --- Kernel Shims ---
+// Stand-ins for what fs/fat32.c, memory/heap.c and lib/string.c call
+// outside themselves: the IDE driver reads and writes a disk image file,
+// the PMM hands out pages from a static arena, and the terminal prints to
+// stdout. Everything runs on one thread, so parallel_for() runs its
+// chunks in order and the FPU needs no saving.
+
+#define SHIM_ARENA_PAGES 4096 // 16 MiB: the 8 MiB heap plus loose pages
+
+// Sector traffic through the IDE shim since the image was opened.
+typedef struct {
+    uint32_t reads;           // Calls
+    uint32_t writes;
+    uint32_t sectors_read;
+    uint32_t sectors_written;
+} shim_disk_stats_t;
+
+// Opens the FAT32 image the IDE shim serves. Returns false if it can't.
+bool shim_disk_open(const char* path);
+
+shim_disk_stats_t shim_disk_stats(void);
+
+#endif // HOSTBENCH_SHIM_H
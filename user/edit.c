@@ -13,9 +13,12 @@
 #define KEY_ARROW_LEFT  0x4B
 #define KEY_ARROW_RIGHT 0x4D
 
+#define KEY_TAG         1   // user_data of the get_key completion
+
 char buffer[ROWS][COLS];
 int cursor_x = 0;
 int cursor_y = 0;
+ioring_shared_t* ring = 0;
 
 void buffer_init() {
   for (int y = 0; y < ROWS; y++){
@@ -37,6 +40,32 @@ void editor_redraw() {
   set_cursor(cursor_x, cursor_y);
 }
 
+// Redraws the screen and waits for the next key with a single kernel
+// entry: the whole frame goes through the ring as one batch.
+int editor_redraw_ring() {
+  ioring_queue(ring, IORING_OP_CLEAR_SCREEN, 0, 0, 0, 0);
+  for (int y = 0; y < ROWS; y++) {
+    ioring_queue(ring, IORING_OP_SET_CURSOR, 0, y, 0, 0);
+    ioring_queue(ring, IORING_OP_WRITE, STDOUT, (uint32_t)buffer[y], COLS, 0);
+  }
+  ioring_queue(ring, IORING_OP_SET_CURSOR, cursor_x, cursor_y, 0, 0);
+  ioring_queue(ring, IORING_OP_WRITE, STDOUT, (uint32_t)"uwu", 3, 0);
+  ioring_queue(ring, IORING_OP_GET_KEY, 0, 0, 0, KEY_TAG);
+
+  uint32_t count = ioring_sq_pending(ring);
+  ring_enter(ring, count, count);
+
+  int key = 0;
+  ioring_cqe_t* cqe;
+  while ((cqe = ioring_peek_cqe(ring)) != 0) {
+    if (cqe->user_data == KEY_TAG) {
+      key = cqe->res;
+    }
+    ioring_cqe_seen(ring);
+  }
+  return key;
+}
+
 
 void editor_process_key(int key) {
     switch (key) {
@@ -85,10 +114,17 @@ void editor_process_key(int key) {
 void main(void) {
   buffer_init();
 
+  ring = ring_setup();
+
   while (1) {
-    editor_redraw();
-    write(1, "uwu", 3);
-    int key = get_key();
+    int key;
+    if (ring != 0) {
+      key = editor_redraw_ring();
+    } else {
+      editor_redraw();
+      write(1, "uwu", 3);
+      key = get_key();
+    }
     editor_process_key(key);
   }
 }
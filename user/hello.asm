@@ -1,5 +1,5 @@
 bits 32
-org 0x150000
+org 0x40000000
 
 section .text
     global _start
@@ -0,0 +1,46 @@
+#include "ioring.h"
+#include "syscalls.h"
+
+/**
+ * @brief Queues one operation in the submission queue.
+ * @details The kernel only reads the SQ during ring_enter(), so the entry is
+ * published right away.
+ * @return 1 on success, 0 if the SQ is full.
+ */
+int ioring_queue(ioring_shared_t* ring, uint32_t opcode, uint32_t a1, uint32_t a2, uint32_t a3, uint32_t user_data) {
+    uint32_t tail = ring->sq_tail;
+    if (tail - ring->sq_head >= IORING_SQ_ENTRIES) {
+        return 0;
+    }
+
+    ioring_sqe_t* sqe = &ring->sqes[tail % IORING_SQ_ENTRIES];
+    sqe->opcode = opcode;
+    sqe->args[0] = a1;
+    sqe->args[1] = a2;
+    sqe->args[2] = a3;
+    sqe->user_data = user_data;
+    ring->sq_tail = tail + 1;
+    return 1;
+}
+
+uint32_t ioring_sq_pending(ioring_shared_t* ring) {
+    return ring->sq_tail - ring->sq_head;
+}
+
+/**
+ * @brief Returns the oldest completion without consuming it.
+ * @return The completion, or NULL if the CQ is empty.
+ */
+ioring_cqe_t* ioring_peek_cqe(ioring_shared_t* ring) {
+    uint32_t head = ring->cq_head;
+    if (head == ring->cq_tail) {
+        return NULL;
+    }
+    // The kernel fills the entry before it moves cq_tail
+    asm volatile("" : : : "memory");
+    return &ring->cqes[head % IORING_CQ_ENTRIES];
+}
+
+void ioring_cqe_seen(ioring_shared_t* ring) {
+    ring->cq_head = ring->cq_head + 1;
+}
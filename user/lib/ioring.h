@@ -0,0 +1,63 @@
+#ifndef IORING_H
+#define IORING_H
+
+#include <stdint.h>
+#include "syscall_numbers.h"
+
+// --- Submission/Completion Rings ---
+// A page shared between a program and the kernel. The program queues
+// operations in the submission queue (SQ) and makes one SYS_ENTER_RING call
+// for the whole batch; results come back in the completion queue (CQ),
+// tagged with the 'user_data' of their submission.
+//
+// Reads and opens complete asynchronously on a kernel worker, so their
+// completions may arrive after later operations. Everything else runs in
+// submission order during the SYS_ENTER_RING call itself.
+
+#define IORING_SQ_ENTRIES 64
+#define IORING_CQ_ENTRIES 128
+
+// Operations take the same arguments as the syscall of the same number
+#define IORING_OP_READ         SYS_READ          // fd, buffer, count
+#define IORING_OP_WRITE        SYS_WRITE         // fd, buffer, count
+#define IORING_OP_OPEN         SYS_OPEN          // filename
+#define IORING_OP_CLEAR_SCREEN SYS_CLEAR_SCREEN
+#define IORING_OP_SET_CURSOR   SYS_SET_CURSOR    // x, y
+#define IORING_OP_GET_KEY      SYS_GET_KEY
+
+typedef struct {
+    uint32_t opcode;
+    uint32_t args[3];
+    uint32_t user_data;      // Copied to the completion as-is
+} ioring_sqe_t;
+
+typedef struct {
+    uint32_t user_data;
+    int32_t res;             // What the matching syscall would have returned
+} ioring_cqe_t;
+
+typedef struct {
+    volatile uint32_t sq_head;  // Next SQE the kernel takes (kernel writes)
+    volatile uint32_t sq_tail;  // One past the last queued SQE (program writes)
+    volatile uint32_t cq_head;  // Next CQE the program reads (program writes)
+    volatile uint32_t cq_tail;  // One past the last posted CQE (kernel writes)
+    ioring_sqe_t sqes[IORING_SQ_ENTRIES];
+    ioring_cqe_t cqes[IORING_CQ_ENTRIES];
+} ioring_shared_t;
+
+// --- Program-side helpers (user/lib/ioring.c) ---
+// ring_setup() and ring_enter() themselves are in syscalls.h.
+
+// Queues an operation. Returns 0 if the SQ is full, 1 otherwise.
+int ioring_queue(ioring_shared_t* ring, uint32_t opcode, uint32_t a1, uint32_t a2, uint32_t a3, uint32_t user_data);
+
+// Number of queued SQEs the kernel hasn't taken yet.
+uint32_t ioring_sq_pending(ioring_shared_t* ring);
+
+// Oldest unread completion, or NULL if there is none.
+ioring_cqe_t* ioring_peek_cqe(ioring_shared_t* ring);
+
+// Marks the completion returned by ioring_peek_cqe() as consumed.
+void ioring_cqe_seen(ioring_shared_t* ring);
+
+#endif // IORING_H
@@ -9,4 +9,13 @@
 #define SYS_CLEAR_SCREEN    6 // NEW
 #define SYS_SET_CURSOR      7 // NEW
 #define SYS_GET_KEY         12
+#define SYS_MMAP            90
+#define SYS_MUNMAP          91
+#define SYS_MSYNC           144
+#define SYS_CLOCK_GETTIME   265
+#define SYS_RING_SETUP      425
+#define SYS_ENTER_RING      426
+
+// Clock IDs for SYS_CLOCK_GETTIME
+#define CLOCK_MONOTONIC     1
 #endif
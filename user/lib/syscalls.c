@@ -1,7 +1,57 @@
 #include "syscalls.h"
 #include <stddef.h>
+#include <stdint.h>
 #include "syscall_numbers.h" // Assuming this file contains your SYS_* defines
 
+#define CPUID_EDX_SEP (1 << 11)
+
+// -1 until the first syscall checks the CPU, then 0 or 1
+static int sysenter_supported = -1;
+
+/**
+ * @brief Checks once whether the CPU has SYSENTER.
+ * @details Early Pentium Pros report the feature without supporting it.
+ */
+static int have_sysenter(void) {
+    if (sysenter_supported < 0) {
+        uint32_t eax, ebx, ecx, edx;
+        asm volatile("cpuid" : "=a"(eax), "=b"(ebx), "=c"(ecx), "=d"(edx) : "a"(1), "c"(0));
+        uint32_t family = (eax >> 8) & 0xF, model = (eax >> 4) & 0xF, stepping = eax & 0xF;
+        sysenter_supported = (edx & CPUID_EDX_SEP) && !(family == 6 && model < 3 && stepping < 3);
+    }
+    return sysenter_supported;
+}
+
+/**
+ * @brief Issues system call 'number' with up to three arguments.
+ * @details Uses SYSENTER when the CPU has it: arguments go in ebx, esi and
+ * edi, since SYSENTER itself needs ecx (our esp) and edx (where to return).
+ * Otherwise falls back to 'int $0x80' with arguments in ebx, ecx and edx.
+ * @return The value the kernel left in eax.
+ */
+static int syscall3(int number, uint32_t a1, uint32_t a2, uint32_t a3) {
+    int result;
+    if (have_sysenter()) {
+        asm volatile(
+            "mov %%esp, %%ecx\n\t"
+            "mov $1f, %%edx\n\t"
+            "sysenter\n"
+            "1:"
+            : "=a" (result)
+            : "a" (number), "b" (a1), "S" (a2), "D" (a3)
+            : "ecx", "edx", "memory"
+        );
+    } else {
+        asm volatile(
+            "int $0x80"
+            : "=a" (result)
+            : "a" (number), "b" (a1), "c" (a2), "d" (a3)
+            : "memory"
+        );
+    }
+    return result;
+}
+
 /**
  * @brief Issues a 'write' system call.
  * @param fd File descriptor (e.g., 1 for stdout).
@@ -10,17 +60,7 @@
  * @return The number of bytes written, or an error code.
  */
 int write(int fd, const void* buffer, size_t count) {
-    int result;
-    // We use specific register constraints ('a', 'b', 'c', 'd') to ensure
-    // the C variables are loaded into the correct registers (eax, ebx, ecx, edx)
-    // before the 'int $0x80' instruction is executed.
-    asm volatile (
-        "int $0x80"
-        : "=a" (result) // Output: the return value from the syscall goes into 'result'
-        : "a" (SYS_WRITE), "b" (fd), "c" (buffer), "d" (count) // Inputs
-        : "memory" // Clobber list: tells the compiler memory might be changed
-    );
-    return result;
+    return syscall3(SYS_WRITE, fd, (uint32_t)buffer, count);
 }
 
 /**
@@ -29,14 +69,7 @@ int write(int fd, const void* buffer, size_t count) {
  * @return A file descriptor on success, or an error code.
  */
 int open(const char* filename) {
-    int result;
-    asm volatile(
-        "int $0x80"
-        : "=a" (result)
-        : "a" (SYS_OPEN), "b" (filename)
-        : "memory"
-    );
-    return result;
+    return syscall3(SYS_OPEN, (uint32_t)filename, 0, 0);
 }
 
 /**
@@ -47,22 +80,14 @@ int open(const char* filename) {
  * @return The number of bytes read, or an error code.
  */
 int read(int fd, void* buffer, size_t count) {
-    int result;
-    asm volatile(
-        "int $0x80"
-        : "=a" (result)
-        : "a" (SYS_READ), "b" (fd), "c" (buffer), "d" (count)
-        : "memory"
-    );
-    return result;
+    return syscall3(SYS_READ, fd, (uint32_t)buffer, count);
 }
 
 /**
  * @brief Issues a 'clear_screen' system call.
  */
 void clear_screen(void) {
-    // No return value, so the output constraint is empty.
-    asm volatile("int $0x80" : : "a"(SYS_CLEAR_SCREEN));
+    syscall3(SYS_CLEAR_SCREEN, 0, 0, 0);
 }
 
 /**
@@ -71,20 +96,81 @@ void clear_screen(void) {
  * @param y The row for the cursor.
  */
 void set_cursor(int x, int y) {
-    asm volatile("int $0x80" : : "a"(SYS_SET_CURSOR), "b"(x), "c"(y));
+    syscall3(SYS_SET_CURSOR, x, y, 0);
 }
 
 /**
  * @brief Issues an 'exit' system call to terminate the current program.
 */
 void sys_exit(void) {
-    // We assume the syscall number for exit is 1. Make sure this matches
-    // your kernel's syscall handler.
-    asm volatile("int $0x80" : : "a"(SYS_EXIT));
+    syscall3(SYS_EXIT, 0, 0, 0);
 }
 
 int get_key(void) {
-  int key;
-  asm volatile("int $0x80" : "=a"(key) : "a"(SYS_GET_KEY));
-  return key;
+  return syscall3(SYS_GET_KEY, 0, 0, 0);
+}
+
+/**
+ * @brief Issues an 'mmap' system call.
+ * @details Pages are filled lazily on first access and are shared with the
+ * kernel's page cache, so nothing is copied up front. With fd -1 the
+ * mapping is anonymous, zero-filled memory that can be swapped out.
+ * @param fd File descriptor returned by open(), or -1 for anonymous memory.
+ * @param offset Page-aligned offset into the file (ignored when fd is -1).
+ * @param length Number of bytes to map (clamped to the end of the file).
+ * @return The address of the mapping, or NULL on failure.
+ */
+void* mmap(int fd, size_t offset, size_t length) {
+    return (void*)syscall3(SYS_MMAP, fd, offset, length);
+}
+
+/**
+ * @brief Issues a 'munmap' system call. Dirty pages are written back first.
+ * @param addr Address returned by mmap().
+ * @return 0 on success, -1 on error.
+ */
+int munmap(void* addr) {
+    return syscall3(SYS_MUNMAP, (uint32_t)addr, 0, 0);
+}
+
+/**
+ * @brief Issues an 'msync' system call to write modified pages back to disk.
+ * @param addr Start of the range to flush.
+ * @param length Length of the range in bytes.
+ * @return 0 on success, -1 on error.
+ */
+int msync(void* addr, size_t length) {
+    return syscall3(SYS_MSYNC, (uint32_t)addr, length, 0);
+}
+
+/**
+ * @brief Issues a 'clock_gettime' system call.
+ * @details The clock is TSC-based with nanosecond resolution where the CPU
+ * supports it, and counts from boot.
+ * @param clock_id Only CLOCK_MONOTONIC is supported.
+ * @param ts Receives the current time.
+ * @return 0 on success, -1 on error.
+ */
+int clock_gettime(int clock_id, struct timespec* ts) {
+    return syscall3(SYS_CLOCK_GETTIME, clock_id, (uint32_t)ts, 0);
+}
+
+/**
+ * @brief Creates a submission/completion ring shared with the kernel.
+ * @return The ring, or NULL on failure.
+ */
+ioring_shared_t* ring_setup(void) {
+    return (ioring_shared_t*)syscall3(SYS_RING_SETUP, 0, 0, 0);
+}
+
+/**
+ * @brief Submits queued operations and waits for completions.
+ * @param ring The ring returned by ring_setup().
+ * @param to_submit Maximum number of queued SQEs to submit.
+ * @param min_complete Completions to wait for before returning. The wait
+ * ends early if nothing is left in flight.
+ * @return The number of SQEs submitted, or -1 on error.
+ */
+int ring_enter(ioring_shared_t* ring, uint32_t to_submit, uint32_t min_complete) {
+    return syscall3(SYS_ENTER_RING, (uint32_t)ring, to_submit, min_complete);
 }
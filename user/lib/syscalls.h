@@ -2,6 +2,13 @@
 #define SYSCALLS_H
 
 #include <stddef.h> // For size_t
+#include "syscall_numbers.h" // For the CLOCK_* ids
+#include "ioring.h"
+
+struct timespec {
+    long tv_sec;
+    long tv_nsec;
+};
 
 // --- Function Prototypes for User-Space Programs ---
 
@@ -12,5 +19,11 @@ void clear_screen(void);
 void set_cursor(int x, int y);
 void exit(void); 
 int get_key(void);
+void* mmap(int fd, size_t offset, size_t length);
+int munmap(void* addr);
+int msync(void* addr, size_t length);
+int clock_gettime(int clock_id, struct timespec* ts);
+ioring_shared_t* ring_setup(void);
+int ring_enter(ioring_shared_t* ring, uint32_t to_submit, uint32_t min_complete);
 
 #endif // SYSCALLS_H